@@ -22,74 +22,205 @@
 /************************************************************************/
 /*  Construction for the PICxel class                                   */
 /************************************************************************/
-PICxel::PICxel(uint16_t num, uint8_t pin, color_mode_t colorMode) : numberOfLEDs(num), 
-pin(pin), colorArray(NULL), portSet(portOutputRegister(digitalPinToPort(pin)) + 2), 
+PICxel::PICxel(uint16_t num, uint8_t pin, color_mode_t colorMode) : pin(pin), 
+portSet(portOutputRegister(digitalPinToPort(pin)) + 2), 
 portClr(portOutputRegister(digitalPinToPort(pin)) + 1), 
-pinMask(digitalPinToBitMask(pin)), brightness(255), colorMode(colorMode){
+pinMask(digitalPinToBitMask(pin)), colorMode(colorMode), numberOfLEDs(num), brightness(255), 
+colorArray(NULL), allocatedArray(NULL), output(NULL), hsvCache(NULL), outputScale(256), 
+indexMap(NULL), indexSegments(NULL), numberOfSegments(0), tileLEDs(0), tileMirror(false), 
+numberOfPhysicalLEDs(0), timingMode(nopTiming), coreHz(F_CPU), powerLimit(false), greenSum(0), redSum(0), 
+blueSum(0){
   if(colorMode == GRB){
-    numberOfBytes = 3*num;
+    numberOfBytes = 3*(uint32_t)num;
     //uint8_t colorArray[3*num];    
     colorArray = (uint8_t*)calloc(numberOfBytes, sizeof(uint8_t));
   }
   else{
-    numberOfBytes = 4*num;
+    numberOfBytes = 4*(uint32_t)num;
     //uint8_t colorArray[4*num]; 
     colorArray = (uint8_t*)calloc(numberOfBytes, sizeof(uint8_t));
   } 
 
-  for(int i=0;i<numberOfBytes; i++)
-    colorArray[i] = 0;
+  allocatedArray = colorArray;
+  totalFrameBytes += numberOfBytes;
 }
 
 PICxel::PICxel(uint16_t num, uint8_t pin, color_mode_t colorMode, memory_mode_t memory_mode) : 
-  numberOfLEDs(num), pin(pin), colorArray(NULL), 
-  portSet(portOutputRegister(digitalPinToPort(pin)) + 2), 
+  pin(pin), portSet(portOutputRegister(digitalPinToPort(pin)) + 2), 
   portClr(portOutputRegister(digitalPinToPort(pin)) + 1), 
-  pinMask(digitalPinToBitMask(pin)), brightness(255), colorMode(colorMode){
+  pinMask(digitalPinToBitMask(pin)), colorMode(colorMode), numberOfLEDs(num), brightness(255), 
+  colorArray(NULL), allocatedArray(NULL), output(NULL), hsvCache(NULL), outputScale(256), 
+  indexMap(NULL), indexSegments(NULL), numberOfSegments(0), tileLEDs(0), tileMirror(false), 
+numberOfPhysicalLEDs(0), timingMode(nopTiming), coreHz(F_CPU), powerLimit(false), greenSum(0), redSum(0), 
+blueSum(0){
   
   if(colorMode == GRB && memory_mode == alloc){
-    numberOfBytes = 3*num;    
+    numberOfBytes = 3*(uint32_t)num;    
     colorArray = (uint8_t*)calloc(numberOfBytes, sizeof(uint8_t));
   }
   else if(colorMode == HSV && memory_mode == alloc){
-    numberOfBytes = 4*num;
+    numberOfBytes = 4*(uint32_t)num;
     colorArray = (uint8_t*)calloc(numberOfBytes, sizeof(uint8_t));
   } 
   else if(colorMode == GRB && memory_mode == noalloc){
-    numberOfBytes = 3*num;
+    numberOfBytes = 3*(uint32_t)num;
   } 
   else{ //(colorMode == GRB && memory_mode == noalloc)
-    numberOfBytes = 4*num;
+    numberOfBytes = 4*(uint32_t)num;
   } 
+
+  allocatedArray = colorArray;
+  totalFrameBytes += numberOfBytes;
 }
 
+uint32_t PICxel::totalFrameBytes = 0;
 
+/************************************************************************/
+/*  Points the strip at a colorArray it does not own.  The array must   */
+/*  hold getNumberOfBytes() bytes and outlive its use by the strip.     */
+/************************************************************************/
 void PICxel::setArrayPointer(uint8_t* colorPtr){
   colorArray = colorPtr;
 }
 
-
-
-
-
-
+/************************************************************************/
+/*  As above, but checks the size of the array first.  Returns false    */
+/*  and leaves the strip alone if bytes is too small for it.            */
+/************************************************************************/
+bool PICxel::setArrayPointer(uint8_t* colorPtr, uint32_t bytes){
+  if(colorPtr == NULL || bytes < numberOfBytes)
+    return false;
+  colorArray = colorPtr;
+  return true;
+}
 
 /************************************************************************/
-/*  Destructor for the PICxel class                                     */
+/*  Destructor for the PICxel class.  Frees the colorArray allocated by */
+/*  the constructor, even if the strip has since been pointed at        */
+/*  another array.  Arrays passed to setArrayPointer() are never freed. */
 /************************************************************************/
 PICxel::~PICxel(){
+  free(allocatedArray);
+  totalFrameBytes -= numberOfBytes;
 }
 
 /************************************************************************/
-/*  Sets the pinMode for selected pin                                   */
+/*  Sets the pinMode for selected pin and picks the bit timing for the  */
+/*  compiled F_CPU.  Returns false when F_CPU is too slow for the LEDs, */
+/*  refreshLEDs() then sends nothing.                                   */
 /************************************************************************/
-void PICxel::begin(){
+bool PICxel::begin(){
   //let MPIDE handle the tri-state buffer and 
   //assign analog inputs as needed
   pinMode(pin, OUTPUT);
   
   //clear the pin
   *portClr = pinMask;
+
+  return recalibrate(F_CPU);
+}
+
+/************************************************************************/
+/*  As above, then prints the colorArray bytes of this strip and of     */
+/*  every strip that exists, so the framebuffer total is on the port at */
+/*  startup:                                                            */
+/*    # strip 60 LEDs, 180 bytes, framebuffers 300 bytes in all strips  */
+/************************************************************************/
+bool PICxel::begin(Print &out){
+  bool timing = begin();
+
+  out.print("# strip ");
+  out.print((unsigned long)numberOfLEDs);
+  out.print(" LEDs, ");
+  out.print((unsigned long)numberOfBytes);
+  out.print(" bytes, framebuffers ");
+  out.print((unsigned long)totalFrameBytes);
+  out.print(" bytes in all strips");
+  out.println(timing ? "" : ", clock too slow");
+  return timing;
+}
+
+/************************************************************************/
+/*  Picks the bit timing for a core running at cpuHz.  Call this after  */
+/*  changing the core clock at runtime.  The core timer always ticks at */
+/*  half the core clock, so it cannot tell the clock rate itself, the   */
+/*  caller passes it in.                                                */
+/*                                                                      */
+/*  When cpuHz is the compiled F_CPU and there is a nop table for it    */
+/*  the nop delays are used.  Otherwise the cost of a delay loop        */
+/*  iteration and the overhead of each bit are measured with the core   */
+/*  timer, by sending bytes with an empty pin mask so the pin does not  */
+/*  move, and loop counts are worked out for the PICXEL_LOOP_*_NS       */
+/*  times.  If the overhead alone is longer than the longest T0H the    */
+/*  LEDs accept, the clock is too slow and refreshLEDs() sends nothing. */
+/*  Returns false in that case.                                         */
+/************************************************************************/
+bool PICxel::recalibrate(uint32_t cpuHz){
+  coreHz = cpuHz;
+#ifdef PICXEL_NOP_DELAYS
+  if(cpuHz == F_CPU){
+    timingMode = nopTiming;
+    return true;
+  }
+#endif
+
+  const uint32_t calibrationLoops = 1000;
+  const uint32_t calibrationBytes = 8;
+  static const uint32_t zeroCounts[4] = {0, 0, 0, 0};
+  uint32_t interruptBits, start;
+  uint32_t loopTicks, zeroTicks, oneTicks;
+
+  interruptBits = disableInterrupts();
+
+  start = ReadCoreTimer();
+  GRBloopDelay(calibrationLoops);
+  loopTicks = ReadCoreTimer() - start;
+
+  start = ReadCoreTimer();
+  for(uint32_t i = 0; i < calibrationBytes; i++)
+    GRBsendByteLoop(portSet, portClr, 0, 0x00, zeroCounts);
+  zeroTicks = ReadCoreTimer() - start;
+
+  start = ReadCoreTimer();
+  for(uint32_t i = 0; i < calibrationBytes; i++)
+    GRBsendByteLoop(portSet, portClr, 0, 0xFF, zeroCounts);
+  oneTicks = ReadCoreTimer() - start;
+
+  restoreInterrupts(interruptBits);
+
+  //core clock cycles, the core timer counts every other cycle
+  uint32_t loopCycles256 = (loopTicks*2*256)/calibrationLoops;
+  uint32_t zeroBitCycles = (zeroTicks*2)/(8*calibrationBytes);
+  uint32_t oneBitCycles = (oneTicks*2)/(8*calibrationBytes);
+  if(loopCycles256 == 0)
+    loopCycles256 = 256;
+
+  //the overhead is taken as split evenly between the high and low part
+  uint32_t overhead[4] = {zeroBitCycles/2, zeroBitCycles - zeroBitCycles/2,
+    oneBitCycles/2, oneBitCycles - oneBitCycles/2};
+  static const uint32_t targetNs[4] = {PICXEL_LOOP_T0H_NS, PICXEL_LOOP_T0L_NS,
+    PICXEL_LOOP_T1H_NS, PICXEL_LOOP_T1L_NS};
+
+  if((uint64_t)overhead[PICXEL_T0H]*1000000000ULL > (uint64_t)PICXEL_LOOP_T0H_MAX_NS*cpuHz){
+    timingMode = timingTooSlow;
+    return false;
+  }
+
+  for(uint8_t i = 0; i < 4; i++){
+    uint32_t cycles = ((uint64_t)targetNs[i]*cpuHz)/1000000000ULL;
+    loopCounts[i] = (cycles > overhead[i]) ? ((cycles - overhead[i])*256)/loopCycles256 : 0;
+  }
+
+  timingMode = loopTiming;
+  return true;
+}
+
+/************************************************************************/
+/*  Returns the bit timing in use: nop tables, calibrated delay loops,  */
+/*  or none because the core clock is too slow for the LEDs             */
+/************************************************************************/
+timing_mode_t PICxel::getTimingMode(void){
+  return timingMode;
 }
 
 /************************************************************************/
@@ -97,6 +228,7 @@ void PICxel::begin(){
 /************************************************************************/
 void PICxel::clear(){
   uint8_t* arrayPtr = colorArray;
+  greenSum = redSum = blueSum = 0;
   if(colorMode == GRB)
     for(int i=0; i < numberOfLEDs*3; i++)
       arrayPtr[i] = 0;
@@ -109,6 +241,8 @@ void PICxel::clear(){
 /*  Clears the LED in the colorArray                                    */
 /************************************************************************/
 void PICxel::clear(uint8_t num){
+  if(powerLimit)
+    powerLED(num, -1);
   if(colorMode == GRB){
     colorArray[(num*3)+0] = 0;
     colorArray[(num*3)+1] = 0;
@@ -140,10 +274,14 @@ void PICxel::GRBsetLEDColor(uint16_t number, uint8_t green, uint8_t red, uint8_t
     green = ((green*brightness) >> 8);
     blue = ((blue*brightness) >> 8);
     
+    if(powerLimit)
+      powerLED(number, -1);
     uint8_t *arrayPtr = &colorArray[number*3];
     arrayPtr[0] = green;
     arrayPtr[1] = red;
     arrayPtr[2] = blue;
+    if(powerLimit)
+      powerLED(number, 1);
   }
 }
 
@@ -152,26 +290,30 @@ void PICxel::GRBsetLEDColor(uint16_t number, uint8_t green, uint8_t red, uint8_t
 /*  value. color is a 32-bit unsigned int that is organized into four   */
 /*  bytes:                                                              */
 /*  bits[31 - 24][23 - 16][15 - 8][7 - 0]                               */
-/*      ( blank )(  red  )(green )(blue )                               */
+/*      ( blank )( green )( red  )(blue )                               */
+/*                                                                      */
+/*  This is the order the library has always read, kept so existing     */
+/*  sketches show the same colors.  Colors from HSVToColor(), and other */
+/*  0x00RRGGBB colors, go through setLEDColorRGB().                     */
 /*                                                                      */
 /*  Each color is scaled by the brightness value and stored in the      */
 /*  color array.                                                        */
 /************************************************************************/
 void PICxel::GRBsetLEDColor(uint16_t number, uint32_t color){
-  if(number < numberOfLEDs){
-    uint32_t red   = (uint8_t)(color >> 8);
-    uint32_t green = (uint8_t)(color >> 16);
-    uint32_t blue  = (uint8_t)(color);
-    
-    red   = (red   * brightness) >> 8;
-    green = (green * brightness) >> 8;
-    blue  = (blue  * brightness) >> 8;
-    
-    uint8_t *arrayPtr = &colorArray[number*3];
-    arrayPtr[0] = green;
-    arrayPtr[1] = red;
-    arrayPtr[2] = blue; 
-  } 
+  GRBsetLEDColor(number, (uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color);
+}
+
+/************************************************************************/
+/*  Modifies the color matrix with a 0x00RRGGBB color, the layout       */
+/*  HSVToColor() returns:                                               */
+/*  bits[31 - 24][23 - 16][15 - 8][7 - 0]                               */
+/*      ( blank )(  red  )(green )(blue )                               */
+/*                                                                      */
+/*  Each color is scaled by the brightness value and stored in the      */
+/*  color array.                                                        */
+/************************************************************************/
+void PICxel::setLEDColorRGB(uint16_t number, uint32_t color){
+  GRBsetLEDColor(number, (uint8_t)(color >> 8), (uint8_t)(color >> 16), (uint8_t)color);
 }
 
 /************************************************************************/
@@ -184,11 +326,15 @@ void PICxel::GRBsetLEDColor(uint16_t number, uint32_t color){
 /************************************************************************/
 void PICxel::HSVsetLEDColor(uint16_t number, uint16_t hue, uint8_t sat, uint8_t val){
   if(number < numberOfLEDs){
+    if(powerLimit)
+      powerLED(number, -1);
     uint8_t *arrayPtr = &colorArray[number*4];
     arrayPtr[0] = hue;
     arrayPtr[1] = hue >> 8;
     arrayPtr[2] = sat;
     arrayPtr[3] = val;
+    if(powerLimit)
+      powerLED(number, 1);
   }
 }
 
@@ -206,20 +352,240 @@ void PICxel::HSVsetLEDColor(uint16_t number, uint16_t hue, uint8_t sat, uint8_t
 /************************************************************************/
 void PICxel::HSVsetLEDColor(uint16_t number, uint32_t color){
   if(number < numberOfLEDs){
+    if(powerLimit)
+      powerLED(number, -1);
     uint8_t *arrayPtr = &colorArray[number*4];
     arrayPtr[0] = color;
     arrayPtr[1] = color >> 8;
     arrayPtr[2] = color >> 16;
     arrayPtr[3] = color >> 24;
+    if(powerLimit)
+      powerLED(number, 1);
+  }
+}
+
+/************************************************************************/
+/*  Layout of each 256 hue sextant of the color wheel as colorArray     */
+/*  byte offsets (0 green, 1 red, 2 blue): the channel that ramps, the  */
+/*  one at full chroma and the one at the minimum.  The ramp rises in   */
+/*  even sextants and falls in odd ones, as in HSVToColorReference().   */
+/************************************************************************/
+static const uint8_t sextantLayout[6][3] = {
+  {0, 1, 2}, {1, 0, 2}, {2, 0, 1}, {0, 2, 1}, {1, 2, 0}, {2, 1, 0}};
+
+//the color wheel in 16.16 hue
+#define PICXEL_HUE_WHEEL (1536L << 16)
+
+/************************************************************************/
+/*  Fills count LEDs from first with a rainbow.  hue is the hue of the  */
+/*  first LED and hueStep is added for each next LED in 16.16 fixed     */
+/*  point, so a full wheel over the range is (1536L << 16)/count and a  */
+/*  negative step runs the other way.                                   */
+/*                                                                      */
+/*  A GRB strip gets the colors HSVToColor() gives, scaled by the       */
+/*  brightness as GRBsetLEDColor() does, an HSV strip gets the HSV      */
+/*  words.                                                              */
+/************************************************************************/
+void PICxel::fillRainbow(uint16_t first, uint16_t count, uint16_t hue, int32_t hueStep, uint8_t sat, uint8_t val){
+  fillHSV(first, count, (int32_t)(hue % 1536) << 16, hueStep, (int32_t)sat << 16, 0,
+    (int32_t)val << 16, 0);
+}
+
+/************************************************************************/
+/*  Fills count LEDs from first with a gradient between two HSV colors  */
+/*  packed as for HSVsetLEDColor().  The hue takes the short way around */
+/*  the wheel, saturation and value are interpolated linearly, and the  */
+/*  first and last LED get the two colors.                              */
+/************************************************************************/
+void PICxel::fillGradientHSV(uint16_t first, uint16_t count, uint32_t startHSV, uint32_t endHSV){
+  int32_t hue = (startHSV & 0xFFFF) % 1536;
+  int32_t hueSpan = (int32_t)((endHSV & 0xFFFF) % 1536) - hue;
+  int32_t satSpan = (int32_t)((endHSV >> 16) & 0xFF) - (int32_t)((startHSV >> 16) & 0xFF);
+  int32_t valSpan = (int32_t)(endHSV >> 24) - (int32_t)(startHSV >> 24);
+  int32_t steps = (count > 1) ? count - 1 : 1;
+
+  if(hueSpan > 768)
+    hueSpan -= 1536;
+  else if(hueSpan < -768)
+    hueSpan += 1536;
+
+  //the half added to each start rounds every LED to the nearest value,
+  //the spans may be negative so they are scaled by a multiply
+  fillHSV(first, count, (hue << 16) + 0x8000, hueSpan*65536/steps,
+    (int32_t)((startHSV >> 16) & 0xFF) << 16 | 0x8000, satSpan*65536/steps,
+    (int32_t)(startHSV >> 24) << 16 | 0x8000, valSpan*65536/steps);
+}
+
+/************************************************************************/
+/*  Fills count LEDs from first with a linear gradient between two      */
+/*  0x00RRGGBB colors, as for setLEDColorRGB(), scaled by the           */
+/*  brightness.  GRB strips only, an HSV strip is left unchanged.       */
+/************************************************************************/
+void PICxel::fillGradientRGB(uint16_t first, uint16_t count, uint32_t startColor, uint32_t endColor){
+  if(colorMode != GRB || first >= numberOfLEDs || count == 0)
+    return;
+  if(count > numberOfLEDs - first)
+    count = numberOfLEDs - first;
+
+  int32_t steps = (count > 1) ? count - 1 : 1;
+  int32_t startRed = (startColor >> 16) & 0xFF;
+  int32_t startGreen = (startColor >> 8) & 0xFF;
+  int32_t startBlue = startColor & 0xFF;
+  int32_t redStep = (((int32_t)(endColor >> 16) & 0xFF) - startRed)*65536/steps;
+  int32_t greenStep = (((int32_t)(endColor >> 8) & 0xFF) - startGreen)*65536/steps;
+  int32_t blueStep = (((int32_t)endColor & 0xFF) - startBlue)*65536/steps;
+  //the half added to each start rounds every LED to the nearest value
+  int32_t red = startRed << 16 | 0x8000;
+  int32_t green = startGreen << 16 | 0x8000;
+  int32_t blue = startBlue << 16 | 0x8000;
+  uint8_t *arrayPtr = &colorArray[3*first];
+
+  beginPowerUpdate(first, count);
+  for(uint16_t i = 0; i < count; i++){
+    arrayPtr[0] = ((green >> 16)*brightness) >> 8;
+    arrayPtr[1] = ((red >> 16)*brightness) >> 8;
+    arrayPtr[2] = ((blue >> 16)*brightness) >> 8;
+    arrayPtr += 3;
+    red += redStep;
+    green += greenStep;
+    blue += blueStep;
+  }
+  endPowerUpdate(first, count);
+}
+
+/************************************************************************/
+/*  Kernel behind the fills.  Hue, saturation and value start at the    */
+/*  given 16.16 values and step per LED.  For a GRB strip the hue is    */
+/*  walked one sextant at a time: how many LEDs stay in the sextant is  */
+/*  worked out on entry, and inside it two channels only change with    */
+/*  saturation and value while the third is a single multiply of the   */
+/*  hue, so the sextant search and setup of HSVToColor() are done once  */
+/*  per sextant rather than per LED.                                    */
+/************************************************************************/
+void PICxel::fillHSV(uint16_t first, uint16_t count, int32_t hue, int32_t hueStep,
+    int32_t sat, int32_t satStep, int32_t val, int32_t valStep){
+  if(first >= numberOfLEDs || count == 0)
+    return;
+  if(count > numberOfLEDs - first)
+    count = numberOfLEDs - first;
+
+  //a step of more than a wheel lands where the remainder does
+  hueStep %= PICXEL_HUE_WHEEL;
+  uint16_t total = count;
+  beginPowerUpdate(first, total);
+
+  if(colorMode == HSV){
+    uint8_t *arrayPtr = &colorArray[4*first];
+    for(uint16_t i = 0; i < count; i++){
+      arrayPtr[0] = hue >> 16;
+      arrayPtr[1] = hue >> 24;
+      arrayPtr[2] = sat >> 16;
+      arrayPtr[3] = val >> 16;
+      arrayPtr += 4;
+      hue += hueStep;
+      if(hue >= PICXEL_HUE_WHEEL)
+        hue -= PICXEL_HUE_WHEEL;
+      else if(hue < 0)
+        hue += PICXEL_HUE_WHEEL;
+      sat += satStep;
+      val += valStep;
+    }
+    endPowerUpdate(first, total);
+    return;
+  }
+
+  uint8_t *arrayPtr = &colorArray[3*first];
+  bool fixedColor = (satStep == 0 && valStep == 0);
+  uint32_t chroma = 0, m = 0, full = 0, low = 0;
+
+  if(fixedColor){
+    uint32_t s = (sat >> 16) + 1;
+    uint32_t v = (val >> 16) + 1;
+    chroma = (v*s) >> 8;
+    m = v - chroma;
+    full = ((v - 1)*brightness) >> 8;
+    low = (m*brightness) >> 8;
+  }
+
+  while(count){
+    uint32_t sextant = (uint32_t)hue >> 24;
+    const uint8_t *layout = sextantLayout[sextant];
+    //255 - h in the falling sextants
+    uint32_t falling = (sextant & 1) ? 0xFF : 0;
+    uint32_t run = count;
+
+    if(hueStep > 0){
+      uint32_t left = ((sextant + 1) << 24) - (uint32_t)hue;
+      uint32_t n = (left + hueStep - 1)/(uint32_t)hueStep;
+      if(n < run)
+        run = n;
+    }
+    else if(hueStep < 0){
+      uint32_t n = ((uint32_t)hue - (sextant << 24))/(uint32_t)-hueStep + 1;
+      if(n < run)
+        run = n;
+    }
+    count -= run;
+
+    while(run--){
+      if(!fixedColor){
+        uint32_t s = (sat >> 16) + 1;
+        uint32_t v = (val >> 16) + 1;
+        chroma = (v*s) >> 8;
+        m = v - chroma;
+        full = ((v - 1)*brightness) >> 8;
+        low = (m*brightness) >> 8;
+        sat += satStep;
+        val += valStep;
+      }
+      uint32_t ramp = (((chroma*((((uint32_t)hue >> 16) & 0xFF) ^ falling)) >> 8) + m) & 0xFF;
+      arrayPtr[layout[0]] = (ramp*brightness) >> 8;
+      arrayPtr[layout[1]] = full;
+      arrayPtr[layout[2]] = low;
+      arrayPtr += 3;
+      hue += hueStep;
+    }
+
+    if(hue >= PICXEL_HUE_WHEEL)
+      hue -= PICXEL_HUE_WHEEL;
+    else if(hue < 0)
+      hue += PICXEL_HUE_WHEEL;
   }
+
+  endPowerUpdate(first, total);
 }
 
 /************************************************************************/
 /*  Refreshed the LED strip with either GRBrefreshLEDs() or             */
-/*  HSVrefreshLEDs() dependent on which color mode to use               */
+/*  HSVrefreshLEDs() dependent on which color mode to use, or with      */
+/*  stagedRefreshLEDs() when an index map is set, the power limit has   */
+/*  to scale the output or the bit timing uses delay loops.  A backend  */
+/*  set with setOutput() takes over the whole refresh.                  */
+/*                                                                      */
+/*  Without a backend, nothing is sent while getTimingMode() returns    */
+/*  timingTooSlow and the LEDs keep their last frame.  begin() and      */
+/*  recalibrate() return false when they leave the strip in that mode,  */
+/*  so check what they return at unusual clocks.  There is no safe      */
+/*  fallback, the nop tables are only right at their own clock: raise   */
+/*  the clock or use a DMA backend such as PICxelOC.                    */
 /************************************************************************/
 void PICxel::refreshLEDs(void){
-  if(colorMode == GRB)
+  PICXEL_TRACE(PICXEL_TRACE_REFRESH_START, 0);
+  outputScale = getPowerScale();
+  if(output != NULL)
+  {
+    //the backend generates its own timing
+    output->refreshLEDs(*this);
+    return;
+  }
+
+  //a corrupted stream is worse than none
+  if(timingMode == timingTooSlow)
+    return;
+
+  if(hasIndexMap() || outputScale < 256 || timingMode == loopTiming)
+    stagedRefreshLEDs();
+  else if(colorMode == GRB)
     GRBrefreshLEDs();
   else
     HSVrefreshLEDs();
@@ -244,8 +610,9 @@ void PICxel::GRBrefreshLEDs(void){
     
   /* Disable interrupts, but save current bits so we can restore them later */
   interruptBits = disableInterrupts();
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_OFF, 0);
     
-  for(int j = 0; j < numberOfBytes; j++)
+  for(uint32_t j = 0; j < numberOfBytes; j++)
   {
     bitSelect = 0x80;
         
@@ -271,7 +638,494 @@ void PICxel::GRBrefreshLEDs(void){
   }
   
   /* Restore the interrupts now */
+  PICXEL_TRACE(PICXEL_TRACE_LAST_BIT, 0);
   restoreInterrupts(interruptBits);
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_ON, 0);
+}
+
+/************************************************************************/
+/*  Sets a physical to logical index map that the refresh follows, so   */
+/*  effects can write the colorArray in order while the strip is wired  */
+/*  reversed, serpentine or with gaps.  map[i] is the logical LED sent  */
+/*  to physical LED i, or PICXEL_NO_LED to send it dark.  The map is    */
+/*  not copied and may be a const array in flash.                       */
+/************************************************************************/
+void PICxel::setIndexMap(const uint16_t *map, uint16_t physicalLEDs){
+  indexSegments = NULL;
+  numberOfSegments = 0;
+  tileLEDs = 0;
+  indexMap = map;
+  numberOfPhysicalLEDs = physicalLEDs;
+}
+
+/************************************************************************/
+/*  Sets the index map as a list of runs, which is far smaller than a   */
+/*  table when the wiring is made of long straight runs.  The physical  */
+/*  strip is the runs placed end to end.  Returns false, leaving the    */
+/*  map as it was, if a run is empty or the runs add up to more than    */
+/*  65535 LEDs.                                                         */
+/************************************************************************/
+bool PICxel::setIndexMap(const picxel_segment_t *segments, uint8_t numSegments){
+  uint32_t physicalLEDs = 0;
+
+  for(uint8_t i = 0; i < numSegments; i++){
+    if(segments[i].length == 0)
+      return false;
+    physicalLEDs += segments[i].length;
+  }
+  if(physicalLEDs > 0xFFFF)
+    return false;
+
+  indexMap = NULL;
+  indexSegments = segments;
+  numberOfSegments = numSegments;
+  tileLEDs = 0;
+  numberOfPhysicalLEDs = physicalLEDs;
+  return true;
+}
+
+/************************************************************************/
+/*  Sends the colorArray over and over until physicalLEDs have been     */
+/*  sent, the last copy cut short if it does not fit.  With mirror set  */
+/*  every second copy is reversed, so a strip of twice the LEDs is the  */
+/*  colorArray and its reflection.  Effects and the colorArray only     */
+/*  cover one copy, the power limit counts every copy.  Replaces any    */
+/*  index map.                                                          */
+/************************************************************************/
+void PICxel::setTiling(uint16_t physicalLEDs, bool mirror){
+  indexMap = NULL;
+  indexSegments = NULL;
+  numberOfSegments = 0;
+  tileLEDs = numberOfLEDs;
+  tileMirror = mirror;
+  numberOfPhysicalLEDs = physicalLEDs;
+  if(tileLEDs == 0)
+    numberOfPhysicalLEDs = 0;
+}
+
+/************************************************************************/
+/*  Removes the index map or tiling, the refresh goes back to           */
+/*  colorArray order                                                    */
+/************************************************************************/
+void PICxel::clearIndexMap(void){
+  indexMap = NULL;
+  indexSegments = NULL;
+  numberOfSegments = 0;
+  tileLEDs = 0;
+  numberOfPhysicalLEDs = 0;
+}
+
+/************************************************************************/
+/*  Returns true when the refresh follows an index map or tiling        */
+/************************************************************************/
+bool PICxel::hasIndexMap(void){
+  return indexMap != NULL || indexSegments != NULL || tileLEDs != 0;
+}
+
+/************************************************************************/
+/*  Returns true when refreshLEDs() may go through stagedRefreshLEDs()  */
+/*  instead of sending the colorArray as is                             */
+/************************************************************************/
+bool PICxel::hasOutputStage(void){
+  return hasIndexMap() || powerLimit || timingMode != nopTiming || output != NULL;
+}
+
+/************************************************************************/
+/*  Makes the output stage and the power estimator of an HSV strip look */
+/*  colors up in cache instead of converting every LED.  Pays off when  */
+/*  frames hold few distinct colors, the direct refresh of an HSV strip */
+/*  converts while sending and does not use it.  NULL turns it off.     */
+/************************************************************************/
+void PICxel::setHSVCache(PICxelHSVCache *cache){
+  hsvCache = cache;
+}
+
+/************************************************************************/
+/*  Hands refreshLEDs() to a backend such as PICxelOC that generates    */
+/*  the waveform in hardware.  The backend reads the strip through      */
+/*  getOutputLength() and fillOutputBytes().  NULL restores the bit     */
+/*  banged output.                                                      */
+/************************************************************************/
+void PICxel::setOutput(PICxelOutput *output){
+  this->output = output;
+}
+
+/************************************************************************/
+/*  Returns the number of LEDs on the wire, the physical LED count of   */
+/*  the index map or the LED count when there is no map                 */
+/************************************************************************/
+uint16_t PICxel::getOutputLength(void){
+  return hasIndexMap() ? numberOfPhysicalLEDs : numberOfLEDs;
+}
+
+/************************************************************************/
+/*  Writes the wire bytes (green, red, blue) of count physical LEDs,    */
+/*  starting at first, into out.  The index map, HSV conversion and     */
+/*  power limit are applied exactly as in stagedRefreshLEDs(), so a     */
+/*  backend can build its output in chunks.                             */
+/************************************************************************/
+void PICxel::fillOutputBytes(uint8_t *out, uint16_t first, uint16_t count){
+  uint8_t segment = 0;
+  uint16_t segmentLeft = 0;
+  uint16_t logical = 0;
+  int16_t step = 0;
+
+  //backends driving several strips do not go through refreshLEDs()
+  outputScale = getPowerScale();
+
+  //find the segment holding the first LED
+  if(indexMap == NULL && indexSegments != NULL)
+  {
+    uint16_t skip = first;
+    while(segment < numberOfSegments && skip >= indexSegments[segment].length)
+      skip -= indexSegments[segment++].length;
+    if(segment < numberOfSegments)
+    {
+      logical = indexSegments[segment].start;
+      step = indexSegments[segment].step;
+      if(logical != PICXEL_NO_LED)
+        logical += step*skip;
+      segmentLeft = indexSegments[segment].length - skip;
+      segment++;
+    }
+  }
+  else if(tileLEDs != 0)
+  {
+    //the only division, the loop steps through the copies
+    uint16_t skip = first % tileLEDs;
+    step = (tileMirror && (first / tileLEDs) & 1) ? -1 : 1;
+    logical = (step > 0) ? skip : tileLEDs - 1 - skip;
+    segmentLeft = tileLEDs - skip;
+  }
+
+  for(uint32_t i = first; i < (uint32_t)first + count; i++)
+  {
+    uint32_t color;
+
+    if(indexMap != NULL)
+    {
+      logical = indexMap[i];
+    }
+    else if(tileLEDs != 0)
+    {
+      if(i != first)
+      {
+        if(segmentLeft == 0)
+        {
+          nextTile(logical, step);
+          segmentLeft = tileLEDs;
+        }
+        else
+        {
+          logical += step;
+        }
+      }
+      segmentLeft--;
+    }
+    else if(indexSegments == NULL)
+    {
+      logical = i;
+    }
+    else
+    {
+      if(i != first)
+      {
+        if(segmentLeft == 0)
+        {
+          logical = indexSegments[segment].start;
+          segmentLeft = indexSegments[segment].length;
+          step = indexSegments[segment].step;
+          segment++;
+        }
+        else if(logical != PICXEL_NO_LED)
+        {
+          logical += step;
+        }
+      }
+      segmentLeft--;
+    }
+
+    color = outputColor(logical);
+    *out++ = color >> 8;
+    *out++ = color >> 16;
+    *out++ = color;
+  }
+}
+
+/************************************************************************/
+/*  Moves to the first LED of the next copy of a tiled strip.  A step   */
+/*  of 0 is before the first copy, which always runs forward.           */
+/************************************************************************/
+inline void PICxel::nextTile(uint16_t &logical, int16_t &step){
+  if(tileMirror && step > 0)
+  {
+    logical = tileLEDs - 1;
+    step = -1;
+  }
+  else
+  {
+    logical = 0;
+    step = 1;
+  }
+}
+
+/************************************************************************/
+/*  Returns the color sent for a logical LED as (blank)(red)(green)     */
+/*  (blue), with HSV converted and the power limit scale applied.       */
+/*  Unmapped and out of range LEDs are black.                           */
+/************************************************************************/
+inline uint32_t PICxel::outputColor(uint16_t logical){
+  uint16_t scale = outputScale;
+  uint8_t green, red, blue;
+
+  if(logical >= numberOfLEDs)
+    return 0;
+
+  if(colorMode == GRB)
+  {
+    uint8_t *arrayPtr = &colorArray[logical*3];
+    green = arrayPtr[0];
+    red = arrayPtr[1];
+    blue = arrayPtr[2];
+  }
+  else
+  {
+    uint8_t *arrayPtr = &colorArray[logical*4];
+    uint32_t HSV = arrayPtr[0] | arrayPtr[1] << 8 | arrayPtr[2] << 16 | arrayPtr[3] << 24;
+    uint32_t color = 0;
+    //a value of zero is off, as in HSVrefreshLEDs()
+    if(hsvCache != NULL)
+      color = hsvCache->lookup(HSV);
+    else if(arrayPtr[3])
+      color = HSVToColor(HSV);
+    green = color >> 8;
+    red = color >> 16;
+    blue = color;
+  }
+
+  //a scale of 256 leaves the color unchanged
+  green = (green*scale) >> 8;
+  red = (red*scale) >> 8;
+  blue = (blue*scale) >> 8;
+
+  return (uint32_t)red << 16 | (uint32_t)green << 8 | blue;
+}
+
+/************************************************************************/
+/*  Generate the datastream through the output stage.  The next LED is  */
+/*  looked up through the index map, converted with HSVToColor() in HSV */
+/*  mode and scaled by the power limit between LEDs while the data line */
+/*  is low, which only stretches the low time of the last bit of each   */
+/*  LED.                                                                */
+/************************************************************************/
+void PICxel::stagedRefreshLEDs(void){
+  uint32_t interruptBits;
+  uint8_t segment = 0;
+  uint16_t segmentLeft = 0;
+  uint16_t logical = 0;
+  int16_t step = 0;
+  uint16_t count = getOutputLength();
+  uint32_t color;
+  uint8_t green, red, blue;
+
+  /* Disable interrupts, but save current bits so we can restore them later */
+  interruptBits = disableInterrupts();
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_OFF, 0);
+
+  for(uint16_t i = 0; i < count; i++)
+  {
+    if(indexMap != NULL)
+    {
+      logical = indexMap[i];
+    }
+    else if(tileLEDs != 0)
+    {
+      if(segmentLeft == 0)
+      {
+        nextTile(logical, step);
+        segmentLeft = tileLEDs;
+      }
+      else
+      {
+        logical += step;
+      }
+      segmentLeft--;
+    }
+    else if(indexSegments == NULL)
+    {
+      logical = i;
+    }
+    else
+    {
+      if(segmentLeft == 0)
+      {
+        logical = indexSegments[segment].start;
+        segmentLeft = indexSegments[segment].length;
+        step = indexSegments[segment].step;
+        segment++;
+      }
+      else if(logical != PICXEL_NO_LED)
+      {
+        logical += step;
+      }
+      segmentLeft--;
+    }
+
+    color = outputColor(logical);
+    green = color >> 8;
+    red = color >> 16;
+    blue = color;
+
+    if(timingMode == loopTiming)
+    {
+      GRBsendByteLoop(portSet, portClr, pinMask, green, loopCounts);
+      GRBsendByteLoop(portSet, portClr, pinMask, red, loopCounts);
+      GRBsendByteLoop(portSet, portClr, pinMask, blue, loopCounts);
+    }
+    else
+    {
+      GRBsendByte(portSet, portClr, pinMask, green);
+      GRBsendByte(portSet, portClr, pinMask, red);
+      GRBsendByte(portSet, portClr, pinMask, blue);
+    }
+  }
+
+  /* Restore the interrupts now */
+  PICXEL_TRACE(PICXEL_TRACE_LAST_BIT, 0);
+  restoreInterrupts(interruptBits);
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_ON, 0);
+}
+
+/************************************************************************/
+/*  Enables the power limit.  milliamps is the supply budget for the    */
+/*  strip, channelMilliamps the current of one color channel at full    */
+/*  on and idleMilliamps the current of a dark LED.                     */
+/*                                                                      */
+/*  The per channel sums of the colorArray are computed once here and   */
+/*  then kept up to date by the setters and clear(), so each refresh    */
+/*  derives its output scale in constant time.  Code writing the        */
+/*  colorArray directly must bracket its writes with beginPowerUpdate() */
+/*  and endPowerUpdate(), or call recomputePowerEstimate() after.       */
+/************************************************************************/
+void PICxel::setPowerBudget(uint32_t milliamps, uint8_t channelMilliamps, uint8_t idleMilliamps){
+  this->powerBudget = milliamps;
+  this->channelMilliamps = channelMilliamps;
+  this->idleMilliamps = idleMilliamps;
+  powerLimit = true;
+  recomputePowerEstimate();
+}
+
+/************************************************************************/
+/*  Disables the power limit, the output is no longer scaled            */
+/************************************************************************/
+void PICxel::disablePowerLimit(void){
+  powerLimit = false;
+  outputScale = 256;
+}
+
+/************************************************************************/
+/*  Adds (sign 1) or removes (sign -1) one LED from the channel sums.   */
+/*  HSV LEDs are counted by the GRB color they are sent as.             */
+/************************************************************************/
+void PICxel::powerLED(uint16_t number, int32_t sign){
+  uint32_t green, red, blue;
+
+  if(colorMode == GRB){
+    uint8_t *arrayPtr = &colorArray[number*3];
+    green = arrayPtr[0];
+    red = arrayPtr[1];
+    blue = arrayPtr[2];
+  }
+  else{
+    uint8_t *arrayPtr = &colorArray[number*4];
+    uint32_t HSV = arrayPtr[0] | arrayPtr[1] << 8 | arrayPtr[2] << 16 | arrayPtr[3] << 24;
+    uint32_t color = 0;
+    if(hsvCache != NULL)
+      color = hsvCache->lookup(HSV);
+    else if(arrayPtr[3])
+      color = HSVToColor(HSV);
+    green = (uint8_t)(color >> 8);
+    red = (uint8_t)(color >> 16);
+    blue = (uint8_t)color;
+  }
+
+  greenSum += sign*green;
+  redSum += sign*red;
+  blueSum += sign*blue;
+}
+
+/************************************************************************/
+/*  Bracket direct colorArray writes to LEDs first to first+count-1.    */
+/*  beginPowerUpdate() removes the old colors from the sums and         */
+/*  endPowerUpdate() adds the new ones, so the cost follows the number  */
+/*  of LEDs written.  Both do nothing while the power limit is off.     */
+/************************************************************************/
+void PICxel::beginPowerUpdate(uint16_t first, uint16_t count){
+  if(!powerLimit)
+    return;
+  for(uint32_t i = first; i < (uint32_t)first + count && i < numberOfLEDs; i++)
+    powerLED(i, -1);
+}
+
+void PICxel::endPowerUpdate(uint16_t first, uint16_t count){
+  if(!powerLimit)
+    return;
+  for(uint32_t i = first; i < (uint32_t)first + count && i < numberOfLEDs; i++)
+    powerLED(i, 1);
+}
+
+/************************************************************************/
+/*  Rebuilds the channel sums from the whole colorArray                 */
+/************************************************************************/
+void PICxel::recomputePowerEstimate(void){
+  greenSum = redSum = blueSum = 0;
+  if(!powerLimit || colorArray == NULL)
+    return;
+  for(uint16_t i = 0; i < numberOfLEDs; i++)
+    powerLED(i, 1);
+}
+
+/************************************************************************/
+/*  Returns the estimated strip current in mA for the colorArray as it  */
+/*  is, before any power limit scaling                                  */
+/************************************************************************/
+uint32_t PICxel::getPowerEstimate(void){
+  uint64_t channels = tiledPower((uint64_t)(greenSum + redSum + blueSum)*channelMilliamps);
+  return (uint32_t)(channels/255) + (uint32_t)idleMilliamps*powerLEDs();
+}
+
+/************************************************************************/
+/*  A tiled strip lights each colorArray LED once per copy, so its      */
+/*  channel current and LED count are scaled by the copies on the wire, */
+/*  a cut short copy counting as its share of the colorArray.           */
+/************************************************************************/
+uint64_t PICxel::tiledPower(uint64_t channels){
+  if(tileLEDs == 0)
+    return channels;
+  return channels*numberOfPhysicalLEDs/tileLEDs;
+}
+
+uint16_t PICxel::powerLEDs(void){
+  return (tileLEDs == 0) ? numberOfLEDs : numberOfPhysicalLEDs;
+}
+
+/************************************************************************/
+/*  Returns the output scale the power limit applies, 256 is unscaled.  */
+/*  Only the channel current is scaled, the idle current of the LEDs    */
+/*  is taken off the budget first.                                      */
+/************************************************************************/
+uint16_t PICxel::getPowerScale(void){
+  if(!powerLimit)
+    return 256;
+
+  uint32_t idle = (uint32_t)idleMilliamps*powerLEDs();
+  uint64_t channels = tiledPower((uint64_t)(greenSum + redSum + blueSum)*channelMilliamps);
+  if(channels == 0 || (uint64_t)powerBudget*255 >= channels + (uint64_t)idle*255)
+    return 256;
+  if(powerBudget <= idle)
+    return 0;
+
+  return (uint16_t)(((uint64_t)(powerBudget - idle)*255*256)/channels);
 }
 
 /************************************************************************/
@@ -296,9 +1150,14 @@ void PICxel::GRBrefreshLEDs(void){
 /*  ChipKIT boards.                                                     */
 /************************************************************************/
 void PICxel::HSVrefreshLEDs(void){
+#ifndef __mips__
+  //no MIPS core to run the inline conversion, e.g. a host build
+  stagedRefreshLEDs();
+#else
   
   //do not allow bitstream to be interrupted
   noInterrupts();
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_OFF, 0);
 
 asm volatile( 
 "lw $s0, %4     \n\t" //load address of color_ptr
@@ -708,8 +1567,10 @@ HSV_universal_delay_1 //preprocessor macro
   "subu $t7, $t7, $t3     \n\t"
   "multu $t7, $t4       \n\t"
   "mflo $t7         \n\t"
-  "andi $t7, $t7, 0xFF00    \n\t"
-  "sll $t7, $t7, 8      \n\t"
+  "srl $t7, $t7, 8      \n\t"
+  "addu $t7, $t7, $t5     \n\t"
+  "andi $t7, $t7, 0xFF    \n\t"
+  "sll $t7, $t7, 16     \n\t"
   "or $t1, $t1, $t7     \n\t"
   
   //delay for the end of the third section when hue is made   
@@ -972,8 +1833,10 @@ HSV_universal_delay_1 //preprocessor macro
   "subu $t7, $t7, $t3     \n\t"
   "multu $t7, $t4       \n\t"
   "mflo $t7         \n\t"
-  "andi $t7, $t7, 0xFF00    \n\t"
-  "sll $t7, $t7, 8      \n\t"
+  "srl $t7, $t7, 8      \n\t"
+  "addu $t7, $t7, $t5     \n\t"
+  "andi $t7, $t7, 0xFF    \n\t"
+  "sll $t7, $t7, 16     \n\t"
   "or $t1, $t1, $t7     \n\t"
 "comp_hue6:           \n\t" 
 
@@ -997,8 +1860,11 @@ HSV_universal_delay_1 //preprocessor macro
   : "%s0" //clobber-list
 );
   
+  PICXEL_TRACE(PICXEL_TRACE_LAST_BIT, 0);
   //bitstream done, enable interrupts
   interrupts();
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_ON, 0);
+#endif
 }
 
 /************************************************************************/
@@ -1008,6 +1874,9 @@ HSV_universal_delay_1 //preprocessor macro
 /*      ( blank )(  red  )(green )(blue )                               */
 /************************************************************************/
 uint32_t PICxel::HSVToColor(unsigned int HSV){
+#ifndef __mips__
+  return HSVToColorReference(HSV);
+#else
   //hue 0-360 -> 0-1535
   //saturation 0-255
   //value 0-255
@@ -1154,6 +2023,57 @@ uint32_t PICxel::HSVToColor(unsigned int HSV){
     : //clobber-list
   );
   
+  return ((red&0xFF)<<16 | (green&0xFF)<<8 | (blue&0xFF));
+#endif
+}
+
+/************************************************************************/
+/*  Portable C version of HSVToColor() that matches the assembly        */
+/*  bit for bit over every hue, saturation and value, including hues    */
+/*  above 1535 which fall through to the last sector.  Used in place    */
+/*  of the assembly on non MIPS builds and as the reference the         */
+/*  PICxel_HSV_selftest example checks the assembly against.            */
+/************************************************************************/
+uint32_t PICxel::HSVToColorReference(uint32_t HSV){
+  uint32_t hue = HSV & 0xFFFF;
+  uint32_t sat = ((HSV >> 16) & 0xFF) + 1;
+  uint32_t val = ((HSV >> 24) & 0xFF) + 1;
+  uint32_t chroma = (val*sat) >> 8;
+  uint32_t m = val - chroma;
+  uint32_t green, red, blue;
+
+  if(hue < 256){
+    green = ((chroma*hue) >> 8) + m;
+    red = chroma + m - 1;
+    blue = m;
+  }
+  else if(hue < 512){
+    green = chroma + m - 1;
+    red = ((chroma*(511 - hue)) >> 8) + m;
+    blue = m;
+  }
+  else if(hue < 768){
+    green = chroma + m - 1;
+    red = m;
+    blue = ((chroma*(hue - 512)) >> 8) + m;
+  }
+  else if(hue < 1024){
+    green = ((chroma*(1023 - hue)) >> 8) + m;
+    red = m;
+    blue = chroma + m - 1;
+  }
+  else if(hue < 1280){
+    green = m;
+    red = ((chroma*(hue - 1024)) >> 8) + m;
+    blue = chroma + m - 1;
+  }
+  else{
+    //unsigned wrap for hue > 1535, as multu/mflo in the assembly
+    green = m;
+    red = chroma + m - 1;
+    blue = ((chroma*(1535 - hue)) >> 8) + m;
+  }
+
   return ((red&0xFF)<<16 | (green&0xFF)<<8 | (blue&0xFF));
 }
 
@@ -1164,6 +2084,14 @@ uint16_t PICxel::getNumberOfLEDs(){
   return numberOfLEDs;
 }
 
+/************************************************************************/
+/*  Returns the number of colorArray bytes per LED, 3 for GRB and 4     */
+/*  for HSV                                                             */
+/************************************************************************/
+uint8_t PICxel::getBytesPerLED(void){
+  return (colorMode == GRB) ? 3 : 4;
+}
+
 /************************************************************************/
 /*  Returns the address of the beginning of the colorArray              */
 /************************************************************************/
@@ -1171,6 +2099,22 @@ uint8_t* PICxel::getColorArray(void){
   return colorArray;
 }
 
+/************************************************************************/
+/*  Returns the number of colorArray bytes the strip needs, 3 per LED   */
+/*  for GRB and 4 per LED for HSV                                       */
+/************************************************************************/
+uint32_t PICxel::getNumberOfBytes(void){
+  return numberOfBytes;
+}
+
+/************************************************************************/
+/*  Returns the colorArray bytes needed by every strip that exists,     */
+/*  wherever the arrays live                                            */
+/************************************************************************/
+uint32_t PICxel::getTotalFrameBytes(void){
+  return totalFrameBytes;
+}
+
 uint8_t PICxel::getBrightness(void){
   return brightness;
 }
\ No newline at end of file
@@ -21,11 +21,33 @@
 
 #include <WProgram.h>
 #include <stdint.h>
+#include "PICxelTrace.h"
+#include "PICxelHSVCache.h"
 
 #define BYTE uint8_t
 
 enum color_mode_t {GRB, HSV};
 enum memory_mode_t {alloc, noalloc};
+enum timing_mode_t {nopTiming, loopTiming, timingTooSlow};
+
+//index map entry for an LED that is not driven from the colorArray
+#define PICXEL_NO_LED 0xFFFF
+
+//run of physical LEDs that maps onto consecutive logical LEDs
+typedef struct{
+  uint16_t start;   //logical LED of the first physical LED, or PICXEL_NO_LED for a gap
+  uint16_t length;  //number of physical LEDs in the run
+  int16_t step;     //1 for a forward run, -1 for a reversed run
+} picxel_segment_t;
+
+class PICxel;
+class PICxelSnapshot;
+
+//refresh backend that replaces the bit banged output, see setOutput()
+class PICxelOutput{
+public:
+  virtual void refreshLEDs(PICxel &strip) = 0;
+};
 
 class PICxel{
 public:
@@ -35,35 +57,81 @@ public:
 
 
   void setArrayPointer(uint8_t* colorPtr);
+  bool setArrayPointer(uint8_t* colorPtr, uint32_t bytes);
 
   ~PICxel(void);
 
 //PICxel control functions
-  void begin(void);
+  bool begin(void);
+  bool begin(PICxelSnapshot &snapshot);
+  bool begin(Print &out);
+  bool recalibrate(uint32_t cpuHz);
+  timing_mode_t getTimingMode(void);
   void refreshLEDs(void);
   void GRBrefreshLEDs(void);
   void HSVrefreshLEDs(void);
+
+  void setIndexMap(const uint16_t *map, uint16_t physicalLEDs);
+  bool setIndexMap(const picxel_segment_t *segments, uint8_t numSegments);
+  void setTiling(uint16_t physicalLEDs, bool mirror = false);
+  void clearIndexMap(void);
+  bool hasIndexMap(void);
+  bool hasOutputStage(void);
+
+  void setHSVCache(PICxelHSVCache *cache);
+
+  void setOutput(PICxelOutput *output);
+  uint16_t getOutputLength(void);
+  void fillOutputBytes(uint8_t *out, uint16_t first, uint16_t count);
+
+  void setPowerBudget(uint32_t milliamps, uint8_t channelMilliamps = 20, uint8_t idleMilliamps = 1);
+  void disablePowerLimit(void);
+  void beginPowerUpdate(uint16_t first, uint16_t count);
+  void endPowerUpdate(uint16_t first, uint16_t count);
+  void recomputePowerEstimate(void);
+  uint32_t getPowerEstimate(void);
+  uint16_t getPowerScale(void);
   
+//32-bit colors are 0x00RRGGBB: setLEDColorRGB(), the gradient and matrix
+//colors, and what HSVToColor() returns.  GRBsetLEDColor(uint32_t) keeps
+//its original 0x00GGRRBB order for existing sketches.
   void GRBsetLEDColor(uint16_t number, uint8_t green, uint8_t red, uint8_t blue);
   void GRBsetLEDColor(uint16_t number, uint32_t color);
+  void setLEDColorRGB(uint16_t number, uint32_t color);
   
   void HSVsetLEDColor(uint16_t number, uint16_t hue, uint8_t sat, uint8_t val);
   void HSVsetLEDColor(uint16_t number, uint32_t color);
 
+  void fillRainbow(uint16_t first, uint16_t count, uint16_t hue, int32_t hueStep, uint8_t sat = 255, uint8_t val = 255);
+  void fillGradientHSV(uint16_t first, uint16_t count, uint32_t startHSV, uint32_t endHSV);
+  void fillGradientRGB(uint16_t first, uint16_t count, uint32_t startColor, uint32_t endColor);
+
   void clear();
   void clear(uint8_t num);
 
   uint32_t colorToScaledColor(uint32_t color);
   uint32_t HSVToColor(unsigned int HSV);
+  static uint32_t HSVToColorReference(uint32_t HSV);
 
 //set class variable functions 
   void setBrightness(uint8_t b);  
 
 //get class variable functions
   uint16_t getNumberOfLEDs(void);
+  uint8_t getBytesPerLED(void);
+  uint32_t getNumberOfBytes(void);
+  static uint32_t getTotalFrameBytes(void);
   uint8_t* getColorArray(void);
   uint8_t getBrightness(void);
 
+//procedural refresh, see the end of this file
+  template<uint32_t (*SHADER)(uint16_t index, uint32_t frameTime)>
+  void shaderRefreshLEDs(uint32_t frameTime);
+  template<uint32_t (*SHADER)(uint16_t index, uint32_t frameTime)>
+  uint32_t shaderWorstCaseTicks(uint32_t frameTime, uint16_t frames);
+  template<uint32_t (*SHADER)(uint16_t index, uint32_t frameTime)>
+  bool shaderFits(uint32_t frameTime, uint16_t frames);
+
 
 //pin control variables 
   uint8_t pin;
@@ -73,15 +141,51 @@ public:
 
 
 private:
+//a copy would free the colorArray twice
+  PICxel(const PICxel&);
+  PICxel& operator=(const PICxel&);
 
 //colorArray variables
+  void fillHSV(uint16_t first, uint16_t count, int32_t hue, int32_t hueStep,
+    int32_t sat, int32_t satStep, int32_t val, int32_t valStep);
   color_mode_t colorMode;
   uint16_t numberOfLEDs;
-  uint16_t numberOfBytes;
+  uint32_t numberOfBytes;
   uint8_t brightness; 
   uint8_t *colorArray;
+  uint8_t *allocatedArray;
+  static uint32_t totalFrameBytes;
 
-  
+//output stage variables
+  void stagedRefreshLEDs(void);
+  uint32_t outputColor(uint16_t logical);
+  PICxelOutput *output;
+  PICxelHSVCache *hsvCache;
+  uint16_t outputScale;
+  const uint16_t *indexMap;
+  const picxel_segment_t *indexSegments;
+  uint8_t numberOfSegments;
+  void nextTile(uint16_t &logical, int16_t &step);
+  uint16_t tileLEDs;
+  bool tileMirror;
+  uint16_t numberOfPhysicalLEDs;
+
+//bit timing variables
+  timing_mode_t timingMode;
+  uint32_t loopCounts[4];
+  uint32_t coreHz;
+
+//power estimator variables
+  void powerLED(uint16_t number, int32_t sign);
+  uint64_t tiledPower(uint64_t channels);
+  uint16_t powerLEDs(void);
+  bool powerLimit;
+  uint32_t powerBudget;
+  uint8_t channelMilliamps;
+  uint8_t idleMilliamps;
+  uint32_t greenSum;
+  uint32_t redSum;
+  uint32_t blueSum;
 };
 #endif // PICxel
 
@@ -118,6 +222,11 @@ private:
  * T1H =  800 ns
  * T1L =  350 ns
  * 
+ * GRB_delay_T1H_minus_T0H() is used where several pins share one bitstream
+ * (PICxelController): all pins go high, the pins sending 0 drop after T0H,
+ * and this delay takes the pins sending 1 on to T1H.  It is T1H less T0H
+ * and the two instructions of the extra load and store.
+ * 
  * All of these require the optimization level to be at -O2 (default for Arduino IDE)
  *
  * A nice optimization would be to determine the minimum F_CPU frequency where the
@@ -125,46 +234,59 @@ private:
  * the hard coded nops for all frequencies below.
  */
 #if F_CPU == 40000000L
+    #define PICXEL_NOP_DELAYS
     //  220 ns
     #define GRB_delay_T0H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n ");}
     // 1000 ns
     #define GRB_delay_T0L(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     //  800 ns
     #define GRB_delay_T1H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n");}
+    //  800 ns less T0H and the zero lane clear, for lockstep sends
+    #define GRB_delay_T1H_minus_T0H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     //  350 ns
     #define GRB_delay_T1L(); {asm volatile("nop\n nop\n nop\n nop\n");}
 #elif F_CPU == 48000000L
+    #define PICXEL_NOP_DELAYS
     //  220 ns
     #define GRB_delay_T0H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     //  980 ns
     #define GRB_delay_T0L(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     //  810 ns
     #define GRB_delay_T1H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n");}
+    //  800 ns less T0H and the zero lane clear, for lockstep sends
+    #define GRB_delay_T1H_minus_T0H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     //  360 ns
     #define GRB_delay_T1L(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n");}
 #elif F_CPU == 80000000L
+    #define PICXEL_NOP_DELAYS
     //  220 ns
     #define GRB_delay_T0H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     // 1000 ns
     #define GRB_delay_T0L(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     //  800 ns
     #define GRB_delay_T1H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
+    //  800 ns less T0H and the zero lane clear, for lockstep sends
+    #define GRB_delay_T1H_minus_T0H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     //  350 ns
     #define GRB_delay_T1L(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
 #elif F_CPU == 200000000L
+    #define PICXEL_NOP_DELAYS
     //  220 ns
     #define GRB_delay_T0H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     // 1000 ns
     #define GRB_delay_T0L(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     //  800 ns
     #define GRB_delay_T1H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
+    //  800 ns less T0H and the zero lane clear, for lockstep sends
+    #define GRB_delay_T1H_minus_T0H(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
     //  350 ns
     #define GRB_delay_T1L(); {asm volatile("nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n ");}
 #else
-    #warning F_CPU is not defined to a known value. PICxcel library not able to create delays properly.
+    #warning F_CPU is not defined to a known value. PICxcel library will use loop delays calibrated in begin().
     #define GRB_delay_T0H();
     #define GRB_delay_T0L();
     #define GRB_delay_T1H();
+    #define GRB_delay_T1H_minus_T0H();
     #define GRB_delay_T1L();
 #endif
 
@@ -191,10 +313,209 @@ private:
 #define HSV_bit_4_delay_1 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
 #define HSV_bit_4_delay_2 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
 
-#define HSV_bit_5_delay_0 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
+#define HSV_bit_5_delay_0 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
 #define HSV_bit_5_delay_1 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
 #define HSV_bit_5_delay_2 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
 
 #define HSV_universal_delay_1 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
 #define HSV_universal_delay_2 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
 #define HSV_universal_delay_3 "nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n nop\n"
+
+#ifndef PICxel_inline_H
+#define PICxel_inline_H
+
+/************************************************************************/
+/*  Sends one byte with the same bit timing as GRBrefreshLEDs()         */
+/************************************************************************/
+static inline void __attribute__((always_inline)) GRBsendByte(volatile uint32_t *portSet, 
+  volatile uint32_t *portClr, uint32_t pinMask, uint8_t data){
+  uint8_t bitSelect = 0x80;
+
+  while(bitSelect)
+  {
+    if(data & bitSelect)
+    {
+      *portSet = pinMask;
+      GRB_delay_T1H();
+      *portClr = pinMask;
+      GRB_delay_T1L();
+    }
+    else
+    {
+      *portSet = pinMask;
+      GRB_delay_T0H();
+      *portClr = pinMask;
+      GRB_delay_T0L();
+    }
+    bitSelect = (bitSelect >> 1);
+  }
+}
+
+/* Bit timing used with delay loops, when the nop tables above do not
+ * match the clock the core is running at (see PICxel::recalibrate()).
+ * T0H is aimed at the middle of its 200-500 ns window, since the loop
+ * counts are derived from a measured, not exact, loop overhead.
+ */
+#define PICXEL_LOOP_T0H_NS      300
+#define PICXEL_LOOP_T0H_MAX_NS  500
+#define PICXEL_LOOP_T0L_NS     1000
+#define PICXEL_LOOP_T1H_NS      800
+#define PICXEL_LOOP_T1L_NS      350
+
+enum {PICXEL_T0H, PICXEL_T0L, PICXEL_T1H, PICXEL_T1L};
+
+/************************************************************************/
+/*  Busy waits n+1 iterations of a two instruction loop                 */
+/************************************************************************/
+static inline void __attribute__((always_inline)) GRBloopDelay(uint32_t n){
+#ifdef __mips__
+  asm volatile(
+    ".set push        \n\t"
+    ".set noreorder   \n\t"
+    "1:               \n\t"
+    "bnez %0, 1b      \n\t"
+    "addiu %0, %0, -1 \n\t"
+    ".set pop         \n\t"
+    : "+r"(n));
+#else
+  do{
+    asm volatile("");
+  }while(n--);
+#endif
+}
+
+/************************************************************************/
+/*  Sends one byte with delay loop timing, counts holds the loop counts */
+/*  for T0H, T0L, T1H and T1L                                           */
+/************************************************************************/
+static inline void __attribute__((always_inline)) GRBsendByteLoop(volatile uint32_t *portSet, 
+  volatile uint32_t *portClr, uint32_t pinMask, uint8_t data, const uint32_t *counts){
+  uint8_t bitSelect = 0x80;
+
+  while(bitSelect)
+  {
+    if(data & bitSelect)
+    {
+      *portSet = pinMask;
+      GRBloopDelay(counts[PICXEL_T1H]);
+      *portClr = pinMask;
+      GRBloopDelay(counts[PICXEL_T1L]);
+    }
+    else
+    {
+      *portSet = pinMask;
+      GRBloopDelay(counts[PICXEL_T0H]);
+      *portClr = pinMask;
+      GRBloopDelay(counts[PICXEL_T0L]);
+    }
+    bitSelect = (bitSelect >> 1);
+  }
+}
+
+/* Longest time the data line may idle low between two LEDs without the
+ * strip taking it as a reset.  Newer WS2812B parts need 280us to reset,
+ * but some older parts latch after about 5us, so stay under that.
+ */
+#define PICXEL_SHADER_BUDGET_NS 4000
+
+/************************************************************************/
+/*  Procedural refresh with no colorArray.  Each LED's color comes from */
+/*  SHADER(index, frameTime), which returns the same 32-bit layout as   */
+/*  GRBsetLEDColor(): ( blank )(  red  )(green )(blue ).  The next LED  */
+/*  is computed while the line idles low after the current one, like    */
+/*  the inline conversion in HSVrefreshLEDs(), and the result is scaled */
+/*  by the brightness.                                                  */
+/*                                                                      */
+/*  SHADER is bound at compile time so the call can be inlined.  Build  */
+/*  the strip in noalloc mode and never set an array to use no          */
+/*  framebuffer memory at all.  Check the shader with shaderFits()      */
+/*  first, a shader slower than PICXEL_SHADER_BUDGET_NS resets the      */
+/*  strip part way through.                                             */
+/************************************************************************/
+template<uint32_t (*SHADER)(uint16_t index, uint32_t frameTime)>
+void PICxel::shaderRefreshLEDs(uint32_t frameTime){
+  uint32_t interruptBits;
+  uint32_t color;
+  uint32_t scale = brightness + 1;
+
+  PICXEL_TRACE(PICXEL_TRACE_REFRESH_START, 0);
+  if(numberOfLEDs == 0 || timingMode == timingTooSlow)
+    return;
+
+  color = SHADER(0, frameTime);
+
+  /* Disable interrupts, but save current bits so we can restore them later */
+  interruptBits = disableInterrupts();
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_OFF, 0);
+
+  //32-bit so the loop ends at a 65535 LED strip
+  for(uint32_t i = 1; i <= numberOfLEDs; i++)
+  {
+    uint8_t green = ((uint8_t)(color >> 8)*scale) >> 8;
+    uint8_t red = ((uint8_t)(color >> 16)*scale) >> 8;
+    uint8_t blue = ((uint8_t)color*scale) >> 8;
+    if(timingMode == loopTiming)
+    {
+      GRBsendByteLoop(portSet, portClr, pinMask, green, loopCounts);
+      GRBsendByteLoop(portSet, portClr, pinMask, red, loopCounts);
+      GRBsendByteLoop(portSet, portClr, pinMask, blue, loopCounts);
+    }
+    else
+    {
+      GRBsendByte(portSet, portClr, pinMask, green);
+      GRBsendByte(portSet, portClr, pinMask, red);
+      GRBsendByte(portSet, portClr, pinMask, blue);
+    }
+    if(i < numberOfLEDs)
+      color = SHADER((uint16_t)i, frameTime);
+  }
+
+  /* Restore the interrupts now */
+  PICXEL_TRACE(PICXEL_TRACE_LAST_BIT, 0);
+  restoreInterrupts(interruptBits);
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_ON, 0);
+}
+
+/************************************************************************/
+/*  Calls SHADER for every LED over frames frames starting at frameTime */
+/*  and returns the slowest call in core timer ticks, half the core     */
+/*  clock.  Only meaningful on the board: a host build times the host.  */
+/************************************************************************/
+template<uint32_t (*SHADER)(uint16_t index, uint32_t frameTime)>
+uint32_t PICxel::shaderWorstCaseTicks(uint32_t frameTime, uint16_t frames){
+  static volatile uint32_t sink;
+  uint32_t worst = 0;
+
+  for(uint16_t f = 0; f < frames; f++)
+  {
+    for(uint16_t i = 0; i < numberOfLEDs; i++)
+    {
+      uint32_t start = ReadCoreTimer();
+      sink = SHADER(i, frameTime + f);
+      uint32_t ticks = ReadCoreTimer() - start;
+      if(ticks > worst)
+        worst = ticks;
+    }
+  }
+  return worst;
+}
+
+/************************************************************************/
+/*  Returns true if the slowest SHADER call, plus the brightness        */
+/*  scaling and loop overhead, fits the idle time between two LEDs.     */
+/*  Ticks are turned into ns at the core clock begin() or the last      */
+/*  recalibrate() was given.  Only meaningful on the board, on the host */
+/*  it says how fast the PC runs the shader.                            */
+/************************************************************************/
+template<uint32_t (*SHADER)(uint16_t index, uint32_t frameTime)>
+bool PICxel::shaderFits(uint32_t frameTime, uint16_t frames){
+  //overhead of one LED in the loop above, in core timer ticks
+  const uint32_t overheadTicks = 16;
+  uint32_t worst = shaderWorstCaseTicks<SHADER>(frameTime, frames) + overheadTicks;
+  if(coreHz == 0)
+    return false;
+  uint64_t ns = (uint64_t)worst*2000000000ULL/coreHz;
+  return ns < PICXEL_SHADER_BUDGET_NS;
+}
+
+#endif // PICxel_inline_H
@@ -0,0 +1,205 @@
+/************************************************************************/
+/*  PICxelAnim.cpp  - PIC32 Neopixel Library                            */
+/*                                                                      */
+/*  Streaming playback of compressed animations from flash or a Stream. */
+/*                                                                      */
+/*  Decode cost is bounded by the frame format: a frame can touch each  */
+/*  colorArray byte at most once and can hold at most one op per LED    */
+/*  plus the END op, anything longer is rejected as corrupt.  The core  */
+/*  timer cost of the last and the slowest frame is kept so it can be   */
+/*  checked against the frame period.                                   */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelAnim.h"
+
+/************************************************************************/
+/*  Construction for playback from a memory array.  On the PIC32 a      */
+/*  const array lives in flash, e.g. the C array written by the         */
+/*  picxel_anim_encode tool.                                            */
+/************************************************************************/
+PICxelAnim::PICxelAnim(PICxel &strip, const uint8_t *data, uint32_t length) :
+  strip(&strip), data(data), length(length), readIndex(0), stream(NULL),
+  numberOfLEDs(0), bytesPerLED(0), frameCount(0), framePeriod(0),
+  frameIndex(0), lastDecodeTicks(0), maxDecodeTicks(0){
+}
+
+/************************************************************************/
+/*  Construction for playback from a Stream, e.g. an open SD File       */
+/************************************************************************/
+PICxelAnim::PICxelAnim(PICxel &strip, Stream &stream) :
+  strip(&strip), data(NULL), length(0), readIndex(0), stream(&stream),
+  numberOfLEDs(0), bytesPerLED(0), frameCount(0), framePeriod(0),
+  frameIndex(0), lastDecodeTicks(0), maxDecodeTicks(0){
+}
+
+/************************************************************************/
+/*  Reads and checks the file header and clears the strip, since the    */
+/*  first frame is stored as a delta against a cleared strip.  Fails    */
+/*  if the animation is longer than the strip or was encoded for the    */
+/*  other color mode.                                                   */
+/************************************************************************/
+bool PICxelAnim::begin(void){
+  uint8_t header[PXA_HEADER_SIZE];
+
+  readIndex = 0;
+  if(!readBytes(header, PXA_HEADER_SIZE))
+    return false;
+  if(header[0] != 'P' || header[1] != 'X' || header[2] != 'A' || header[3] != '1')
+    return false;
+
+  numberOfLEDs = header[4] | (header[5] << 8);
+  bytesPerLED = header[6];
+  frameCount = header[8] | (header[9] << 8);
+  framePeriod = header[10] | (header[11] << 8);
+
+  if(numberOfLEDs > strip->getNumberOfLEDs())
+    return false;
+  if(bytesPerLED != 3 && bytesPerLED != 4)
+    return false;
+  if(bytesPerLED != strip->getBytesPerLED())
+    return false;
+
+  strip->clear();
+  frameIndex = 0;
+  return true;
+}
+
+/************************************************************************/
+/*  Restarts a memory array animation from the first frame.  A Stream   */
+/*  cannot be rewound here, seek the File and call begin() instead.     */
+/************************************************************************/
+bool PICxelAnim::rewind(void){
+  if(stream != NULL)
+    return false;
+  return begin();
+}
+
+/************************************************************************/
+/*  Decodes the next frame into the colorArray.  Returns false at the   */
+/*  end of the animation or on corrupt data, the strip is then left     */
+/*  partially updated.                                                  */
+/************************************************************************/
+bool PICxelAnim::decodeFrame(void){
+  if(frameIndex >= frameCount)
+    return false;
+
+  PICXEL_TRACE(PICXEL_TRACE_RENDER_START, frameIndex);
+  uint32_t startTicks = ReadCoreTimer();
+  uint8_t *arrayPtr = strip->getColorArray();
+  uint8_t *arrayEnd = arrayPtr + (uint32_t)numberOfLEDs*bytesPerLED;
+  uint32_t opsLeft = (uint32_t)numberOfLEDs + 1;
+  uint8_t color[4];
+  int op;
+
+  while(opsLeft--){
+    op = readByte();
+    if(op < 0)
+      return false;
+
+    if((op & PXA_OP_MASK) == PXA_OP_END){
+      frameIndex++;
+      lastDecodeTicks = ReadCoreTimer() - startTicks;
+      if(lastDecodeTicks > maxDecodeTicks)
+        maxDecodeTicks = lastDecodeTicks;
+      PICXEL_TRACE(PICXEL_TRACE_RENDER_END, frameIndex - 1);
+      return true;
+    }
+
+    uint32_t count = (op & PXA_COUNT_MASK) + 1;
+    uint32_t bytes = count*bytesPerLED;
+    if(arrayPtr + bytes > arrayEnd)
+      return false;
+
+    if((op & PXA_OP_MASK) == PXA_OP_SKIP){
+      arrayPtr += bytes;
+      continue;
+    }
+
+    uint16_t firstLED = (arrayPtr - strip->getColorArray())/bytesPerLED;
+
+    if((op & PXA_OP_MASK) == PXA_OP_RUN){
+      //read before the bracket opens, a short read changes nothing
+      if(!readBytes(color, bytesPerLED))
+        return false;
+      strip->beginPowerUpdate(firstLED, count);
+      for(uint32_t n = 0; n < count; n++){
+        for(uint8_t i = 0; i < bytesPerLED; i++)
+          *arrayPtr++ = color[i];
+      }
+    }
+    else{ //PXA_OP_COPY
+      strip->beginPowerUpdate(firstLED, count);
+      if(!readBytes(arrayPtr, bytes)){
+        //part of the run may have been written, count what is there now
+        strip->endPowerUpdate(firstLED, count);
+        return false;
+      }
+      arrayPtr += bytes;
+    }
+
+    strip->endPowerUpdate(firstLED, count);
+  }
+  return false;
+}
+
+/************************************************************************/
+/*  Reads one byte from the source, -1 at the end of the data           */
+/************************************************************************/
+int PICxelAnim::readByte(void){
+  if(stream != NULL)
+    return stream->read();
+  if(readIndex >= length)
+    return -1;
+  return data[readIndex++];
+}
+
+/************************************************************************/
+/*  Reads count bytes from the source straight into dst                 */
+/************************************************************************/
+bool PICxelAnim::readBytes(uint8_t *dst, uint32_t count){
+  if(stream != NULL)
+    return stream->readBytes((char*)dst, count) == count;
+  if(readIndex + count > length)
+    return false;
+  memcpy(dst, &data[readIndex], count);
+  readIndex += count;
+  return true;
+}
+
+/************************************************************************/
+/*  Returns the number of frames in the animation                       */
+/************************************************************************/
+uint16_t PICxelAnim::getFrameCount(void){
+  return frameCount;
+}
+
+/************************************************************************/
+/*  Returns the number of frames decoded since begin()                  */
+/************************************************************************/
+uint16_t PICxelAnim::getFrameIndex(void){
+  return frameIndex;
+}
+
+/************************************************************************/
+/*  Returns the frame period in milliseconds stored by the encoder      */
+/************************************************************************/
+uint16_t PICxelAnim::getFramePeriod(void){
+  return framePeriod;
+}
+
+/************************************************************************/
+/*  Returns the core timer ticks (F_CPU/2) the last frame took          */
+/************************************************************************/
+uint32_t PICxelAnim::getLastDecodeTicks(void){
+  return lastDecodeTicks;
+}
+
+/************************************************************************/
+/*  Returns the core timer ticks of the slowest frame so far            */
+/************************************************************************/
+uint32_t PICxelAnim::getMaxDecodeTicks(void){
+  return maxDecodeTicks;
+}
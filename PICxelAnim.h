@@ -0,0 +1,57 @@
+/************************************************************************/
+/*  PICxelAnim.h  - PIC32 Neopixel Library                              */
+/*                                                                      */
+/*  Streaming playback of compressed animations (see PICxelAnimFormat.h)*/
+/*  from a flash resident array or from a Stream such as an SD card     */
+/*  File.  Frames are decoded directly into the colorArray of a PICxel  */
+/*  object, unchanged LEDs are never touched.                           */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelAnim_H
+#define PICxelAnim_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+#include "PICxelAnimFormat.h"
+
+class PICxelAnim{
+public:
+  PICxelAnim(PICxel &strip, const uint8_t *data, uint32_t length);
+  PICxelAnim(PICxel &strip, Stream &stream);
+
+  bool begin(void);
+  bool decodeFrame(void);
+  bool rewind(void);
+
+  uint16_t getFrameCount(void);
+  uint16_t getFrameIndex(void);
+  uint16_t getFramePeriod(void);
+  uint32_t getLastDecodeTicks(void);
+  uint32_t getMaxDecodeTicks(void);
+
+private:
+  int readByte(void);
+  bool readBytes(uint8_t *dst, uint32_t count);
+
+  PICxel *strip;
+
+//source variables, either a memory array or a Stream
+  const uint8_t *data;
+  uint32_t length;
+  uint32_t readIndex;
+  Stream *stream;
+
+//header variables
+  uint16_t numberOfLEDs;
+  uint8_t bytesPerLED;
+  uint16_t frameCount;
+  uint16_t framePeriod;
+
+  uint16_t frameIndex;
+  uint32_t lastDecodeTicks;
+  uint32_t maxDecodeTicks;
+};
+#endif // PICxelAnim_H
@@ -0,0 +1,117 @@
+/************************************************************************/
+/*  PICxelAnimFormat.h  - PIC32 Neopixel Library                        */
+/*                                                                      */
+/*  Compressed animation format shared by the on-device PICxelAnim      */
+/*  decoder and the host side encoder in extras/tools.  This header     */
+/*  has no Arduino dependencies so it builds on the host as well.       */
+/*                                                                      */
+/*  File header (12 bytes, little endian):                              */
+/*    'P' 'X' 'A' '1' (LEDs lo)(LEDs hi)(bytes per LED)(0)              */
+/*    (frames lo)(frames hi)(period ms lo)(period ms hi)                */
+/*                                                                      */
+/*  Each frame is a list of ops.  An op byte holds the op code in bits  */
+/*  7-6 and the LED count minus one (1-64) in bits 5-0:                 */
+/*    SKIP  - keep count LEDs from the previous frame                   */
+/*    RUN   - one color follows, written to count LEDs                  */
+/*    COPY  - count colors follow, written as is                        */
+/*    END   - end of frame                                              */
+/*  Colors are stored exactly as they sit in the colorArray, 3 bytes    */
+/*  for GRB and 4 bytes for HSV, brightness already applied.  The       */
+/*  first frame is a delta against a cleared strip.                     */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelAnimFormat_H
+#define PICxelAnimFormat_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PXA_HEADER_SIZE   12
+#define PXA_OP_SKIP       0x00
+#define PXA_OP_RUN        0x40
+#define PXA_OP_COPY       0x80
+#define PXA_OP_END        0xC0
+#define PXA_OP_MASK       0xC0
+#define PXA_COUNT_MASK    0x3F
+#define PXA_MAX_COUNT     64
+
+/************************************************************************/
+/*  Writes the 12 byte file header into out                             */
+/************************************************************************/
+inline void PXAwriteHeader(uint8_t *out, uint16_t numLEDs, uint8_t bytesPerLED,
+  uint16_t frames, uint16_t periodMs){
+  out[0] = 'P';
+  out[1] = 'X';
+  out[2] = 'A';
+  out[3] = '1';
+  out[4] = numLEDs;
+  out[5] = numLEDs >> 8;
+  out[6] = bytesPerLED;
+  out[7] = 0;
+  out[8] = frames;
+  out[9] = frames >> 8;
+  out[10] = periodMs;
+  out[11] = periodMs >> 8;
+}
+
+/************************************************************************/
+/*  Encodes cur as a delta against prev.  out must hold at least        */
+/*  numLEDs*(bytesPerLED+1)+1 bytes, the worst case for a frame with    */
+/*  no repeats.  Returns the number of bytes written.                   */
+/************************************************************************/
+inline uint32_t PXAencodeFrame(const uint8_t *prev, const uint8_t *cur,
+  uint16_t numLEDs, uint8_t bytesPerLED, uint8_t *out){
+  uint8_t *outPtr = out;
+  uint32_t i = 0;
+
+  while(i < numLEDs){
+    const uint8_t *color = &cur[i*bytesPerLED];
+    uint32_t count;
+
+    //unchanged LEDs
+    count = 0;
+    while(i+count < numLEDs && count < PXA_MAX_COUNT &&
+      memcmp(&prev[(i+count)*bytesPerLED], &cur[(i+count)*bytesPerLED], bytesPerLED) == 0)
+      count++;
+    if(count){
+      *outPtr++ = PXA_OP_SKIP | (count-1);
+      i += count;
+      continue;
+    }
+
+    //repeated color
+    count = 1;
+    while(i+count < numLEDs && count < PXA_MAX_COUNT &&
+      memcmp(&cur[(i+count)*bytesPerLED], color, bytesPerLED) == 0)
+      count++;
+    if(count > 1){
+      *outPtr++ = PXA_OP_RUN | (count-1);
+      memcpy(outPtr, color, bytesPerLED);
+      outPtr += bytesPerLED;
+      i += count;
+      continue;
+    }
+
+    //literal colors, stop where a skip or run would start
+    count = 1;
+    while(i+count < numLEDs && count < PXA_MAX_COUNT){
+      const uint8_t *next = &cur[(i+count)*bytesPerLED];
+      if(memcmp(&prev[(i+count)*bytesPerLED], next, bytesPerLED) == 0)
+        break;
+      if(i+count+1 < numLEDs && memcmp(next + bytesPerLED, next, bytesPerLED) == 0)
+        break;
+      count++;
+    }
+    *outPtr++ = PXA_OP_COPY | (count-1);
+    memcpy(outPtr, color, count*bytesPerLED);
+    outPtr += count*bytesPerLED;
+    i += count;
+  }
+
+  *outPtr++ = PXA_OP_END;
+  return outPtr - out;
+}
+
+#endif // PICxelAnimFormat_H
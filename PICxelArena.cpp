@@ -0,0 +1,176 @@
+/************************************************************************/
+/*  PICxelArena.cpp  - PIC32 Neopixel Library                           */
+/*                                                                      */
+/*  Frame buffers for many strips carved from one static block.         */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelArena.h"
+
+/************************************************************************/
+/*  Construction for the PICxelArena class.  block must stay valid as   */
+/*  long as the arena, PICXEL_ARENA_BLOCK() declares a suitable one.    */
+/*  Bytes before the first word boundary of block are not used.         */
+/************************************************************************/
+PICxelArena::PICxelArena(uint8_t *block, uint32_t bytes) : block(block), size(bytes),
+  used(0), failures(0), blocks(0){
+  uint32_t skip = (4 - ((uintptr_t)block & 3)) & 3;
+
+  if(block == NULL || bytes < skip)
+    size = 0;
+  else{
+    this->block = block + skip;
+    size = (bytes - skip) & ~3;
+  }
+}
+
+/************************************************************************/
+/*  Returns bytes of zeroed, word aligned memory from the arena, or     */
+/*  NULL when the arena is full or already holds                        */
+/*  PICXEL_ARENA_MAX_BLOCKS buffers.  tag names the buffer in report(). */
+/************************************************************************/
+uint8_t* PICxelArena::allocate(uint32_t bytes, const char *tag){
+  uint32_t rounded = (bytes + 3) & ~3;
+
+  if(bytes == 0 || rounded < bytes || blocks == PICXEL_ARENA_MAX_BLOCKS ||
+     rounded > size - used){
+    failures++;
+    return NULL;
+  }
+
+  uint8_t *buffer = block + used;
+  memset(buffer, 0, rounded);
+
+  blockOffset[blocks] = used;
+  blockBytes[blocks] = bytes;
+  blockTag[blocks] = tag;
+  blockStrip[blocks] = NULL;
+  blocks++;
+  used += rounded;
+  return buffer;
+}
+
+/************************************************************************/
+/*  Returns a buffer the size of the colorArray of strip, for a second  */
+/*  frame to draw into or a staging copy.  The strip is not changed.    */
+/************************************************************************/
+uint8_t* PICxelArena::allocateFor(PICxel &strip, const char *tag){
+  return allocate(strip.getNumberOfBytes(), tag);
+}
+
+/************************************************************************/
+/*  Allocates the colorArray of a strip built with noalloc and points   */
+/*  the strip at it.  Returns false and leaves the strip alone if the   */
+/*  arena has no room.                                                  */
+/************************************************************************/
+bool PICxelArena::attach(PICxel &strip, const char *tag){
+  uint8_t *buffer = allocateFor(strip, tag);
+
+  if(buffer == NULL || !strip.setArrayPointer(buffer, strip.getNumberOfBytes()))
+    return false;
+  blockStrip[blocks - 1] = &strip;
+  return true;
+}
+
+/************************************************************************/
+/*  Forgets strip, so releasing its buffer no longer touches it.  Call  */
+/*  it before destroying a strip that was attached to a live arena.     */
+/*  The buffer stays allocated until it is released.                    */
+/************************************************************************/
+void PICxelArena::detach(PICxel &strip){
+  for(uint8_t i = 0; i < blocks; i++){
+    if(blockStrip[i] == &strip)
+      blockStrip[i] = NULL;
+  }
+}
+
+/************************************************************************/
+/*  Returns a mark that releaseTo() can free back to, for buffers that  */
+/*  are only needed for a while, e.g. while an effect is running.       */
+/************************************************************************/
+uint8_t PICxelArena::mark(void){
+  return blocks;
+}
+
+/************************************************************************/
+/*  Frees every buffer allocated after mark was taken, newest first.    */
+/*  Strips attached to a freed buffer are pointed at NULL, so they must */
+/*  be attached again before they are drawn on or refreshed.  Every     */
+/*  strip still attached must exist, see detach().                      */
+/************************************************************************/
+void PICxelArena::releaseTo(uint8_t mark){
+  while(blocks > mark){
+    blocks--;
+    if(blockStrip[blocks] != NULL)
+      blockStrip[blocks]->setArrayPointer(NULL);
+    used = blockOffset[blocks];
+  }
+}
+
+/************************************************************************/
+/*  Frees every buffer in the arena                                     */
+/************************************************************************/
+void PICxelArena::release(void){
+  releaseTo(0);
+}
+
+uint32_t PICxelArena::getSize(void){
+  return size;
+}
+
+uint32_t PICxelArena::getUsed(void){
+  return used;
+}
+
+uint32_t PICxelArena::getFree(void){
+  return size - used;
+}
+
+/************************************************************************/
+/*  Returns the number of allocations that did not fit                  */
+/************************************************************************/
+uint32_t PICxelArena::getFailures(void){
+  return failures;
+}
+
+/************************************************************************/
+/*  Prints one line per buffer, tag,offset,bytes,leds with leds 0 for   */
+/*  buffers that are not a strip colorArray, then the arena use and the */
+/*  colorArray bytes of every strip in the sketch, including strips     */
+/*  that allocated their own from the heap.  Call it after begin(),     */
+/*  which prints the total on its own when given a Print.               */
+/************************************************************************/
+void PICxelArena::report(Print &out){
+  uint32_t stripBytes = 0;
+
+  out.println("tag,offset,bytes,leds");
+  for(uint8_t i = 0; i < blocks; i++){
+    out.print(blockTag[i] ? blockTag[i] : "-");
+    out.print(",");
+    out.print((unsigned long)blockOffset[i]);
+    out.print(",");
+    out.print((unsigned long)blockBytes[i]);
+    out.print(",");
+    if(blockStrip[i] != NULL){
+      out.println((unsigned long)blockStrip[i]->getNumberOfLEDs());
+      stripBytes += blockBytes[i];
+    }
+    else
+      out.println("0");
+  }
+
+  out.print("# arena ");
+  out.print((unsigned long)used);
+  out.print(" of ");
+  out.print((unsigned long)size);
+  out.print(" bytes, ");
+  out.print((unsigned long)stripBytes);
+  out.print(" in strips, ");
+  out.print((unsigned long)failures);
+  out.println(" failed");
+  out.print("# framebuffers ");
+  out.print((unsigned long)PICxel::getTotalFrameBytes());
+  out.println(" bytes in all strips");
+}
@@ -0,0 +1,68 @@
+/************************************************************************/
+/*  PICxelArena.h  - PIC32 Neopixel Library                             */
+/*                                                                      */
+/*  Carves the frame buffers of every strip, and any double or staging  */
+/*  buffers, out of one static block instead of the heap.  Each strip   */
+/*  is built noalloc and attached, which checks the buffer fits, so     */
+/*  many strips cannot fragment the small PIC32 heap and running out of */
+/*  memory shows up once at startup rather than as a NULL colorArray.   */
+/*                                                                      */
+/*  Buffers are handed out in order and released in reverse, back to a  */
+/*  mark() or all at once, so nothing is ever left behind.  Begin the   */
+/*  strips with PICxel::begin(Print &) to print the framebuffer total   */
+/*  at startup, report() adds every buffer in the arena.                */
+/*                                                                      */
+/*  The arena keeps a pointer to every attached strip, so a strip must  */
+/*  outlive the arena or be detach()ed before it is destroyed.          */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelArena_H
+#define PICxelArena_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+//buffers an arena keeps track of for release() and report()
+#ifndef PICXEL_ARENA_MAX_BLOCKS
+#define PICXEL_ARENA_MAX_BLOCKS 16
+#endif
+
+//declares a static block of bytes for an arena, word aligned
+#define PICXEL_ARENA_BLOCK(name, bytes) \
+  static uint8_t name[((bytes) + 3) & ~3] __attribute__((aligned(4)))
+
+class PICxelArena{
+public:
+  PICxelArena(uint8_t *block, uint32_t bytes);
+
+  uint8_t* allocate(uint32_t bytes, const char *tag = NULL);
+  uint8_t* allocateFor(PICxel &strip, const char *tag = NULL);
+  bool attach(PICxel &strip, const char *tag = NULL);
+  void detach(PICxel &strip);
+
+  uint8_t mark(void);
+  void releaseTo(uint8_t mark);
+  void release(void);
+
+  uint32_t getSize(void);
+  uint32_t getUsed(void);
+  uint32_t getFree(void);
+  uint32_t getFailures(void);
+  void report(Print &out);
+
+private:
+  uint8_t *block;
+  uint32_t size;
+  uint32_t used;
+  uint32_t failures;
+
+  uint8_t blocks;
+  uint32_t blockOffset[PICXEL_ARENA_MAX_BLOCKS];
+  uint32_t blockBytes[PICXEL_ARENA_MAX_BLOCKS];
+  const char *blockTag[PICXEL_ARENA_MAX_BLOCKS];
+  PICxel *blockStrip[PICXEL_ARENA_MAX_BLOCKS];
+};
+#endif // PICxelArena_H
@@ -0,0 +1,269 @@
+/************************************************************************/
+/*  PICxelBench.cpp  - PIC32 Neopixel Library                           */
+/*                                                                      */
+/*  Benchmarks of the PICxel API and kernels, timed with the core       */
+/*  timer.  Strips are built in noalloc mode on the caller's buffer, so */
+/*  the largest size run is the one whose HSV array fits the buffer.    */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelBench.h"
+#include "PICxelParticles.h"
+
+//strip sizes benchmarked by run()
+static const uint16_t benchSizes[] = {15, 60, 240, 1024, 4096};
+
+//pixels processed per kernel and size, spread over the iterations
+#define BENCH_PIXELS 16384
+
+//particle pool benchmarked by runParticles(), on a strip of BENCH_PARTICLE_LEDS
+#define BENCH_PARTICLES 256
+#define BENCH_PARTICLE_LEDS 240
+#define BENCH_PARTICLE_FRAMES 64
+
+//keeps results alive so the compiler cannot drop the work
+static volatile uint32_t benchSink;
+
+//wire bytes of BENCH_CHUNK_LEDS LEDs for the output stage kernels
+#define BENCH_CHUNK_LEDS 64
+static uint8_t benchChunk[3*BENCH_CHUNK_LEDS];
+
+/************************************************************************/
+/*  Construction for the PICxelBench class.  pin is driven by the       */
+/*  refresh benchmarks, buffer must hold 4 bytes per LED of the largest */
+/*  size to run.                                                        */
+/************************************************************************/
+PICxelBench::PICxelBench(Print &out, uint8_t pin, uint8_t *buffer, uint32_t bufferBytes) :
+  out(&out), pin(pin), buffer(buffer), bufferBytes(bufferBytes){
+}
+
+/************************************************************************/
+/*  Prints the CSV header and runs every size that fits the buffer      */
+/************************************************************************/
+void PICxelBench::run(void){
+  out->print("# PICxel benchmark, F_CPU ");
+  out->println((unsigned long)F_CPU);
+  out->println("kernel,leds,iterations,ticks,ns_per_pixel");
+
+  for(uint8_t i = 0; i < sizeof(benchSizes)/sizeof(benchSizes[0]); i++){
+    if(4*(uint32_t)benchSizes[i] <= bufferBytes)
+      runSize(benchSizes[i]);
+  }
+  if(3*BENCH_PARTICLE_LEDS <= bufferBytes)
+    runParticles();
+}
+
+/************************************************************************/
+/*  Prints one CSV line, ns per pixel from core timer ticks at F_CPU/2  */
+/************************************************************************/
+void PICxelBench::report(const char *kernel, uint16_t leds, uint32_t iterations, uint32_t ticks){
+  uint64_t ns = (uint64_t)ticks*2000000000ULL/F_CPU;
+  uint32_t nsPerPixel = ns/((uint64_t)iterations*leds);
+
+  out->print(kernel);
+  out->print(",");
+  out->print((unsigned long)leds);
+  out->print(",");
+  out->print((unsigned long)iterations);
+  out->print(",");
+  out->print((unsigned long)ticks);
+  out->print(",");
+  out->println((unsigned long)nsPerPixel);
+}
+
+/************************************************************************/
+/*  Runs every kernel on one strip size                                 */
+/************************************************************************/
+void PICxelBench::runSize(uint16_t leds){
+  uint32_t iterations = BENCH_PIXELS/leds;
+  uint32_t start;
+
+  if(iterations == 0)
+    iterations = 1;
+
+  PICxel grb(leds, pin, GRB, noalloc);
+  grb.setArrayPointer(buffer);
+  grb.begin();
+  grb.setBrightness(200);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    for(uint16_t i = 0; i < leds; i++)
+      grb.GRBsetLEDColor(i, i, n, 0x55);
+  report("GRBsetLEDColor", leds, iterations, ReadCoreTimer() - start);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    for(uint16_t i = 0; i < leds; i++)
+      grb.GRBsetLEDColor(i, (uint32_t)(i*0x010203 + n));
+  report("GRBsetLEDColor32", leds, iterations, ReadCoreTimer() - start);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    grb.clear();
+  report("GRBclear", leds, iterations, ReadCoreTimer() - start);
+
+  //a rainbow converted per pixel, the way effects did before fillRainbow()
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++){
+    for(uint16_t i = 0; i < leds; i++){
+      uint32_t color = grb.HSVToColor(((n + i*1536/leds) % 1536) | 0xFFFF0000);
+      grb.GRBsetLEDColor(i, (uint8_t)(color >> 8), (uint8_t)(color >> 16), (uint8_t)color);
+    }
+  }
+  report("RainbowHSVToColor", leds, iterations, ReadCoreTimer() - start);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    grb.fillRainbow(0, leds, n % 1536, (1536L << 16)/leds);
+  report("GRBfillRainbow", leds, iterations, ReadCoreTimer() - start);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    grb.fillGradientHSV(0, leds, (n % 1536) | 0xFF400000, ((n + 700) % 1536) | 0x40FF0000);
+  report("GRBfillGradientHSV", leds, iterations, ReadCoreTimer() - start);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    grb.fillGradientRGB(0, leds, 0xFF0000 | n, 0x00FF80);
+  report("GRBfillGradientRGB", leds, iterations, ReadCoreTimer() - start);
+
+  for(uint16_t i = 0; i < leds; i++)
+    grb.GRBsetLEDColor(i, i, 255 - i, 0x55);
+
+  start = ReadCoreTimer();
+  grb.refreshLEDs();
+  report("GRBrefreshLEDs", leds, 1, ReadCoreTimer() - start);
+
+  picxel_segment_t identity = {0, leds, 1};
+  grb.setIndexMap(&identity, 1);
+  start = ReadCoreTimer();
+  grb.refreshLEDs();
+  report("GRBstagedRefreshLEDs", leds, 1, ReadCoreTimer() - start);
+  grb.clearIndexMap();
+
+  PICxel hsv(leds, pin, HSV, noalloc);
+  hsv.setArrayPointer(buffer);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    for(uint16_t i = 0; i < leds; i++)
+      hsv.HSVsetLEDColor(i, (i + n) % 1536, 255, 128);
+  report("HSVsetLEDColor", leds, iterations, ReadCoreTimer() - start);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    hsv.clear();
+  report("HSVclear", leds, iterations, ReadCoreTimer() - start);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    hsv.fillRainbow(0, leds, n % 1536, (1536L << 16)/leds);
+  report("HSVfillRainbow", leds, iterations, ReadCoreTimer() - start);
+
+  uint32_t sum = 0;
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    for(uint16_t i = 0; i < leds; i++)
+      sum += hsv.HSVToColor(((i*7 + n) % 1536) | 0xFF800000);
+  report("HSVToColor", leds, iterations, ReadCoreTimer() - start);
+  benchSink = sum;
+
+  for(uint16_t i = 0; i < leds; i++)
+    hsv.HSVsetLEDColor(i, (i*15) % 1536, 255, 128);
+
+  start = ReadCoreTimer();
+  hsv.refreshLEDs();
+  report("HSVrefreshLEDs", leds, 1, ReadCoreTimer() - start);
+
+  hsv.setIndexMap(&identity, 1);
+  start = ReadCoreTimer();
+  hsv.refreshLEDs();
+  report("HSVstagedRefreshLEDs", leds, 1, ReadCoreTimer() - start);
+  hsv.clearIndexMap();
+
+  //a low entropy frame, eight colors in bars, with and without the cache
+  for(uint16_t i = 0; i < leds; i++)
+    hsv.HSVsetLEDColor(i, ((i/8) % 8)*192, 255, 128);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    outputBytes(hsv, leds);
+  report("HSVfillOutputBytes", leds, iterations, ReadCoreTimer() - start);
+
+  static PICxelHSVCache cache;
+  cache.clear();
+  hsv.setHSVCache(&cache);
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++)
+    outputBytes(hsv, leds);
+  report("HSVfillOutputBytesCached", leds, iterations, ReadCoreTimer() - start);
+  hsv.setHSVCache(NULL);
+
+  //batch conversion of the same frame, per pixel and through the cache
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++){
+    const uint8_t *hsvPtr = buffer;
+    for(uint16_t i = 0; i < leds; i++, hsvPtr += 4){
+      uint8_t *grbPtr = &benchChunk[3*(i % BENCH_CHUNK_LEDS)];
+      uint32_t color = hsv.HSVToColor(hsvPtr[0] | hsvPtr[1] << 8 | hsvPtr[2] << 16 | hsvPtr[3] << 24);
+      grbPtr[0] = color >> 8;
+      grbPtr[1] = color >> 16;
+      grbPtr[2] = color;
+    }
+  }
+  report("HSVConvert", leds, iterations, ReadCoreTimer() - start);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < iterations; n++){
+    for(uint16_t first = 0; first < leds; first += BENCH_CHUNK_LEDS){
+      uint16_t count = (leds - first < BENCH_CHUNK_LEDS) ? leds - first : BENCH_CHUNK_LEDS;
+      cache.convert(&buffer[4*first], benchChunk, count);
+    }
+  }
+  report("HSVConvertCached", leds, iterations, ReadCoreTimer() - start);
+  benchSink = cache.getHits();
+}
+
+/************************************************************************/
+/*  Reads the whole wire output of a strip a chunk at a time, as the    */
+/*  DMA backends do                                                     */
+/************************************************************************/
+void PICxelBench::outputBytes(PICxel &strip, uint16_t leds){
+  for(uint16_t first = 0; first < leds; first += BENCH_CHUNK_LEDS){
+    uint16_t count = (leds - first < BENCH_CHUNK_LEDS) ? leds - first : BENCH_CHUNK_LEDS;
+    strip.fillOutputBytes(benchChunk, first, count);
+  }
+  benchSink = benchChunk[0];
+}
+
+/************************************************************************/
+/*  Times the particle passes with a full pool.  The particles wrap and */
+/*  never expire, so every frame moves and renders all of them.         */
+/************************************************************************/
+void PICxelBench::runParticles(void){
+  static PICxelParticles<BENCH_PARTICLES> particles(BENCH_PARTICLE_LEDS, true);
+  uint32_t start;
+
+  PICxel grb(BENCH_PARTICLE_LEDS, pin, GRB, noalloc);
+  grb.setArrayPointer(buffer);
+
+  particles.clear();
+  for(uint16_t i = 0; i < BENCH_PARTICLES; i++)
+    particles.spawn((uint32_t)(i*BENCH_PARTICLE_LEDS/BENCH_PARTICLES) << 16,
+      (i & 1) ? 0x4000 + i*64 : -0x3000 - i*64, i*0x010305, 255, 255, 0);
+
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < BENCH_PARTICLE_FRAMES; n++)
+    particles.update();
+  report("ParticleUpdate", BENCH_PARTICLES, BENCH_PARTICLE_FRAMES, ReadCoreTimer() - start);
+
+  grb.clear();
+  start = ReadCoreTimer();
+  for(uint32_t n = 0; n < BENCH_PARTICLE_FRAMES; n++)
+    particles.render(grb);
+  report("ParticleRender", BENCH_PARTICLES, BENCH_PARTICLE_FRAMES, ReadCoreTimer() - start);
+  benchSink = particles.getCount();
+}
@@ -0,0 +1,41 @@
+/************************************************************************/
+/*  PICxelBench.h  - PIC32 Neopixel Library                             */
+/*                                                                      */
+/*  Benchmarks of the PICxel API and kernels, timed with the core       */
+/*  timer.  The same code runs on the board (PICxel_benchmark example)  */
+/*  and on the host (extras/tools/picxel_bench) and prints one CSV      */
+/*  line per kernel and strip size so releases can be diffed:           */
+/*                                                                      */
+/*    kernel,leds,iterations,ticks,ns_per_pixel                         */
+/*                                                                      */
+/*  ticks are core timer ticks (F_CPU/2) for all iterations.  For the   */
+/*  Particle kernels the leds column is the number of particles.        */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelBench_H
+#define PICxelBench_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+class PICxelBench{
+public:
+  PICxelBench(Print &out, uint8_t pin, uint8_t *buffer, uint32_t bufferBytes);
+
+  void run(void);
+  void runSize(uint16_t leds);
+  void runParticles(void);
+
+private:
+  void report(const char *kernel, uint16_t leds, uint32_t iterations, uint32_t ticks);
+  void outputBytes(PICxel &strip, uint16_t leds);
+
+  Print *out;
+  uint8_t pin;
+  uint8_t *buffer;
+  uint32_t bufferBytes;
+};
+#endif // PICxelBench_H
@@ -0,0 +1,302 @@
+/************************************************************************/
+/*  PICxelCommand.cpp  - PIC32 Neopixel Library                         */
+/*                                                                      */
+/*  Binary command stream parser for host controlled strips.            */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <string.h>
+#include "PICxelCommand.h"
+
+static inline uint16_t read16(const uint8_t *data){
+  return data[0] | data[1] << 8;
+}
+
+/************************************************************************/
+/*  Construction for the PICxelCommand class                            */
+/************************************************************************/
+PICxelCommand::PICxelCommand(PICxel &strip) : strip(&strip), effectHandler(NULL),
+  backBuffer(NULL), received(0), discard(0), commandCount(0), errorCount(0){
+}
+
+/************************************************************************/
+/*  Sets the function EFFECT commands are passed to.  The library has   */
+/*  no effects of its own, the sketch maps ids to its effects.          */
+/************************************************************************/
+void PICxelCommand::setEffectHandler(picxel_effect_handler_t handler){
+  effectHandler = handler;
+}
+
+/************************************************************************/
+/*  Enables double buffering.  buffer must be the size of the           */
+/*  colorArray.  Commands then draw into the back buffer while the      */
+/*  strip shows the front one, and SWAP exchanges the two and           */
+/*  refreshes.  The new back buffer holds the frame before last, so the */
+/*  host should redraw every LED it cares about each frame.             */
+/************************************************************************/
+void PICxelCommand::setBackBuffer(uint8_t *buffer){
+  backBuffer = buffer;
+}
+
+/************************************************************************/
+/*  Returns the size of the command starting at command, or 0 for an    */
+/*  unknown op code.  Until the header is complete the size of the      */
+/*  header is returned.                                                 */
+/************************************************************************/
+uint32_t PICxelCommand::commandSize(const uint8_t *command, uint32_t left){
+  switch(command[0]){
+    case PICXEL_CMD_FILL:
+      return 8;
+    case PICXEL_CMD_SPAN:
+      return (left >= 5) ? 5 + 3*(uint32_t)read16(&command[3]) : 5;
+    case PICXEL_CMD_HSV_SPAN:
+      return (left >= 5) ? 5 + 4*(uint32_t)read16(&command[3]) : 5;
+    case PICXEL_CMD_BRIGHTNESS:
+      return 2;
+    case PICXEL_CMD_EFFECT:
+      return (left >= 3) ? 3 + command[2] : 3;
+    case PICXEL_CMD_REFRESH:
+    case PICXEL_CMD_SWAP:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/************************************************************************/
+/*  Applies every complete command in data, in place.  Returns the      */
+/*  number of bytes used, a trailing partial command is left for the    */
+/*  caller to pass again once the rest has arrived.                     */
+/************************************************************************/
+uint32_t PICxelCommand::process(const uint8_t *data, uint32_t length){
+  uint32_t position = 0;
+  uint8_t bytesPerLED = strip->getBytesPerLED();
+
+  while(position < length){
+    const uint8_t *command = &data[position];
+    uint32_t left = length - position;
+    uint32_t size = commandSize(command, left);
+
+    if(size == 0){
+      //resynchronize on the next byte
+      errorCount++;
+      position++;
+      continue;
+    }
+    if(size > left)
+      break;
+
+    switch(command[0]){
+      case PICXEL_CMD_FILL:
+        if(bytesPerLED == 3)
+          fill(read16(&command[1]), read16(&command[3]), &command[5]);
+        else
+          errorCount++;
+        break;
+      case PICXEL_CMD_SPAN:
+        if(bytesPerLED == 3)
+          span(read16(&command[1]), read16(&command[3]), &command[5]);
+        else
+          errorCount++;
+        break;
+      case PICXEL_CMD_HSV_SPAN:
+        hsvSpan(read16(&command[1]), read16(&command[3]), &command[5]);
+        break;
+      case PICXEL_CMD_BRIGHTNESS:
+        strip->setBrightness(command[1]);
+        break;
+      case PICXEL_CMD_EFFECT:
+        if(effectHandler != NULL)
+          effectHandler(command[1], &command[3], command[2]);
+        break;
+      case PICXEL_CMD_REFRESH:
+        strip->refreshLEDs();
+        break;
+      case PICXEL_CMD_SWAP:
+        swap();
+        break;
+    }
+
+    commandCount++;
+    position += size;
+  }
+
+  return position;
+}
+
+/************************************************************************/
+/*  Reads what the serial driver has buffered into the receive buffer   */
+/*  and processes it.  A command longer than PICXEL_COMMAND_BUFFER can  */
+/*  never complete and is dropped, so hosts should split long spans.    */
+/*  The rest of its payload is skipped as it arrives, so it is never    */
+/*  parsed as commands.                                                 */
+/*  Returns true if any command was applied.                            */
+/************************************************************************/
+bool PICxelCommand::poll(Stream &stream){
+  uint32_t count = commandCount;
+  uint32_t used;
+
+  while(discard > 0 && stream.available() > 0){
+    stream.read();
+    discard--;
+  }
+  if(discard > 0)
+    return false;
+
+  while(stream.available() > 0 && received < PICXEL_COMMAND_BUFFER)
+    receiveBuffer[received++] = stream.read();
+
+  used = process(receiveBuffer, received);
+  received -= used;
+  memmove(receiveBuffer, &receiveBuffer[used], received);
+
+  if(received == PICXEL_COMMAND_BUFFER){
+    errorCount++;
+    discard = commandSize(receiveBuffer, received) - received;
+    received = 0;
+  }
+
+  return commandCount != count;
+}
+
+/************************************************************************/
+/*  Returns the colorArray commands draw into                           */
+/************************************************************************/
+uint8_t* PICxelCommand::drawBuffer(void){
+  return (backBuffer != NULL) ? backBuffer : strip->getColorArray();
+}
+
+/************************************************************************/
+/*  Writes one GRB color over a range.  The first LED is written, then  */
+/*  the filled part is copied onto the rest, doubling each time.        */
+/************************************************************************/
+void PICxelCommand::fill(uint16_t first, uint16_t count, const uint8_t *color){
+  uint16_t leds = strip->getNumberOfLEDs();
+  uint8_t brightness = strip->getBrightness();
+
+  if(first >= leds || count == 0)
+    return;
+  if(count > leds - first)
+    count = leds - first;
+
+  uint8_t *dst = &drawBuffer()[3*first];
+  uint32_t total = 3*(uint32_t)count;
+  uint32_t filled = 3;
+
+  if(backBuffer == NULL)
+    strip->beginPowerUpdate(first, count);
+
+  for(uint8_t i = 0; i < 3; i++)
+    dst[i] = (brightness != 255) ? (color[i]*brightness) >> 8 : color[i];
+  while(filled < total){
+    uint32_t n = (filled < total - filled) ? filled : total - filled;
+    memcpy(&dst[filled], dst, n);
+    filled += n;
+  }
+
+  if(backBuffer == NULL)
+    strip->endPowerUpdate(first, count);
+}
+
+/************************************************************************/
+/*  Copies GRB colors over a range, scaled if the brightness is not     */
+/*  full                                                                */
+/************************************************************************/
+void PICxelCommand::span(uint16_t first, uint16_t count, const uint8_t *colors){
+  uint16_t leds = strip->getNumberOfLEDs();
+  uint8_t brightness = strip->getBrightness();
+
+  if(first >= leds || count == 0)
+    return;
+  if(count > leds - first)
+    count = leds - first;
+
+  uint8_t *dst = &drawBuffer()[3*first];
+  uint32_t total = 3*(uint32_t)count;
+
+  if(backBuffer == NULL)
+    strip->beginPowerUpdate(first, count);
+
+  if(brightness == 255){
+    memcpy(dst, colors, total);
+  }
+  else{
+    for(uint32_t i = 0; i < total; i++)
+      dst[i] = (colors[i]*brightness) >> 8;
+  }
+
+  if(backBuffer == NULL)
+    strip->endPowerUpdate(first, count);
+}
+
+/************************************************************************/
+/*  Copies HSV colors over a range.  An HSV strip takes them as they    */
+/*  are, a GRB strip gets them converted and scaled.                    */
+/************************************************************************/
+void PICxelCommand::hsvSpan(uint16_t first, uint16_t count, const uint8_t *colors){
+  uint16_t leds = strip->getNumberOfLEDs();
+  uint8_t brightness = strip->getBrightness();
+
+  if(first >= leds || count == 0)
+    return;
+  if(count > leds - first)
+    count = leds - first;
+
+  if(backBuffer == NULL)
+    strip->beginPowerUpdate(first, count);
+
+  if(strip->getBytesPerLED() == 4){
+    memcpy(&drawBuffer()[4*first], colors, 4*(uint32_t)count);
+  }
+  else{
+    uint8_t *dst = &drawBuffer()[3*first];
+    for(uint16_t i = 0; i < count; i++, colors += 4, dst += 3){
+      uint32_t color = 0;
+      //a value of zero is off, as in HSVrefreshLEDs()
+      if(colors[3])
+        color = strip->HSVToColor(colors[0] | colors[1] << 8 | colors[2] << 16 | colors[3] << 24);
+      dst[0] = (uint8_t)(color >> 8);
+      dst[1] = (uint8_t)(color >> 16);
+      dst[2] = (uint8_t)color;
+      if(brightness != 255){
+        dst[0] = (dst[0]*brightness) >> 8;
+        dst[1] = (dst[1]*brightness) >> 8;
+        dst[2] = (dst[2]*brightness) >> 8;
+      }
+    }
+  }
+
+  if(backBuffer == NULL)
+    strip->endPowerUpdate(first, count);
+}
+
+/************************************************************************/
+/*  Shows the back buffer and makes the old front buffer the new back   */
+/*  buffer.  Without a back buffer this is just a refresh.              */
+/************************************************************************/
+void PICxelCommand::swap(void){
+  if(backBuffer != NULL){
+    uint8_t *front = strip->getColorArray();
+    strip->setArrayPointer(backBuffer);
+    backBuffer = front;
+    strip->recomputePowerEstimate();
+  }
+  strip->refreshLEDs();
+}
+
+/************************************************************************/
+/*  Returns the number of commands applied                              */
+/************************************************************************/
+uint32_t PICxelCommand::getCommandCount(void){
+  return commandCount;
+}
+
+/************************************************************************/
+/*  Returns the number of bad op codes, commands that do not fit the    */
+/*  strip's color mode and commands too long for the receive buffer     */
+/************************************************************************/
+uint32_t PICxelCommand::getErrorCount(void){
+  return errorCount;
+}
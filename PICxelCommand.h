@@ -0,0 +1,79 @@
+/************************************************************************/
+/*  PICxelCommand.h  - PIC32 Neopixel Library                           */
+/*                                                                      */
+/*  Compact binary command stream for driving a strip from a host.      */
+/*  Commands are parsed in place from the buffer they were received     */
+/*  into and applied to the colorArray in bulk, a run or span at a      */
+/*  time instead of one setter call per LED.                            */
+/*                                                                      */
+/*  Every command is an op code followed by its payload, 16-bit values  */
+/*  little endian, colors as sent (brightness is applied on the board): */
+/*    FILL       first count green red blue    one color over a range   */
+/*    SPAN       first count (green red blue)*count                     */
+/*    HSV_SPAN   first count (hue lo hue hi sat val)*count              */
+/*    BRIGHTNESS level                                                  */
+/*    EFFECT     id length params*length      passed to the handler     */
+/*    REFRESH                                 refreshLEDs()             */
+/*    SWAP                                    show the back buffer      */
+/*  Ranges are clipped to the strip.  HSV spans on a GRB strip are      */
+/*  converted with HSVToColor(), GRB spans on an HSV strip are an       */
+/*  error.  An unknown op code counts an error and skips one byte.      */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelCommand_H
+#define PICxelCommand_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+#define PICXEL_CMD_FILL        0x01
+#define PICXEL_CMD_SPAN        0x02
+#define PICXEL_CMD_HSV_SPAN    0x03
+#define PICXEL_CMD_BRIGHTNESS  0x04
+#define PICXEL_CMD_EFFECT      0x05
+#define PICXEL_CMD_REFRESH     0x06
+#define PICXEL_CMD_SWAP        0x07
+
+//receive buffer used by poll(), the largest command it can hold
+#define PICXEL_COMMAND_BUFFER  512
+
+typedef void (*picxel_effect_handler_t)(uint8_t id, const uint8_t *params, uint8_t length);
+
+class PICxelCommand{
+public:
+  PICxelCommand(PICxel &strip);
+
+  uint32_t process(const uint8_t *data, uint32_t length);
+  bool poll(Stream &stream);
+
+  void setEffectHandler(picxel_effect_handler_t handler);
+  void setBackBuffer(uint8_t *buffer);
+
+  uint32_t getCommandCount(void);
+  uint32_t getErrorCount(void);
+
+private:
+  static uint32_t commandSize(const uint8_t *command, uint32_t left);
+  uint8_t* drawBuffer(void);
+  void fill(uint16_t first, uint16_t count, const uint8_t *color);
+  void span(uint16_t first, uint16_t count, const uint8_t *colors);
+  void hsvSpan(uint16_t first, uint16_t count, const uint8_t *colors);
+  void swap(void);
+
+  PICxel *strip;
+  picxel_effect_handler_t effectHandler;
+  uint8_t *backBuffer;
+
+//poll() receive buffer
+  uint8_t receiveBuffer[PICXEL_COMMAND_BUFFER];
+  uint16_t received;
+  uint32_t discard;   //payload of a dropped command still to skip
+
+//statistics
+  uint32_t commandCount;
+  uint32_t errorCount;
+};
+#endif // PICxelCommand_H
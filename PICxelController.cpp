@@ -0,0 +1,247 @@
+/************************************************************************/
+/*  PICxelController.cpp  - PIC32 Neopixel Library                      */
+/*                                                                      */
+/*  Groups several PICxel strips behind one virtual pixel range.        */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelController.h"
+
+/************************************************************************/
+/*  Construction for the PICxelController class                         */
+/************************************************************************/
+PICxelController::PICxelController(void) : numberOfStrips(0), lastStrip(0){
+  //getStrip() reads firstLED[lastStrip + 1] before any strip is added
+  for(uint8_t s = 0; s <= PICXEL_MAX_STRIPS; s++)
+    firstLED[s] = 0;
+  for(uint8_t s = 0; s < PICXEL_MAX_STRIPS; s++){
+    strips[s] = NULL;
+    portGroup[s] = s;
+  }
+}
+
+/************************************************************************/
+/*  Appends a strip to the end of the virtual range.  GRB strips on the */
+/*  same PORT as an earlier GRB strip join its lockstep group.  Returns */
+/*  false when PICXEL_MAX_STRIPS strips have already been added.        */
+/************************************************************************/
+bool PICxelController::addStrip(PICxel &strip){
+  if(numberOfStrips >= PICXEL_MAX_STRIPS)
+    return false;
+
+  uint8_t s = numberOfStrips;
+  strips[s] = &strip;
+  firstLED[s + 1] = firstLED[s] + strip.getNumberOfLEDs();
+
+  portGroup[s] = s;
+  if(strip.getBytesPerLED() == 3){
+    for(uint8_t i = 0; i < s; i++){
+      if(strips[i]->getBytesPerLED() == 3 && strips[i]->portSet == strip.portSet){
+        portGroup[s] = portGroup[i];
+        break;
+      }
+    }
+  }
+
+  numberOfStrips++;
+  return true;
+}
+
+/************************************************************************/
+/*  Calls begin() on every strip.  Returns false if any strip's core    */
+/*  clock is too slow for the LEDs.                                     */
+/************************************************************************/
+bool PICxelController::begin(void){
+  bool timing = true;
+  for(uint8_t i = 0; i < numberOfStrips; i++)
+    timing &= strips[i]->begin();
+  return timing;
+}
+
+/************************************************************************/
+/*  Finds the strip holding the virtual LED number and the LED index    */
+/*  within that strip.  The last strip hit is checked first, since      */
+/*  effects mostly write LEDs in order.  Returns NULL out of range.     */
+/************************************************************************/
+PICxel* PICxelController::getStrip(uint32_t number, uint16_t *localNumber){
+  uint8_t s = lastStrip;
+
+  if(number < firstLED[s] || number >= firstLED[s + 1]){
+    for(s = 0; s < numberOfStrips; s++)
+      if(number < firstLED[s + 1])
+        break;
+    if(s == numberOfStrips)
+      return NULL;
+    lastStrip = s;
+  }
+
+  *localNumber = number - firstLED[s];
+  return strips[s];
+}
+
+/************************************************************************/
+/*  Virtual index versions of the PICxel color setters                  */
+/************************************************************************/
+void PICxelController::GRBsetLEDColor(uint32_t number, uint8_t green, uint8_t red, uint8_t blue){
+  uint16_t local;
+  PICxel *strip = getStrip(number, &local);
+  if(strip != NULL)
+    strip->GRBsetLEDColor(local, green, red, blue);
+}
+
+void PICxelController::GRBsetLEDColor(uint32_t number, uint32_t color){
+  uint16_t local;
+  PICxel *strip = getStrip(number, &local);
+  if(strip != NULL)
+    strip->GRBsetLEDColor(local, color);
+}
+
+void PICxelController::setLEDColorRGB(uint32_t number, uint32_t color){
+  uint16_t local;
+  PICxel *strip = getStrip(number, &local);
+  if(strip != NULL)
+    strip->setLEDColorRGB(local, color);
+}
+
+void PICxelController::HSVsetLEDColor(uint32_t number, uint16_t hue, uint8_t sat, uint8_t val){
+  uint16_t local;
+  PICxel *strip = getStrip(number, &local);
+  if(strip != NULL)
+    strip->HSVsetLEDColor(local, hue, sat, val);
+}
+
+void PICxelController::HSVsetLEDColor(uint32_t number, uint32_t color){
+  uint16_t local;
+  PICxel *strip = getStrip(number, &local);
+  if(strip != NULL)
+    strip->HSVsetLEDColor(local, color);
+}
+
+/************************************************************************/
+/*  Clears every strip                                                  */
+/************************************************************************/
+void PICxelController::clear(void){
+  for(uint8_t i = 0; i < numberOfStrips; i++)
+    strips[i]->clear();
+}
+
+/************************************************************************/
+/*  Sets the brightness of every strip                                  */
+/************************************************************************/
+void PICxelController::setBrightness(uint8_t b){
+  for(uint8_t i = 0; i < numberOfStrips; i++)
+    strips[i]->setBrightness(b);
+}
+
+/************************************************************************/
+/*  Refreshes every strip.  Each lockstep group is sent once, by its    */
+/*  first strip, strips alone on their PORT use their own refresh.      */
+/************************************************************************/
+void PICxelController::refreshLEDs(void){
+  for(uint8_t s = 0; s < numberOfStrips; s++){
+    if(portGroup[s] != s)
+      continue;
+
+    bool shared = false;
+    for(uint8_t i = s + 1; i < numberOfStrips; i++)
+      if(portGroup[i] == s)
+        shared = true;
+
+    if(shared)
+      lockstepRefresh(s);
+    else
+      strips[s]->refreshLEDs();
+  }
+}
+
+/************************************************************************/
+/*  Sends every GRB strip of a port group with one bitstream.  All of   */
+/*  the group's pins go high together, the pins sending a 0 bit drop    */
+/*  after T0H and the rest after T1H.  Strips of different lengths      */
+/*  leave the stream as they run out of bytes.                          */
+/*                                                                      */
+/*  The masks for all eight bits of a byte are built before the byte   */
+/*  is sent, only stretching the low time between bytes.  The pins      */
+/*  sending a 1 stay high for GRB_delay_T1H_minus_T0H() after the zero  */
+/*  pins drop, so both bits have the high times of GRBrefreshLEDs().    */
+/*  extras/tools/picxel_lockstep_check checks this for every nop table. */
+/************************************************************************/
+void PICxelController::lockstepRefresh(uint8_t group){
+  PICXEL_TRACE(PICXEL_TRACE_REFRESH_START, group);
+  volatile uint32_t *portSet = strips[group]->portSet;
+  volatile uint32_t *portClr = strips[group]->portClr;
+  uint8_t *arrays[PICXEL_MAX_STRIPS];
+  uint32_t lengths[PICXEL_MAX_STRIPS];
+  uint32_t masks[PICXEL_MAX_STRIPS];
+  uint32_t zeroMask[8];
+  uint32_t maxLength = 0;
+  uint8_t count = 0;
+
+  for(uint8_t s = group; s < numberOfStrips; s++){
+    if(portGroup[s] != group)
+      continue;
+    //strips with an output stage cannot share the bitstream
+    if(strips[s]->hasOutputStage()){
+      strips[s]->refreshLEDs();
+      continue;
+    }
+    arrays[count] = strips[s]->getColorArray();
+    lengths[count] = 3*(uint32_t)strips[s]->getNumberOfLEDs();
+    masks[count] = strips[s]->pinMask;
+    if(lengths[count] > maxLength)
+      maxLength = lengths[count];
+    count++;
+  }
+
+  if(count == 0)
+    return;
+
+  uint32_t interruptBits = disableInterrupts();
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_OFF, group);
+
+  for(uint32_t j = 0; j < maxLength; j++){
+    uint32_t activeMask = 0;
+
+    for(uint8_t b = 0; b < 8; b++)
+      zeroMask[b] = 0;
+
+    for(uint8_t i = 0; i < count; i++){
+      if(j >= lengths[i])
+        continue;
+      activeMask |= masks[i];
+      uint8_t data = arrays[i][j];
+      for(uint8_t b = 0; b < 8; b++)
+        if(!(data & (0x80 >> b)))
+          zeroMask[b] |= masks[i];
+    }
+
+    for(uint8_t b = 0; b < 8; b++){
+      *portSet = activeMask;
+      GRB_delay_T0H();
+      *portClr = zeroMask[b];
+      GRB_delay_T1H_minus_T0H();
+      *portClr = activeMask;
+      GRB_delay_T1L();
+    }
+  }
+
+  PICXEL_TRACE(PICXEL_TRACE_LAST_BIT, group);
+  restoreInterrupts(interruptBits);
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_ON, group);
+}
+
+/************************************************************************/
+/*  Returns the number of strips added                                  */
+/************************************************************************/
+uint8_t PICxelController::getNumberOfStrips(void){
+  return numberOfStrips;
+}
+
+/************************************************************************/
+/*  Returns the length of the virtual range                             */
+/************************************************************************/
+uint32_t PICxelController::getNumberOfLEDs(void){
+  return firstLED[numberOfStrips];
+}
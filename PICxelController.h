@@ -0,0 +1,55 @@
+/************************************************************************/
+/*  PICxelController.h  - PIC32 Neopixel Library                        */
+/*                                                                      */
+/*  Groups several PICxel strips (any pins, lengths and color modes)    */
+/*  behind one contiguous virtual pixel range.  Index 0 is the first    */
+/*  LED of the first strip added, strips follow in the order added.     */
+/*                                                                      */
+/*  refreshLEDs() refreshes every strip in one call.  GRB strips that   */
+/*  share a PORT are sent in lockstep, one bitstream drives all of      */
+/*  their pins at once.                                                 */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelController_H
+#define PICxelController_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+#define PICXEL_MAX_STRIPS 8
+
+class PICxelController{
+public:
+  PICxelController(void);
+
+  bool addStrip(PICxel &strip);
+  bool begin(void);
+  void refreshLEDs(void);
+
+  void GRBsetLEDColor(uint32_t number, uint8_t green, uint8_t red, uint8_t blue);
+  void GRBsetLEDColor(uint32_t number, uint32_t color);
+  void setLEDColorRGB(uint32_t number, uint32_t color);
+
+  void HSVsetLEDColor(uint32_t number, uint16_t hue, uint8_t sat, uint8_t val);
+  void HSVsetLEDColor(uint32_t number, uint32_t color);
+
+  void clear(void);
+  void setBrightness(uint8_t b);
+
+  PICxel* getStrip(uint32_t number, uint16_t *localNumber);
+  uint8_t getNumberOfStrips(void);
+  uint32_t getNumberOfLEDs(void);
+
+private:
+  void lockstepRefresh(uint8_t group);
+
+  PICxel *strips[PICXEL_MAX_STRIPS];
+  uint32_t firstLED[PICXEL_MAX_STRIPS + 1];
+  uint8_t portGroup[PICXEL_MAX_STRIPS];
+  uint8_t numberOfStrips;
+  uint8_t lastStrip;
+};
+#endif // PICxelController_H
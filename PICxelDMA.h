@@ -0,0 +1,137 @@
+/************************************************************************/
+/*  PICxelDMA.h  - PIC32 Neopixel Library                               */
+/*                                                                      */
+/*  Minimal access to the PIC32 DMA controller for the hardware output  */
+/*  backends.  Every channel has the same block of twelve registers,    */
+/*  each with its CLR, SET and INV aliases, so a channel is addressed   */
+/*  as a struct at DCH0CON plus 0xC0 per channel.                       */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelDMA_H
+#define PICxelDMA_H
+
+#include <WProgram.h>
+#include <stdint.h>
+
+#ifdef __mips__
+#include <sys/kmem.h>
+#endif
+
+//register with its CLR, SET and INV aliases
+typedef struct{
+  volatile uint32_t reg;
+  volatile uint32_t clr;
+  volatile uint32_t set;
+  volatile uint32_t inv;
+} picxel_sfr_t;
+
+typedef struct{
+  picxel_sfr_t CON;
+  picxel_sfr_t ECON;
+  picxel_sfr_t INT;
+  picxel_sfr_t SSA;
+  picxel_sfr_t DSA;
+  picxel_sfr_t SSIZ;
+  picxel_sfr_t DSIZ;
+  picxel_sfr_t SPTR;
+  picxel_sfr_t DPTR;
+  picxel_sfr_t CSIZ;
+  picxel_sfr_t CPTR;
+  picxel_sfr_t DAT;
+} picxel_dma_channel_t;
+
+//DCHxCON bits
+#define PICXEL_DMA_CHEN     0x0080
+#define PICXEL_DMA_CHAEN    0x0010
+#define PICXEL_DMA_CHPRI3   0x0003
+
+//DCHxECON bits, the start IRQ goes in bits 15-8
+#define PICXEL_DMA_SIRQEN   0x0010
+
+//DCHxINT flags
+#define PICXEL_DMA_CHSDIF   0x0080
+#define PICXEL_DMA_CHSHIF   0x0040
+#define PICXEL_DMA_CHDDIF   0x0020
+#define PICXEL_DMA_CHDHIF   0x0010
+#define PICXEL_DMA_CHBCIF   0x0008
+#define PICXEL_DMA_CHERIF   0x0001
+
+/* Older PIC32MX parts (3xx/4xx, e.g. the UNO32) only have 8-bit source
+ * and destination sizes, so no transfer may move more than 256 bytes.
+ * The others have 16-bit sizes.  The host takes the smaller limit.
+ */
+#if defined(__PIC32MZ__) || (defined(__PIC32_FEATURE_SET__) && \
+    (__PIC32_FEATURE_SET__ < 300 || __PIC32_FEATURE_SET__ >= 500))
+#define PICXEL_DMA_MAX_BYTES 65535
+#else
+#define PICXEL_DMA_MAX_BYTES 256
+#endif
+
+#define PICXEL_DMA_CHANNELS  4
+
+/* DMA sees RAM, not the data cache.  The PIC32MX has no data cache, the
+ * PIC32MZ caches KSEG0 with 16 byte lines.  Buffers DMA reads are written
+ * back once the CPU has filled them, buffers DMA writes are read through
+ * their uncached KSEG1 alias and take whole cache lines, so no dirty line
+ * shared with other data can be written back over them.
+ */
+#define PICXEL_DMA_CACHE_LINE 16
+#define PICXEL_DMA_ALIGNED __attribute__((aligned(PICXEL_DMA_CACHE_LINE)))
+
+#ifdef __mips__
+/************************************************************************/
+/*  Returns the registers of DMA channel number                         */
+/************************************************************************/
+static inline picxel_dma_channel_t* PICxelDMAchannel(uint8_t number){
+  return (picxel_dma_channel_t*)((uint32_t)&DCH0CON + 0xC0*number);
+}
+
+/************************************************************************/
+/*  Turns the DMA controller on and sets up a channel to move one cell  */
+/*  of cellSize bytes from source to destination on every startIRQ      */
+/*  event.  The channel is left disabled.                               */
+/************************************************************************/
+static inline void PICxelDMAsetup(picxel_dma_channel_t *channel, const void *source,
+  uint16_t sourceSize, volatile void *destination, uint16_t destinationSize,
+  uint16_t cellSize, uint8_t startIRQ){
+  DMACONSET = 0x8000;
+
+  channel->CON.reg = PICXEL_DMA_CHPRI3;
+  channel->ECON.reg = ((uint32_t)startIRQ << 8) | PICXEL_DMA_SIRQEN;
+  channel->INT.reg = 0;
+  channel->SSA.reg = KVA_TO_PA(source);
+  channel->DSA.reg = KVA_TO_PA(destination);
+  channel->SSIZ.reg = sourceSize;
+  channel->DSIZ.reg = destinationSize;
+  channel->CSIZ.reg = cellSize;
+}
+
+/************************************************************************/
+/*  Writes back and invalidates the data cache lines holding bytes at   */
+/*  buffer, so a DMA transfer reads what the CPU wrote                  */
+/************************************************************************/
+static inline void PICxelDMAwriteback(const volatile void *buffer, uint32_t bytes){
+#if defined(__PIC32MZ__)
+  uint32_t end = (uint32_t)buffer + bytes;
+
+  for(uint32_t line = (uint32_t)buffer & ~(PICXEL_DMA_CACHE_LINE - 1); line < end;
+      line += PICXEL_DMA_CACHE_LINE)
+    __asm__ volatile("cache 0x15, 0(%0)" : : "r"(line) : "memory");
+  __asm__ volatile("sync" : : : "memory");
+#else
+  (void)buffer;
+  (void)bytes;
+#endif
+}
+
+/************************************************************************/
+/*  Returns the uncached KSEG1 alias of a buffer a DMA transfer writes  */
+/************************************************************************/
+static inline const volatile void* PICxelDMAuncached(const volatile void *buffer){
+  return (const volatile void*)KVA0_TO_KVA1((uint32_t)buffer);
+}
+#endif
+
+#endif // PICxelDMA_H
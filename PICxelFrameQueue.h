@@ -0,0 +1,149 @@
+/************************************************************************/
+/*  PICxelFrameQueue.h  - PIC32 Neopixel Library                        */
+/*                                                                      */
+/*  Fixed capacity queue of timestamped frame buffers between one       */
+/*  producer (serial receiver, animation decoder, an ISR driven         */
+/*  generator) and the main loop refreshing the strip.  The producer    */
+/*  renders ahead into free slots, the consumer shows each frame at its */
+/*  presentation time by pointing the strip at the slot, no copy.       */
+/*                                                                      */
+/*  The producer only writes head and the consumer only writes tail,    */
+/*  both single byte stores, so either side may run in an interrupt     */
+/*  without locking.  One slot is always held back for the frame on     */
+/*  display, a queue of DEPTH slots holds DEPTH-1 pending frames.       */
+/*                                                                      */
+/*  Timestamps are in any free running unit (millis(), micros(), core   */
+/*  timer ticks) and compared wrap safe.                                */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelFrameQueue_H
+#define PICxelFrameQueue_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+//keeps the compiler from moving frame writes past the index update
+#define PICXEL_QUEUE_BARRIER() __asm__ volatile("" ::: "memory")
+
+template<uint32_t FRAME_BYTES, uint8_t DEPTH>
+class PICxelFrameQueue{
+public:
+/************************************************************************/
+/*  framePeriod is the nominal time between frames, used to count       */
+/*  underruns.  0 disables underrun counting.                           */
+/************************************************************************/
+  PICxelFrameQueue(uint32_t framePeriod = 0) : head(0), tail(0),
+    framePeriod(framePeriod), nextDue(0), started(false),
+    fullCount(0), skipCount(0), underrunCount(0){
+  }
+
+/************************************************************************/
+/*  Producer side.  Returns the next free frame buffer to render into,  */
+/*  or NULL when the queue is full, which counts as a dropped frame.    */
+/************************************************************************/
+  uint8_t* acquire(void){
+    if(next(head) == tail){
+      fullCount++;
+      return NULL;
+    }
+    return frames[head];
+  }
+
+/************************************************************************/
+/*  Producer side.  Queues the buffer returned by acquire() for display */
+/*  at presentTime.  Frames must be committed in presentation order.    */
+/************************************************************************/
+  void commit(uint32_t presentTime){
+    timestamps[head] = presentTime;
+    PICXEL_QUEUE_BARRIER();
+    head = next(head);
+  }
+
+/************************************************************************/
+/*  Consumer side.  Shows the newest frame that is due at now, frames   */
+/*  that were overtaken are dropped.  The strip is pointed at the slot  */
+/*  and refreshed.  Returns true if a frame was shown.  A strip larger  */
+/*  than FRAME_BYTES is left alone and the frame counted as dropped.    */
+/*                                                                      */
+/*  head is loaded once before any timestamp is read, so every slot     */
+/*  this pass looks at was committed with its timestamp in place.       */
+/************************************************************************/
+  bool service(PICxel &strip, uint32_t now){
+    uint8_t slot = tail;
+    uint8_t last = head;
+    PICXEL_QUEUE_BARRIER();
+
+    if(slot == last || (int32_t)(now - timestamps[slot]) < 0){
+      if(framePeriod && started && (int32_t)(now - nextDue) >= 0){
+        underrunCount++;
+        nextDue += framePeriod;
+      }
+      return false;
+    }
+
+    while(next(slot) != last && (int32_t)(now - timestamps[next(slot)]) >= 0){
+      slot = next(slot);
+      skipCount++;
+    }
+
+    if(!strip.setArrayPointer(frames[slot], FRAME_BYTES)){
+      skipCount++;
+      PICXEL_QUEUE_BARRIER();
+      tail = next(slot);
+      return false;
+    }
+    strip.recomputePowerEstimate();
+    strip.refreshLEDs();
+
+    nextDue = timestamps[slot] + framePeriod;
+    started = true;
+    PICXEL_QUEUE_BARRIER();
+    tail = next(slot);
+    return true;
+  }
+
+/************************************************************************/
+/*  Returns the number of frames waiting to be shown                    */
+/************************************************************************/
+  uint8_t pending(void){
+    uint8_t h = head;
+    uint8_t t = tail;
+    return (h >= t) ? (h - t) : (DEPTH - t + h);
+  }
+
+/************************************************************************/
+/*  Frames dropped because the queue was full or they were overtaken.   */
+/*  Each side counts its own drops so neither counter has two writers.  */
+/************************************************************************/
+  uint32_t getDropCount(void){
+    return fullCount + skipCount;
+  }
+
+/************************************************************************/
+/*  Frame periods that passed with no frame ready to show               */
+/************************************************************************/
+  uint32_t getUnderrunCount(void){
+    return underrunCount;
+  }
+
+private:
+  static inline uint8_t next(uint8_t index){
+    return (index + 1 == DEPTH) ? 0 : index + 1;
+  }
+
+  uint8_t frames[DEPTH][FRAME_BYTES] __attribute__((aligned(4)));
+  uint32_t timestamps[DEPTH];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+
+  uint32_t framePeriod;
+  uint32_t nextDue;
+  bool started;
+  volatile uint32_t fullCount;
+  volatile uint32_t skipCount;
+  uint32_t underrunCount;
+};
+#endif // PICxelFrameQueue_H
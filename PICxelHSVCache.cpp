@@ -0,0 +1,81 @@
+/************************************************************************/
+/*  PICxelHSVCache.cpp  - PIC32 Neopixel Library                        */
+/*                                                                      */
+/*  Direct mapped cache of HSV to RGB conversions.                      */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelHSVCache.h"
+#include "PICxel.h"
+
+/************************************************************************/
+/*  Construction for the PICxelHSVCache class, starts empty             */
+/************************************************************************/
+PICxelHSVCache::PICxelHSVCache(void) : hits(0), misses(0){
+  clear();
+}
+
+/************************************************************************/
+/*  Converts and stores a word that was not in the cache, replacing     */
+/*  whatever shared its entry.  HSVToColorReference() gives the same    */
+/*  colors as the assembly HSVToColor() and needs no PICxel object.     */
+/************************************************************************/
+uint32_t PICxelHSVCache::miss(uint32_t HSV, uint32_t index){
+  uint32_t color = 0;
+
+  misses++;
+  if(HSV >> 24)
+    color = PICxel::HSVToColorReference(HSV);
+  keys[index] = HSV;
+  colors[index] = color;
+  return color;
+}
+
+/************************************************************************/
+/*  Converts count LEDs of an HSV colorArray to green, red, blue bytes, */
+/*  e.g. into the colorArray of a GRB strip.  The colors are not scaled */
+/*  by any brightness.                                                  */
+/************************************************************************/
+void PICxelHSVCache::convert(const uint8_t *hsv, uint8_t *grb, uint16_t count){
+  for(uint16_t i = 0; i < count; i++, hsv += 4, grb += 3){
+    uint32_t color = lookup(hsv[0] | hsv[1] << 8 | hsv[2] << 16 | (uint32_t)hsv[3] << 24);
+    grb[0] = color >> 8;
+    grb[1] = color >> 16;
+    grb[2] = color;
+  }
+}
+
+/************************************************************************/
+/*  Empties the cache.  Every entry holds the word 0, which is off, so  */
+/*  no valid flag is needed.                                            */
+/************************************************************************/
+void PICxelHSVCache::clear(void){
+  for(uint16_t i = 0; i < PICXEL_HSV_CACHE_ENTRIES; i++){
+    keys[i] = 0;
+    colors[i] = 0;
+  }
+}
+
+/************************************************************************/
+/*  Returns the number of lookups found in the cache                    */
+/************************************************************************/
+uint32_t PICxelHSVCache::getHits(void){
+  return hits;
+}
+
+/************************************************************************/
+/*  Returns the number of lookups that had to convert                   */
+/************************************************************************/
+uint32_t PICxelHSVCache::getMisses(void){
+  return misses;
+}
+
+/************************************************************************/
+/*  Zeroes the hit and miss counters                                    */
+/************************************************************************/
+void PICxelHSVCache::resetCounters(void){
+  hits = 0;
+  misses = 0;
+}
@@ -0,0 +1,62 @@
+/************************************************************************/
+/*  PICxelHSVCache.h  - PIC32 Neopixel Library                          */
+/*                                                                      */
+/*  Direct mapped cache of HSV to RGB conversions.  Most HSV frames     */
+/*  hold a handful of colors, so an output stage or batch conversion    */
+/*  that looks each packed HSV word up here converts every distinct     */
+/*  color once instead of once per LED per frame.  A hit is a multiply, */
+/*  a shift and a compare.                                              */
+/*                                                                      */
+/*  A cache can be shared by any number of strips, see                  */
+/*  PICxel::setHSVCache().                                              */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelHSVCache_H
+#define PICxelHSVCache_H
+
+#include <WProgram.h>
+#include <stdint.h>
+
+//log2 of the number of entries, 8 bytes each
+#ifndef PICXEL_HSV_CACHE_BITS
+#define PICXEL_HSV_CACHE_BITS 6
+#endif
+#define PICXEL_HSV_CACHE_ENTRIES (1 << PICXEL_HSV_CACHE_BITS)
+
+class PICxelHSVCache{
+public:
+  PICxelHSVCache(void);
+
+/************************************************************************/
+/*  Returns the color of a packed HSV word (see HSVsetLEDColor()) as    */
+/*  (blank)(red)(green)(blue), the same as HSVToColor() except that a   */
+/*  value of zero is off, as the refresh sends it.                      */
+/************************************************************************/
+  inline uint32_t lookup(uint32_t HSV){
+    //Fibonacci hashing spreads neighbouring hues over the entries
+    uint32_t index = (uint32_t)(HSV*0x9E3779B1U) >> (32 - PICXEL_HSV_CACHE_BITS);
+    if(keys[index] == HSV){
+      hits++;
+      return colors[index];
+    }
+    return miss(HSV, index);
+  }
+
+  void convert(const uint8_t *hsv, uint8_t *grb, uint16_t count);
+  void clear(void);
+
+  uint32_t getHits(void);
+  uint32_t getMisses(void);
+  void resetCounters(void);
+
+private:
+  uint32_t miss(uint32_t HSV, uint32_t index);
+
+  uint32_t keys[PICXEL_HSV_CACHE_ENTRIES];
+  uint32_t colors[PICXEL_HSV_CACHE_ENTRIES];
+  uint32_t hits;
+  uint32_t misses;
+};
+#endif // PICxelHSVCache_H
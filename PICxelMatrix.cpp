@@ -0,0 +1,304 @@
+/************************************************************************/
+/*  PICxelMatrix.cpp  - PIC32 Neopixel Library                          */
+/*                                                                      */
+/*  2D view over a PICxel strip wired as an LED matrix.                 */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelMatrix.h"
+
+/************************************************************************/
+/*  Construction for a progressive or serpentine matrix                 */
+/************************************************************************/
+PICxelMatrix::PICxelMatrix(PICxel &strip, uint16_t width, uint16_t height, matrix_layout_t layout) :
+  strip(&strip), width(width), height(height), layout(layout), table(NULL),
+  bytesPerLED(strip.getBytesPerLED()){
+  //rows are worked on in place, so keep only the rows the strip has
+  if(width == 0)
+    this->height = 0;
+  else if((uint32_t)width*height > strip.getNumberOfLEDs())
+    this->height = strip.getNumberOfLEDs()/width;
+}
+
+/************************************************************************/
+/*  Construction for a matrix described by a lookup table.  table holds */
+/*  width*height LED numbers indexed by y*width + x.  Row operations    */
+/*  fall back to per LED copies in this mode.                           */
+/************************************************************************/
+PICxelMatrix::PICxelMatrix(PICxel &strip, uint16_t width, uint16_t height, const uint16_t *table) :
+  strip(&strip), width(width), height(height), layout(PROGRESSIVE), table(table),
+  bytesPerLED(strip.getBytesPerLED()){
+}
+
+/************************************************************************/
+/*  Converts a color into the bytes stored in the colorArray, scaled by */
+/*  the strip brightness in GRB mode.  Uses the same 32-bit color       */
+/*  layouts as setLEDColorRGB() (0x00RRGGBB) and HSVsetLEDColor().      */
+/************************************************************************/
+void PICxelMatrix::colorToBytes(uint32_t color, uint8_t *bytes){
+  if(bytesPerLED == 3){
+    uint32_t brightness = strip->getBrightness();
+    bytes[0] = ((uint8_t)(color >> 8) * brightness) >> 8;
+    bytes[1] = ((uint8_t)(color >> 16) * brightness) >> 8;
+    bytes[2] = ((uint8_t)(color) * brightness) >> 8;
+  }
+  else{
+    bytes[0] = color;
+    bytes[1] = color >> 8;
+    bytes[2] = color >> 16;
+    bytes[3] = color >> 24;
+  }
+}
+
+/************************************************************************/
+/*  Returns the first colorArray byte of a matrix row, the row runs     */
+/*  backwards in memory when rowReversed() is true                      */
+/************************************************************************/
+uint8_t* PICxelMatrix::rowPointer(uint16_t y){
+  return strip->getColorArray() + (uint32_t)y*width*bytesPerLED;
+}
+
+bool PICxelMatrix::rowReversed(uint16_t y){
+  return layout == SERPENTINE && (y & 1);
+}
+
+/************************************************************************/
+/*  XY() for the per LED paths, also PICXEL_MATRIX_NO_LED when a lookup */
+/*  table names an LED past the end of the strip                        */
+/************************************************************************/
+uint16_t PICxelMatrix::ledAt(int16_t x, int16_t y){
+  uint16_t number = XY(x, y);
+  return (number < strip->getNumberOfLEDs()) ? number : PICXEL_MATRIX_NO_LED;
+}
+
+/************************************************************************/
+/*  Sets a single pixel, points outside the matrix are ignored          */
+/************************************************************************/
+void PICxelMatrix::setPixel(int16_t x, int16_t y, uint32_t color){
+  uint16_t number = ledAt(x, y);
+  if(number == PICXEL_MATRIX_NO_LED)
+    return;
+  if(bytesPerLED == 3)
+    strip->setLEDColorRGB(number, color);
+  else
+    strip->HSVsetLEDColor(number, color);
+}
+
+/************************************************************************/
+/*  Fills a rectangle, clipped to the matrix.  The color is converted   */
+/*  once, then each row is filled as one contiguous run.                */
+/************************************************************************/
+void PICxelMatrix::rectFill(int16_t x, int16_t y, int16_t w, int16_t h, uint32_t color){
+  int16_t x1 = x + w;
+  int16_t y1 = y + h;
+  uint8_t bytes[4];
+
+  if(x < 0) x = 0;
+  if(y < 0) y = 0;
+  if(x1 > (int16_t)width) x1 = width;
+  if(y1 > (int16_t)height) y1 = height;
+  if(x >= x1 || y >= y1)
+    return;
+
+  colorToBytes(color, bytes);
+
+  for(int16_t row = y; row < y1; row++){
+    if(table != NULL){
+      for(int16_t col = x; col < x1; col++){
+        uint16_t number = ledAt(col, row);
+        if(number == PICXEL_MATRIX_NO_LED)
+          continue;
+        strip->beginPowerUpdate(number, 1);
+        memcpy(strip->getColorArray() + (uint32_t)number*bytesPerLED, bytes, bytesPerLED);
+        strip->endPowerUpdate(number, 1);
+      }
+      continue;
+    }
+
+    //first LED of the run in memory order
+    int16_t first = rowReversed(row) ? (width - x1) : x;
+    uint16_t firstLED = row*width + first;
+    uint8_t *arrayPtr = rowPointer(row) + first*bytesPerLED;
+    strip->beginPowerUpdate(firstLED, x1 - x);
+    for(int16_t i = x; i < x1; i++){
+      for(uint8_t b = 0; b < bytesPerLED; b++)
+        *arrayPtr++ = bytes[b];
+    }
+    strip->endPowerUpdate(firstLED, x1 - x);
+  }
+}
+
+/************************************************************************/
+/*  Copies a whole matrix row.  Rows running the same way are one       */
+/*  memmove, a serpentine row copied onto a row running the other way   */
+/*  is copied LED by LED in reverse.                                    */
+/************************************************************************/
+void PICxelMatrix::copyRow(uint16_t from, uint16_t to){
+  uint8_t *src = rowPointer(from);
+  uint8_t *dst = rowPointer(to);
+
+  if(rowReversed(from) == rowReversed(to)){
+    memmove(dst, src, (uint32_t)width*bytesPerLED);
+    return;
+  }
+
+  dst += (uint32_t)(width - 1)*bytesPerLED;
+  for(uint16_t i = 0; i < width; i++){
+    memcpy(dst, src, bytesPerLED);
+    src += bytesPerLED;
+    dst -= bytesPerLED;
+  }
+}
+
+void PICxelMatrix::clearRow(uint16_t y){
+  memset(rowPointer(y), 0, (uint32_t)width*bytesPerLED);
+}
+
+/************************************************************************/
+/*  Shifts one row by dx pixels to the right (left if negative) with a  */
+/*  single memmove, clearing the pixels shifted in                      */
+/************************************************************************/
+void PICxelMatrix::shiftRow(uint16_t y, int16_t dx){
+  uint8_t *row = rowPointer(y);
+  uint16_t shift = (dx < 0) ? -dx : dx;
+
+  if(shift >= width){
+    clearRow(y);
+    return;
+  }
+
+  uint32_t keep = (uint32_t)(width - shift)*bytesPerLED;
+  uint32_t gap = (uint32_t)shift*bytesPerLED;
+
+  //a reversed row moves the other way in memory
+  if((dx > 0) != rowReversed(y)){
+    memmove(row + gap, row, keep);
+    memset(row, 0, gap);
+  }
+  else{
+    memmove(row, row + gap, keep);
+    memset(row + keep, 0, gap);
+  }
+}
+
+/************************************************************************/
+/*  Scrolls the matrix contents by dx pixels right and dy pixels down,  */
+/*  negative values scroll left and up.  Pixels scrolled in are         */
+/*  cleared.  Vertical scrolling moves whole rows, horizontal scrolling */
+/*  is one memmove per row.                                             */
+/************************************************************************/
+void PICxelMatrix::scroll(int16_t dx, int16_t dy){
+  if(table != NULL){
+    scrollPixels(dx, dy);
+    return;
+  }
+
+  if(dy > 0){
+    for(int16_t y = height - 1; y >= 0; y--){
+      if(y >= dy)
+        copyRow(y - dy, y);
+      else
+        clearRow(y);
+    }
+  }
+  else if(dy < 0){
+    for(int16_t y = 0; y < (int16_t)height; y++){
+      if(y - dy < (int16_t)height)
+        copyRow(y - dy, y);
+      else
+        clearRow(y);
+    }
+  }
+
+  if(dx != 0){
+    for(uint16_t y = 0; y < height; y++)
+      shiftRow(y, dx);
+  }
+
+  //a scroll rewrites the whole matrix anyway
+  strip->recomputePowerEstimate();
+}
+
+/************************************************************************/
+/*  Per pixel scroll for lookup table layouts.  Pixels are visited in   */
+/*  the direction of the scroll so no source is overwritten before it   */
+/*  has been copied.                                                    */
+/************************************************************************/
+void PICxelMatrix::scrollPixels(int16_t dx, int16_t dy){
+  uint8_t *colorArray = strip->getColorArray();
+  int16_t yStep = (dy > 0) ? -1 : 1;
+  int16_t xStep = (dx > 0) ? -1 : 1;
+  int16_t yStart = (dy > 0) ? height - 1 : 0;
+  int16_t xStart = (dx > 0) ? width - 1 : 0;
+
+  for(int16_t y = yStart; y >= 0 && y < (int16_t)height; y += yStep){
+    for(int16_t x = xStart; x >= 0 && x < (int16_t)width; x += xStep){
+      uint16_t to = ledAt(x, y);
+      if(to == PICXEL_MATRIX_NO_LED)
+        continue;
+      uint8_t *dst = colorArray + (uint32_t)to*bytesPerLED;
+      uint16_t from = ledAt(x - dx, y - dy);
+      if(from == PICXEL_MATRIX_NO_LED)
+        memset(dst, 0, bytesPerLED);
+      else
+        memcpy(dst, colorArray + (uint32_t)from*bytesPerLED, bytesPerLED);
+    }
+  }
+  strip->recomputePowerEstimate();
+}
+
+/************************************************************************/
+/*  Copies a sprite onto the matrix with its top left corner at x, y,   */
+/*  clipped to the matrix.  The sprite is spriteWidth*spriteHeight      */
+/*  pixels in row order, stored exactly like the colorArray (3 bytes    */
+/*  GRB or 4 bytes HSV, no brightness scaling), so a const sprite in    */
+/*  flash is copied a row at a time.                                    */
+/************************************************************************/
+void PICxelMatrix::blit(const uint8_t *sprite, uint16_t spriteWidth, uint16_t spriteHeight, int16_t x, int16_t y){
+  int16_t col0 = (x < 0) ? -x : 0;
+  int16_t col1 = spriteWidth;
+  if(x + col1 > (int16_t)width)
+    col1 = width - x;
+  if(col0 >= col1)
+    return;
+
+  for(int16_t r = 0; r < (int16_t)spriteHeight; r++){
+    int16_t row = y + r;
+    if(row < 0)
+      continue;
+    if(row >= (int16_t)height)
+      break;
+
+    const uint8_t *src = sprite + ((uint32_t)r*spriteWidth + col0)*bytesPerLED;
+
+    if(table == NULL && !rowReversed(row)){
+      uint16_t firstLED = row*width + x + col0;
+      strip->beginPowerUpdate(firstLED, col1 - col0);
+      memcpy(rowPointer(row) + (x + col0)*bytesPerLED, src, (uint32_t)(col1 - col0)*bytesPerLED);
+      strip->endPowerUpdate(firstLED, col1 - col0);
+      continue;
+    }
+
+    for(int16_t c = col0; c < col1; c++, src += bytesPerLED){
+      uint16_t number = ledAt(x + c, row);
+      if(number == PICXEL_MATRIX_NO_LED)
+        continue;
+      strip->beginPowerUpdate(number, 1);
+      memcpy(strip->getColorArray() + (uint32_t)number*bytesPerLED, src, bytesPerLED);
+      strip->endPowerUpdate(number, 1);
+    }
+  }
+}
+
+/************************************************************************/
+/*  Returns the matrix dimensions                                       */
+/************************************************************************/
+uint16_t PICxelMatrix::getWidth(void){
+  return width;
+}
+
+uint16_t PICxelMatrix::getHeight(void){
+  return height;
+}
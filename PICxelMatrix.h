@@ -0,0 +1,77 @@
+/************************************************************************/
+/*  PICxelMatrix.h  - PIC32 Neopixel Library                            */
+/*                                                                      */
+/*  2D view over a PICxel strip wired as an LED matrix.  LEDs are laid  */
+/*  out row by row starting at the top left, either all rows left to    */
+/*  right (progressive) or every other row reversed (serpentine).  Any  */
+/*  other wiring can be described with a lookup table of LED numbers   */
+/*  indexed by y*width + x, which may be a const array in flash.        */
+/*                                                                      */
+/*  With the built in layouts every matrix row is one contiguous run of */
+/*  the colorArray, so fills, scrolls and sprite blits work on whole    */
+/*  rows with memset/memmove/memcpy instead of per LED calls.           */
+/*                                                                      */
+/*  Colors are 0x00RRGGBB on a GRB strip, as for setLEDColorRGB(), and  */
+/*  HSV words as for HSVsetLEDColor() on an HSV strip.  A built in      */
+/*  layout taller than the strip is cut to the rows the strip has, and  */
+/*  table entries past the end of the strip are treated as gaps.        */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelMatrix_H
+#define PICxelMatrix_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+#define PICXEL_MATRIX_NO_LED 0xFFFF
+
+enum matrix_layout_t {PROGRESSIVE, SERPENTINE};
+
+class PICxelMatrix{
+public:
+  PICxelMatrix(PICxel &strip, uint16_t width, uint16_t height, matrix_layout_t layout);
+  PICxelMatrix(PICxel &strip, uint16_t width, uint16_t height, const uint16_t *table);
+
+/************************************************************************/
+/*  Returns the LED number of x, y or PICXEL_MATRIX_NO_LED if the point */
+/*  is outside the matrix                                               */
+/************************************************************************/
+  inline uint16_t XY(int16_t x, int16_t y){
+    if(x < 0 || y < 0 || x >= width || y >= height)
+      return PICXEL_MATRIX_NO_LED;
+    if(table != NULL)
+      return table[y*width + x];
+    if(layout == SERPENTINE && (y & 1))
+      return y*width + (width - 1 - x);
+    return y*width + x;
+  }
+
+  void setPixel(int16_t x, int16_t y, uint32_t color);
+  void rectFill(int16_t x, int16_t y, int16_t w, int16_t h, uint32_t color);
+  void scroll(int16_t dx, int16_t dy);
+  void blit(const uint8_t *sprite, uint16_t spriteWidth, uint16_t spriteHeight, int16_t x, int16_t y);
+
+  uint16_t getWidth(void);
+  uint16_t getHeight(void);
+
+private:
+  void colorToBytes(uint32_t color, uint8_t *bytes);
+  uint8_t* rowPointer(uint16_t y);
+  bool rowReversed(uint16_t y);
+  uint16_t ledAt(int16_t x, int16_t y);
+  void copyRow(uint16_t from, uint16_t to);
+  void shiftRow(uint16_t y, int16_t dx);
+  void clearRow(uint16_t y);
+  void scrollPixels(int16_t dx, int16_t dy);
+
+  PICxel *strip;
+  uint16_t width;
+  uint16_t height;
+  matrix_layout_t layout;
+  const uint16_t *table;
+  uint8_t bytesPerLED;
+};
+#endif // PICxelMatrix_H
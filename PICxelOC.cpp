@@ -0,0 +1,180 @@
+/************************************************************************/
+/*  PICxelOC.cpp  - PIC32 Neopixel Library                              */
+/*                                                                      */
+/*  Output Compare, Timer2 and DMA backend for PICxel strips.           */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <string.h>
+#include "PICxelOC.h"
+
+#define PICXEL_OC_MODULES 5
+
+//OCxCON in PWM mode on Timer2, OCxR and OCxRS follow at 0x10 and 0x20
+#define OC_PWM_MODE 0x0006
+#define OC_ON       0x8000
+#define TIMER_ON    0x8000
+
+#ifdef __mips__
+static volatile uint32_t* const ocCon[PICXEL_OC_MODULES] = {
+  (volatile uint32_t*)&OC1CON, (volatile uint32_t*)&OC2CON, (volatile uint32_t*)&OC3CON,
+  (volatile uint32_t*)&OC4CON, (volatile uint32_t*)&OC5CON};
+#endif
+
+/************************************************************************/
+/*  Construction for the PICxelOC class.  ocModule is 1-5, dmaChannel   */
+/*  0-3.  Nothing is touched until begin().                             */
+/************************************************************************/
+PICxelOC::PICxelOC(uint8_t ocModule, uint8_t dmaChannel) : ocModule(ocModule),
+  dmaChannel(dmaChannel), zeroDuty(0), oneDuty(0), nextLED(0), outputLength(0){
+}
+
+/************************************************************************/
+/*  Starts Timer2 with a 1.25us period and puts the OC module in PWM    */
+/*  mode with the line held low.  timerHz is the peripheral bus clock   */
+/*  feeding Timer2, F_CPU on most chipKIT boards.  Returns false for a  */
+/*  bad module or channel, or a clock too fast for 8-bit duty values.   */
+/************************************************************************/
+bool PICxelOC::begin(uint32_t timerHz){
+  uint32_t period = ((uint64_t)timerHz*PICXEL_OC_PERIOD_NS)/1000000000ULL;
+
+  if(ocModule < 1 || ocModule > PICXEL_OC_MODULES || dmaChannel >= PICXEL_DMA_CHANNELS)
+    return false;
+  if(period > 256 || period < 8)
+    return false;
+
+  zeroDuty = (period*PICXEL_OC_T0H_NS + PICXEL_OC_PERIOD_NS/2)/PICXEL_OC_PERIOD_NS;
+  oneDuty = (period*PICXEL_OC_T1H_NS + PICXEL_OC_PERIOD_NS/2)/PICXEL_OC_PERIOD_NS;
+
+#ifdef __mips__
+  volatile uint32_t *con = ocCon[ocModule - 1];
+
+  T2CON = 0;
+  TMR2 = 0;
+  PR2 = period - 1;
+
+  con[0] = 0;
+  con[4] = 0;   //OCxR
+  con[8] = 0;   //OCxRS
+  con[0] = OC_PWM_MODE;
+  con[2] = OC_ON;   //OCxCONSET
+
+  T2CONSET = TIMER_ON;
+#endif
+  return true;
+}
+
+/************************************************************************/
+/*  Encodes count bytes, most significant bit first, into one duty      */
+/*  value per bit.  Returns the number of duty values written, 8*count. */
+/*  Has no hardware dependencies, so it can be checked on the host.     */
+/************************************************************************/
+uint32_t PICxelOC::encodeDuty(const uint8_t *bytes, uint32_t count, uint8_t *duty,
+  uint8_t zeroDuty, uint8_t oneDuty){
+  for(uint32_t i = 0; i < count; i++){
+    uint8_t data = bytes[i];
+    for(uint8_t bitSelect = 0x80; bitSelect; bitSelect >>= 1)
+      *duty++ = (data & bitSelect) ? oneDuty : zeroDuty;
+  }
+  return 8*count;
+}
+
+/************************************************************************/
+/*  Encodes the next PICXEL_OC_CHUNK_LEDS LEDs of the strip into one    */
+/*  half of the duty buffer.  Bits past the end of the strip get a duty */
+/*  of zero, which holds the line low.  Returns false when the half     */
+/*  holds no LED data.                                                  */
+/************************************************************************/
+bool PICxelOC::fillHalf(PICxel &strip, uint8_t half){
+  uint8_t *duty = &dutyBuffer[half*PICXEL_OC_CHUNK_BITS];
+  uint16_t count = outputLength - nextLED;
+  uint32_t bits;
+
+  if(count > PICXEL_OC_CHUNK_LEDS)
+    count = PICXEL_OC_CHUNK_LEDS;
+
+  strip.fillOutputBytes(byteBuffer, nextLED, count);
+  bits = encodeDuty(byteBuffer, 3*count, duty, zeroDuty, oneDuty);
+  memset(duty + bits, 0, PICXEL_OC_CHUNK_BITS - bits);
+  nextLED += count;
+#ifdef __mips__
+  PICxelDMAwriteback(duty, PICXEL_OC_CHUNK_BITS);
+#endif
+
+  return count != 0;
+}
+
+/************************************************************************/
+/*  Sends the strip.  DMA plays the duty buffer in auto enable mode,    */
+/*  raising the source half flag after the first half and the source   */
+/*  done flag after the second, and each half is encoded again while   */
+/*  the other plays.  Once the half after the last LED data starts the  */
+/*  channel is stopped and the line stays low for the reset.            */
+/*                                                                      */
+/*  Interrupts stay enabled, but a handler running longer than a        */
+/*  half (PICXEL_OC_CHUNK_LEDS*30us) lets DMA replay stale data.        */
+/************************************************************************/
+void PICxelOC::refreshLEDs(PICxel &strip){
+  bool more[2];
+  uint8_t half = 0;
+
+  if(oneDuty == 0)
+    return;
+
+  outputLength = strip.getOutputLength();
+  nextLED = 0;
+  if(outputLength == 0)
+    return;
+
+  more[0] = fillHalf(strip, 0);
+  more[1] = fillHalf(strip, 1);
+
+#ifdef __mips__
+  volatile uint32_t *con = ocCon[ocModule - 1];
+  picxel_dma_channel_t *channel = PICxelDMAchannel(dmaChannel);
+
+  PICxelDMAsetup(channel, dutyBuffer, sizeof(dutyBuffer), &con[8], 1, 1, _TIMER_2_IRQ);
+  channel->CON.set = PICXEL_DMA_CHAEN | PICXEL_DMA_CHEN;
+
+  while(true){
+    uint32_t flag = (half == 0) ? PICXEL_DMA_CHSHIF : PICXEL_DMA_CHSDIF;
+    while(!(channel->INT.reg & flag))
+      ;
+    channel->INT.clr = flag;
+
+    //this half has been handed to OCxRS, the other one is playing
+    if(!more[half ^ 1])
+      break;
+    more[half] = fillHalf(strip, half);
+    half ^= 1;
+  }
+
+  //let the last duty value through OCxRS before stopping
+  delayMicroseconds(3);
+  PICXEL_TRACE(PICXEL_TRACE_LAST_BIT, 0);
+  channel->CON.clr = PICXEL_DMA_CHAEN | PICXEL_DMA_CHEN;
+  con[8] = 0;
+#else
+  //no DMA on the host, just run the encoder over the strip
+  while(more[half ^ 1]){
+    more[half] = fillHalf(strip, half);
+    half ^= 1;
+  }
+#endif
+}
+
+/************************************************************************/
+/*  Returns the duty value, in Timer2 ticks, sent for a zero bit        */
+/************************************************************************/
+uint8_t PICxelOC::getZeroDuty(void){
+  return zeroDuty;
+}
+
+/************************************************************************/
+/*  Returns the duty value, in Timer2 ticks, sent for a one bit         */
+/************************************************************************/
+uint8_t PICxelOC::getOneDuty(void){
+  return oneDuty;
+}
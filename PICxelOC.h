@@ -0,0 +1,73 @@
+/************************************************************************/
+/*  PICxelOC.h  - PIC32 Neopixel Library                                */
+/*                                                                      */
+/*  Output Compare backend for boards whose pins or CPU time are spoken */
+/*  for.  Timer2 runs one 1.25us period per bit and an Output Compare   */
+/*  module in PWM mode drives the data pin.  A DMA channel, started by  */
+/*  every Timer2 period, loads the next duty cycle into OCxRS, so the   */
+/*  CPU only encodes the colorArray into duty values a few LEDs ahead.  */
+/*                                                                      */
+/*  The duty buffer is two halves of PICXEL_OC_CHUNK_LEDS LEDs, one     */
+/*  byte per bit.  While DMA plays one half the other is encoded, so    */
+/*  RAM use does not grow with the strip length.                        */
+/*                                                                      */
+/*  Usage:                                                              */
+/*    PICxelOC oc(1, 0);            //OC1, DMA channel 0                */
+/*    strip.begin();                                                    */
+/*    oc.begin();                                                       */
+/*    strip.setOutput(&oc);         //strip.refreshLEDs() now uses OC1  */
+/*                                                                      */
+/*  The strip must be on the board's pin for that OC module.  On parts  */
+/*  with peripheral pin select map the OC output to the pin first.      */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelOC_H
+#define PICxelOC_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+#include "PICxelDMA.h"
+
+#define PICXEL_OC_PERIOD_NS  1250
+#define PICXEL_OC_T0H_NS      350
+#define PICXEL_OC_T1H_NS      700
+
+//LEDs per half of the duty buffer, both halves must fit one DMA transfer
+#define PICXEL_OC_CHUNK_LEDS  4
+#define PICXEL_OC_CHUNK_BITS  (24*PICXEL_OC_CHUNK_LEDS)
+
+#if 2*PICXEL_OC_CHUNK_BITS > PICXEL_DMA_MAX_BYTES
+  #error PICXEL_OC_CHUNK_LEDS is too large for one DMA transfer
+#endif
+
+class PICxelOC : public PICxelOutput{
+public:
+  PICxelOC(uint8_t ocModule, uint8_t dmaChannel);
+
+  bool begin(uint32_t timerHz = F_CPU);
+  void refreshLEDs(PICxel &strip);
+
+  static uint32_t encodeDuty(const uint8_t *bytes, uint32_t count, uint8_t *duty,
+    uint8_t zeroDuty, uint8_t oneDuty);
+
+  uint8_t getZeroDuty(void);
+  uint8_t getOneDuty(void);
+
+private:
+  bool fillHalf(PICxel &strip, uint8_t half);
+
+  uint8_t ocModule;
+  uint8_t dmaChannel;
+  uint8_t zeroDuty;
+  uint8_t oneDuty;
+
+//chunk encoding variables
+  uint16_t nextLED;
+  uint16_t outputLength;
+  uint8_t byteBuffer[3*PICXEL_OC_CHUNK_LEDS];
+  uint8_t dutyBuffer[2*PICXEL_OC_CHUNK_BITS];
+};
+#endif // PICxelOC_H
@@ -0,0 +1,239 @@
+/************************************************************************/
+/*  PICxelParallel.cpp  - PIC32 Neopixel Library                        */
+/*                                                                      */
+/*  Parallel Master Port, Timer3 and DMA backend for 8 or 16 strands.   */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <string.h>
+#include "PICxelParallel.h"
+
+//PMMODE: 16-bit data, master mode 2, shortest wait states
+#define PMP_MODE16      0x0400
+#define PMP_MASTER2     0x0200
+#define PMP_ON          0x8000
+#define TIMER_ON        0x8000
+
+/************************************************************************/
+/*  Construction for the PICxelParallel class.  width is 8 or 16 data   */
+/*  pins, dmaChannel 0-3.                                               */
+/************************************************************************/
+PICxelParallel::PICxelParallel(uint8_t width, uint8_t dmaChannel) : numberOfStrands(0),
+  width((width > 8) ? 16 : 8), dmaChannel(dmaChannel), strandLength(0), planes(NULL),
+  planeBytes(0), sending(false), frameEndTicks(0){
+}
+
+PICxelParallel::~PICxelParallel(void){
+  free(planes);
+}
+
+/************************************************************************/
+/*  Adds the next strand, which is sent on the next PMP data pin.       */
+/*  Returns false once every data pin has a strand.                     */
+/************************************************************************/
+bool PICxelParallel::addStrand(PICxel &strip){
+  if(numberOfStrands >= width)
+    return false;
+
+  strands[numberOfStrands++] = &strip;
+  return true;
+}
+
+/************************************************************************/
+/*  Allocates the plane buffer for the longest strand and starts the    */
+/*  PMP and Timer3.  Call it after every strand has been added and      */
+/*  index maps have been set.  timerHz is the peripheral bus clock.     */
+/*  Returns false, with no buffer, when there are no strands or the     */
+/*  buffer would leave less than PICXEL_PARALLEL_HEAP_RESERVE bytes of  */
+/*  heap.  The PIC32 heap is a few KB unless the linker is told more,   */
+/*  so a long strand fails here rather than in the sketch later.        */
+/************************************************************************/
+bool PICxelParallel::begin(uint32_t timerHz){
+  uint32_t slotTicks = ((uint64_t)timerHz*PICXEL_PARALLEL_SLOT_NS)/1000000000ULL;
+
+  if(dmaChannel >= PICXEL_DMA_CHANNELS || slotTicks < 2)
+    return false;
+
+  strandLength = 0;
+  for(uint8_t s = 0; s < numberOfStrands; s++){
+    if(strands[s]->getOutputLength() > strandLength)
+      strandLength = strands[s]->getOutputLength();
+  }
+
+  free(planes);
+  planes = NULL;
+  planeBytes = 0;
+
+  //3 slots for each of the 24 bits of an LED
+  uint32_t bytes = 72*(uint32_t)strandLength*(width/8);
+  if(bytes == 0)
+    return false;
+
+  //the reserve is allocated too, so the check is against the heap left
+  uint8_t *probe = (uint8_t*)malloc(bytes + PICXEL_PARALLEL_HEAP_RESERVE);
+  if(probe == NULL)
+    return false;
+  free(probe);
+
+  planes = (uint8_t*)calloc(bytes, sizeof(uint8_t));
+  if(planes == NULL)
+    return false;
+  planeBytes = bytes;
+
+#ifdef __mips__
+  PMCON = 0;
+  PMAEN = 0;
+  PMMODE = PMP_MASTER2 | ((width == 16) ? PMP_MODE16 : 0);
+  PMCONSET = PMP_ON;
+  PMDIN = 0;
+
+  T3CON = 0;
+  TMR3 = 0;
+  PR3 = slotTicks - 1;
+  T3CONSET = TIMER_ON;
+#endif
+  return true;
+}
+
+/************************************************************************/
+/*  Transposes every strand into the plane buffer.  The strands are     */
+/*  read through fillOutputBytes() PICXEL_PARALLEL_CHUNK_LEDS LEDs at a */
+/*  time, so index maps, HSV and power limits apply.  Returns the       */
+/*  number of bytes written.                                            */
+/************************************************************************/
+uint32_t PICxelParallel::encodeBitPlanes(void){
+  uint16_t allHigh = (1UL << numberOfStrands) - 1;
+  uint8_t *planes8 = planes;
+  uint16_t *planes16 = (uint16_t*)planes;
+
+  if(planes == NULL)
+    return 0;
+
+  for(uint16_t first = 0; first < strandLength; first += PICXEL_PARALLEL_CHUNK_LEDS){
+    uint16_t count = strandLength - first;
+    if(count > PICXEL_PARALLEL_CHUNK_LEDS)
+      count = PICXEL_PARALLEL_CHUNK_LEDS;
+
+    for(uint8_t s = 0; s < numberOfStrands; s++){
+      uint16_t length = strands[s]->getOutputLength();
+      uint16_t filled = 0;
+      if(first < length)
+        filled = (length - first < count) ? length - first : count;
+      strands[s]->fillOutputBytes(scratch[s], first, filled);
+      memset(&scratch[s][3*filled], 0, 3*(count - filled));
+    }
+
+    for(uint8_t b = 0; b < 3*count; b++){
+      for(uint8_t bitSelect = 0x80; bitSelect; bitSelect >>= 1){
+        uint16_t word = 0;
+        for(uint8_t s = 0; s < numberOfStrands; s++){
+          if(scratch[s][b] & bitSelect)
+            word |= 1 << s;
+        }
+
+        if(width == 16){
+          *planes16++ = allHigh;
+          *planes16++ = word;
+          *planes16++ = 0;
+        }
+        else{
+          *planes8++ = allHigh;
+          *planes8++ = word;
+          *planes8++ = 0;
+        }
+      }
+    }
+  }
+
+  return (width == 16) ? (uint8_t*)planes16 - planes : planes8 - planes;
+}
+
+/************************************************************************/
+/*  Waits for the previous frame and the WS2812 reset time after it,    */
+/*  transposes the strands and starts DMA on the new frame.  When the   */
+/*  frame fits one DMA transfer this returns without waiting for it,    */
+/*  and the colorArrays may be written again right away.  A larger      */
+/*  frame is sent in transfers of whole bits, each started as soon as   */
+/*  the last ends, with interrupts off so no gap reads as a reset.      */
+/*  They stay off until the frame is out, 30us per LED of the longest   */
+/*  strand.                                                             */
+/************************************************************************/
+void PICxelParallel::refreshLEDs(void){
+  uint32_t bytes;
+
+  PICXEL_TRACE(PICXEL_TRACE_REFRESH_START, 0);
+  while(busy())
+    ;
+  while(ReadCoreTimer() - frameEndTicks < (F_CPU/2/1000000)*PICXEL_PARALLEL_RESET_US)
+    ;
+
+  bytes = encodeBitPlanes();
+  if(bytes == 0)
+    return;
+
+#ifdef __mips__
+  picxel_dma_channel_t *channel = PICxelDMAchannel(dmaChannel);
+  //each transfer ends on the low slot of a bit
+  uint32_t chunk = PICXEL_DMA_MAX_BYTES - PICXEL_DMA_MAX_BYTES % (3*width/8);
+  uint32_t first = (bytes < chunk) ? bytes : chunk;
+
+  PICxelDMAwriteback(planes, bytes);
+  PICxelDMAsetup(channel, planes, first, &PMDIN, width/8, width/8, _TIMER_3_IRQ);
+  sending = true;
+  if(first == bytes){
+    channel->CON.set = PICXEL_DMA_CHEN;
+    return;
+  }
+
+  uint32_t interruptBits = disableInterrupts();
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_OFF, 0);
+  channel->CON.set = PICXEL_DMA_CHEN;
+  for(uint32_t sent = first; sent < bytes; sent += chunk){
+    uint32_t size = (bytes - sent < chunk) ? bytes - sent : chunk;
+    while(channel->CON.reg & PICXEL_DMA_CHEN)
+      ;
+    channel->SSA.reg = KVA_TO_PA(planes + sent);
+    channel->SSIZ.reg = size;
+    channel->CON.set = PICXEL_DMA_CHEN;
+  }
+  while(busy())
+    ;
+  restoreInterrupts(interruptBits);
+  PICXEL_TRACE(PICXEL_TRACE_IRQ_ON, 0);
+#endif
+}
+
+/************************************************************************/
+/*  Returns true while DMA is still sending a frame.  The first call to */
+/*  find a frame done stamps its end and traces LAST_BIT, so the trace  */
+/*  shows when the end was seen, not the exact last bit.                */
+/************************************************************************/
+bool PICxelParallel::busy(void){
+#ifdef __mips__
+  if(PICxelDMAchannel(dmaChannel)->CON.reg & PICXEL_DMA_CHEN)
+    return true;
+#endif
+  //first look at the channel since the frame ended
+  if(sending){
+    sending = false;
+    frameEndTicks = ReadCoreTimer();
+    PICXEL_TRACE(PICXEL_TRACE_LAST_BIT, 0);
+  }
+  return false;
+}
+
+/************************************************************************/
+/*  Returns the address of the plane buffer                             */
+/************************************************************************/
+uint8_t* PICxelParallel::getPlanes(void){
+  return planes;
+}
+
+/************************************************************************/
+/*  Returns the size of the plane buffer in bytes                       */
+/************************************************************************/
+uint32_t PICxelParallel::getPlaneBytes(void){
+  return planeBytes;
+}
@@ -0,0 +1,81 @@
+/************************************************************************/
+/*  PICxelParallel.h  - PIC32 Neopixel Library                          */
+/*                                                                      */
+/*  Drives 8 or 16 strands at once from the Parallel Master Port data   */
+/*  pins, strand n on PMDn.  Each bit is sent as three slots of about   */
+/*  417ns:                                                              */
+/*    all strands high, the data bit of each strand, all strands low    */
+/*  so a zero bit is high for one slot and a one bit for two.  The      */
+/*  slots are written to PMDIN by a DMA channel started by Timer3, and  */
+/*  the CPU only transposes the strands into these bit plane words      */
+/*  before the frame starts.                                            */
+/*                                                                      */
+/*  refreshLEDs() returns as soon as DMA is running, so the next frame  */
+/*  can be rendered into the colorArrays while this one goes out.  A    */
+/*  frame larger than one DMA transfer (PICXEL_DMA_MAX_BYTES, 256 bytes */
+/*  on PIC32MX3xx/4xx) is sent in several transfers with interrupts     */
+/*  off, and refreshLEDs() returns once it is out.  Interrupts are then */
+/*  off for the whole frame, 30us per LED of the longest strand, 9ms    */
+/*  for 300 LEDs, so millis() and serial receive fall behind.           */
+/*  Strands may have any length and color mode, the shorter ones are    */
+/*  padded with black.  The plane buffer takes 72 bytes per LED of the  */
+/*  longest strand with 8 strands and 144 with 16, from the heap, and   */
+/*  begin() fails if it would leave less than                           */
+/*  PICXEL_PARALLEL_HEAP_RESERVE bytes of heap free.                    */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelParallel_H
+#define PICxelParallel_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+#include "PICxelDMA.h"
+
+#define PICXEL_PARALLEL_MAX_STRANDS  16
+#define PICXEL_PARALLEL_SLOT_NS      417
+
+//LEDs per strand transposed per pass
+#define PICXEL_PARALLEL_CHUNK_LEDS   8
+
+//low time after a frame before the next may start, for newer WS2812B
+#define PICXEL_PARALLEL_RESET_US     280
+
+//heap begin() leaves free after the plane buffer
+#ifndef PICXEL_PARALLEL_HEAP_RESERVE
+#define PICXEL_PARALLEL_HEAP_RESERVE 1024
+#endif
+
+class PICxelParallel{
+public:
+  PICxelParallel(uint8_t width, uint8_t dmaChannel);
+  ~PICxelParallel(void);
+
+  bool addStrand(PICxel &strip);
+  bool begin(uint32_t timerHz = F_CPU);
+  void refreshLEDs(void);
+  bool busy(void);
+
+  uint32_t encodeBitPlanes(void);
+  uint8_t* getPlanes(void);
+  uint32_t getPlaneBytes(void);
+
+private:
+  PICxel *strands[PICXEL_PARALLEL_MAX_STRANDS];
+  uint8_t numberOfStrands;
+  uint8_t width;
+  uint8_t dmaChannel;
+  uint16_t strandLength;
+
+//bit plane buffer, one word (width bits) per slot
+  uint8_t *planes;
+  uint32_t planeBytes;
+
+//core timer at the end of the last frame, for the reset gap
+  bool sending;
+  uint32_t frameEndTicks;
+  uint8_t scratch[PICXEL_PARALLEL_MAX_STRANDS][3*PICXEL_PARALLEL_CHUNK_LEDS];
+};
+#endif // PICxelParallel_H
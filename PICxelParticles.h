@@ -0,0 +1,182 @@
+/************************************************************************/
+/*  PICxelParticles.h  - PIC32 Neopixel Library                         */
+/*                                                                      */
+/*  Fixed capacity particle system for sparkle, confetti and bead       */
+/*  effects on a GRB strip.  Each particle has a 16.16 position and     */
+/*  velocity in LEDs, a color, a level that decays each frame and a     */
+/*  life in frames.                                                     */
+/*                                                                      */
+/*  Particles are stored as a structure of arrays sized by CAPACITY at  */
+/*  compile time, no heap.  Live particles are kept packed at the front */
+/*  and a dead one is replaced by the last, so every pass is a straight */
+/*  loop over count entries and a frame costs the same for the same     */
+/*  particle count.  See the Particle rows of PICxelBench.              */
+/*                                                                      */
+/*  A frame is spawn() for new particles, update() to move and age      */
+/*  them, then render() to add them into the colorArray.  render() adds */
+/*  with saturation on top of what is there, so clear the strip first   */
+/*  for particles on black or leave a background to draw over.  Fading  */
+/*  trails come from the particles' own decay, not from rescanning the  */
+/*  whole strip.                                                        */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelParticles_H
+#define PICxelParticles_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+template<uint16_t CAPACITY>
+class PICxelParticles{
+public:
+/************************************************************************/
+/*  length is the number of LEDs particles move over.  With wrap set    */
+/*  particles leaving one end come back at the other, otherwise they    */
+/*  die at the ends.                                                    */
+/************************************************************************/
+  PICxelParticles(uint16_t length, bool wrap) : length(length), wrap(wrap), count(0){
+  }
+
+/************************************************************************/
+/*  Adds a particle at position (16.16 LEDs) moving velocity (16.16     */
+/*  LEDs per frame).  color is (blank)(red)(green)(blue), level is its  */
+/*  starting brightness and decay the level multiplier per frame out of */
+/*  256.  A life of 0 frames never runs out.  Returns false when all    */
+/*  CAPACITY particles are live.                                        */
+/************************************************************************/
+  bool spawn(uint32_t position, int32_t velocity, uint32_t color, uint8_t level,
+    uint8_t decay, uint16_t life){
+    if(count >= CAPACITY || (position >> 16) >= length)
+      return false;
+
+    uint16_t i = count++;
+    positions[i] = position;
+    velocities[i] = velocity;
+    reds[i] = color >> 16;
+    greens[i] = color >> 8;
+    blues[i] = color;
+    levels[i] = level;
+    decays[i] = decay;
+    lives[i] = life;
+    return true;
+  }
+
+/************************************************************************/
+/*  Moves and ages every particle by one frame.  Particles whose life   */
+/*  or level reach zero, or that leave a strip without wrap, are        */
+/*  removed.  Returns the number still live.                            */
+/************************************************************************/
+  uint16_t update(void){
+    uint32_t limit = (uint32_t)length << 16;
+    uint16_t i = 0;
+
+    while(i < count){
+      uint32_t position = positions[i] + velocities[i];
+      uint8_t level = (levels[i]*decays[i]) >> 8;
+
+      if(position >= limit && wrap)
+        position += (velocities[i] < 0) ? limit : -limit;
+
+      if((lives[i] && --lives[i] == 0) || level == 0 || position >= limit){
+        remove(i);
+        continue;
+      }
+
+      positions[i] = position;
+      levels[i] = level;
+      i++;
+    }
+    return count;
+  }
+
+/************************************************************************/
+/*  Adds every particle into the colorArray of a GRB strip, split       */
+/*  between the two LEDs around its position by the fraction, so slow   */
+/*  particles glide instead of stepping.  Channels saturate at 255.     */
+/*  The power estimate is updated for the LEDs touched only, so the     */
+/*  cost follows the particle count, not the strip length.              */
+/************************************************************************/
+  void render(PICxel &strip){
+    uint8_t *colorArray = strip.getColorArray();
+    uint16_t leds = strip.getNumberOfLEDs();
+
+    if(strip.getBytesPerLED() != 3 || colorArray == NULL)
+      return;
+    if(leds > length)
+      leds = length;
+
+    for(uint16_t i = 0; i < count; i++){
+      uint16_t a = positions[i] >> 16;
+      uint16_t b = a + 1;
+      uint16_t fraction = (positions[i] >> 8) & 0xFF;
+      uint16_t weightB = (fraction*levels[i]) >> 8;
+      uint16_t weightA = levels[i] - weightB;
+
+      if(b == length)
+        b = wrap ? 0 : leds;
+      if(a < leds)
+        splat(strip, colorArray, a, i, weightA);
+      if(b < leds)
+        splat(strip, colorArray, b, i, weightB);
+    }
+  }
+
+/************************************************************************/
+/*  Removes every particle                                              */
+/************************************************************************/
+  void clear(void){
+    count = 0;
+  }
+
+  uint16_t getCount(void){
+    return count;
+  }
+
+  uint16_t getCapacity(void){
+    return CAPACITY;
+  }
+
+private:
+  //the colorArray is written directly, the power sums follow each LED
+  inline void splat(PICxel &strip, uint8_t *colorArray, uint16_t number, uint16_t i, uint16_t weight){
+    uint8_t *led = &colorArray[3*number];
+    strip.beginPowerUpdate(number, 1);
+    uint16_t green = led[0] + ((greens[i]*weight) >> 8);
+    uint16_t red = led[1] + ((reds[i]*weight) >> 8);
+    uint16_t blue = led[2] + ((blues[i]*weight) >> 8);
+    led[0] = (green > 255) ? 255 : green;
+    led[1] = (red > 255) ? 255 : red;
+    led[2] = (blue > 255) ? 255 : blue;
+    strip.endPowerUpdate(number, 1);
+  }
+
+  inline void remove(uint16_t i){
+    uint16_t last = --count;
+    positions[i] = positions[last];
+    velocities[i] = velocities[last];
+    reds[i] = reds[last];
+    greens[i] = greens[last];
+    blues[i] = blues[last];
+    levels[i] = levels[last];
+    decays[i] = decays[last];
+    lives[i] = lives[last];
+  }
+
+  uint16_t length;
+  bool wrap;
+  uint16_t count;
+
+//particle state, one entry per particle in each array
+  uint32_t positions[CAPACITY];
+  int32_t velocities[CAPACITY];
+  uint8_t reds[CAPACITY];
+  uint8_t greens[CAPACITY];
+  uint8_t blues[CAPACITY];
+  uint8_t levels[CAPACITY];
+  uint8_t decays[CAPACITY];
+  uint16_t lives[CAPACITY];
+};
+#endif // PICxelParticles_H
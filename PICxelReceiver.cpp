@@ -0,0 +1,203 @@
+/************************************************************************/
+/*  PICxelReceiver.cpp  - PIC32 Neopixel Library                        */
+/*                                                                      */
+/*  Streaming receiver for PC driven strips.  Parses Adalight or TPM2   */
+/*  framing from a serial Stream and writes the payload straight into   */
+/*  the colorArray of a GRB mode PICxel object.                         */
+/*                                                                      */
+/*  Adalight frame:                                                     */
+/*    'A' 'd' 'a' (count-1 hi)(count-1 lo)(hi ^ lo ^ 0x55) RGB...       */
+/*  TPM2 frame:                                                         */
+/*    0xC9 0xDA (size hi)(size lo) RGB... 0x36                          */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelReceiver.h"
+
+#define TPM2_FRAME_START  0xC9
+#define TPM2_TYPE_DATA    0xDA
+#define TPM2_FRAME_END    0x36
+
+//hosts send RGB, the colorArray is stored GRB
+static const uint8_t rgbToGrbOffset[3] = {1, 0, 2};
+
+/************************************************************************/
+/*  Construction for the PICxelReceiver class                           */
+/************************************************************************/
+PICxelReceiver::PICxelReceiver(PICxel &strip, Stream &stream, receiver_protocol_t protocol) :
+  strip(&strip), stream(&stream), protocol(protocol), state(WAIT_HEADER_0),
+  autoRefresh(true), payloadLength(0), payloadIndex(0), channel(0),
+  writePtr(NULL), writeEnd(NULL), frameCount(0), errorCount(0){
+}
+
+/************************************************************************/
+/*  Announces the receiver to the host.  Adalight hosts wait for the    */
+/*  "Ada" greeting before they start streaming.  Both protocols carry   */
+/*  RGB, so an HSV strip is refused: begin() returns false and every    */
+/*  payload is dropped without touching the colorArray.                 */
+/************************************************************************/
+bool PICxelReceiver::begin(void){
+  state = WAIT_HEADER_0;
+  if(strip->getBytesPerLED() != 3)
+    return false;
+  if(protocol == ADALIGHT)
+    stream->print("Ada\n");
+  return true;
+}
+
+/************************************************************************/
+/*  Enables or disables the call to refreshLEDs() at the end of each    */
+/*  valid frame.  With auto refresh off the application decides when    */
+/*  to refresh, poll() still returns true on frame completion.          */
+/************************************************************************/
+void PICxelReceiver::setAutoRefresh(bool enable){
+  autoRefresh = enable;
+}
+
+/************************************************************************/
+/*  Drains every byte the serial driver has buffered so far.  Returns   */
+/*  true as soon as a complete, valid frame has been received, leaving  */
+/*  any following bytes in the serial buffer for the next call.         */
+/************************************************************************/
+bool PICxelReceiver::poll(void){
+  while(stream->available() > 0){
+    if(processByte(stream->read()))
+      return true;
+  }
+  return false;
+}
+
+/************************************************************************/
+/*  Feeds one byte through the frame parser.  Payload bytes are         */
+/*  reordered from RGB to GRB, scaled by the strip brightness and       */
+/*  written directly into the colorArray.  Pixels beyond the end of     */
+/*  the strip are consumed and dropped.  Can be called from a custom    */
+/*  UART interrupt or DMA drain instead of poll().                      */
+/************************************************************************/
+bool PICxelReceiver::processByte(uint8_t data){
+  switch(state){
+    case WAIT_HEADER_0:
+      if(protocol == ADALIGHT && data == 'A')
+        state = WAIT_HEADER_1;
+      else if(protocol == TPM2 && data == TPM2_FRAME_START)
+        state = WAIT_HEADER_1;
+      if(state == WAIT_HEADER_1)
+        PICXEL_TRACE(PICXEL_TRACE_FRAME_START, frameCount);
+      break;
+
+    case WAIT_HEADER_1:
+      if(protocol == ADALIGHT && data == 'd')
+        state = WAIT_HEADER_2;
+      else if(protocol == TPM2 && data == TPM2_TYPE_DATA)
+        state = WAIT_SIZE_HI;
+      else
+        state = WAIT_HEADER_0;
+      break;
+
+    case WAIT_HEADER_2:
+      state = (data == 'a') ? WAIT_SIZE_HI : WAIT_HEADER_0;
+      break;
+
+    case WAIT_SIZE_HI:
+      sizeHi = data;
+      state = WAIT_SIZE_LO;
+      break;
+
+    case WAIT_SIZE_LO:
+      sizeLo = data;
+      if(protocol == ADALIGHT){
+        //Adalight sends the LED count minus one
+        payloadLength = 3*(((uint32_t)sizeHi << 8 | sizeLo) + 1);
+        state = WAIT_CHECKSUM;
+        break;
+      }
+      payloadLength = (uint32_t)sizeHi << 8 | sizeLo;
+      payloadIndex = 0;
+      channel = 0;
+      startPayload();
+      state = (payloadLength) ? PAYLOAD : WAIT_END;
+      break;
+
+    case WAIT_CHECKSUM:
+      if(data != (sizeHi ^ sizeLo ^ 0x55)){
+        errorCount++;
+        state = WAIT_HEADER_0;
+        break;
+      }
+      payloadIndex = 0;
+      channel = 0;
+      startPayload();
+      state = PAYLOAD;
+      break;
+
+    case PAYLOAD:
+      if(writePtr < writeEnd){
+        uint8_t brightness = strip->getBrightness();
+        if(brightness != 255)
+          data = (data*brightness) >> 8;
+        writePtr[rgbToGrbOffset[channel]] = data;
+      }
+      if(++channel == 3){
+        channel = 0;
+        writePtr += 3;
+      }
+      if(++payloadIndex == payloadLength){
+        if(protocol == ADALIGHT)
+          return finishFrame();
+        state = WAIT_END;
+      }
+      break;
+
+    case WAIT_END:
+      if(data == TPM2_FRAME_END)
+        return finishFrame();
+      //the payload is already in the colorArray, keep the sums true to it
+      errorCount++;
+      strip->recomputePowerEstimate();
+      state = WAIT_HEADER_0;
+      break;
+  }
+  return false;
+}
+
+/************************************************************************/
+/*  Points the payload at the start of the colorArray.  Nothing is      */
+/*  written to a strip that is not GRB or has no colorArray.            */
+/************************************************************************/
+void PICxelReceiver::startPayload(void){
+  writePtr = strip->getColorArray();
+  writeEnd = writePtr;
+  if(writePtr != NULL && strip->getBytesPerLED() == 3)
+    writeEnd = writePtr + 3*(uint32_t)strip->getNumberOfLEDs();
+}
+
+/************************************************************************/
+/*  Counts the completed frame and refreshes the strip if enabled       */
+/************************************************************************/
+bool PICxelReceiver::finishFrame(void){
+  state = WAIT_HEADER_0;
+  PICXEL_TRACE(PICXEL_TRACE_FRAME_RECEIVED, frameCount);
+  frameCount++;
+  //the payload rewrote the whole strip
+  strip->recomputePowerEstimate();
+  if(autoRefresh)
+    strip->refreshLEDs();
+  return true;
+}
+
+/************************************************************************/
+/*  Returns the number of valid frames received                         */
+/************************************************************************/
+uint32_t PICxelReceiver::getFrameCount(void){
+  return frameCount;
+}
+
+/************************************************************************/
+/*  Returns the number of frames dropped for a bad checksum or a        */
+/*  missing end byte                                                    */
+/************************************************************************/
+uint32_t PICxelReceiver::getErrorCount(void){
+  return errorCount;
+}
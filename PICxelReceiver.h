@@ -0,0 +1,60 @@
+/************************************************************************/
+/*  PICxelReceiver.h  - PIC32 Neopixel Library                          */
+/*                                                                      */
+/*  Streaming receiver for PC driven strips.  Parses Adalight or TPM2   */
+/*  framing from a serial Stream and writes the payload straight into   */
+/*  the colorArray of a GRB mode PICxel object, so no intermediate      */
+/*  frame buffer and no per pixel GRBsetLEDColor() calls are needed.    */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelReceiver_H
+#define PICxelReceiver_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+enum receiver_protocol_t {ADALIGHT, TPM2};
+
+class PICxelReceiver{
+public:
+  PICxelReceiver(PICxel &strip, Stream &stream, receiver_protocol_t protocol);
+
+  bool begin(void);
+  bool poll(void);
+  bool processByte(uint8_t data);
+
+  void setAutoRefresh(bool enable);
+
+  uint32_t getFrameCount(void);
+  uint32_t getErrorCount(void);
+
+private:
+  enum receiver_state_t {WAIT_HEADER_0, WAIT_HEADER_1, WAIT_HEADER_2,
+    WAIT_SIZE_HI, WAIT_SIZE_LO, WAIT_CHECKSUM, PAYLOAD, WAIT_END};
+
+  void startPayload(void);
+  bool finishFrame(void);
+
+  PICxel *strip;
+  Stream *stream;
+  receiver_protocol_t protocol;
+  receiver_state_t state;
+  bool autoRefresh;
+
+//frame parsing variables
+  uint8_t sizeHi;
+  uint8_t sizeLo;
+  uint32_t payloadLength;
+  uint32_t payloadIndex;
+  uint8_t channel;
+  uint8_t *writePtr;
+  uint8_t *writeEnd;
+
+//statistics
+  uint32_t frameCount;
+  uint32_t errorCount;
+};
+#endif // PICxelReceiver_H
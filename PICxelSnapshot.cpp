@@ -0,0 +1,283 @@
+/************************************************************************/
+/*  PICxelSnapshot.cpp  - PIC32 Neopixel Library                        */
+/*                                                                      */
+/*  Boot scene kept in program flash.  The page is written with the     */
+/*  NVM controller one word at a time and read back through the         */
+/*  uncached KSEG1 alias, so a snapshot saved since reset is seen       */
+/*  without flushing the cache.                                         */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelSnapshot.h"
+#include "PICxelAnim.h"
+
+#ifdef __mips__
+#include <sys/kmem.h>
+
+//NVMCON bits and operations
+#define NVM_WR            0x8000
+#define NVM_WREN          0x4000
+#define NVM_ERRORS        0x3000    //WRERR and LVDERR
+#define NVM_OP_WORD       0x0001
+#define NVM_OP_PAGE_ERASE 0x0004
+
+/************************************************************************/
+/*  Runs one NVM operation on the address in NVMADDR with the unlock    */
+/*  sequence, which must not be interrupted.  The CPU stalls while a    */
+/*  flash operation runs.  Returns false on a write or low voltage      */
+/*  error.                                                              */
+/************************************************************************/
+static bool nvmOperation(uint32_t op){
+  uint32_t interruptBits;
+  uint32_t start;
+
+  NVMCON = NVM_WREN | op;
+  //the low voltage detect needs 6 us to start on the PIC32MX
+  start = ReadCoreTimer();
+  while(ReadCoreTimer() - start < (F_CPU/2/1000000)*6);
+
+  interruptBits = disableInterrupts();
+  NVMKEY = 0xAA996655;
+  NVMKEY = 0x556699AA;
+  NVMCONSET = NVM_WR;
+  restoreInterrupts(interruptBits);
+
+  while(NVMCON & NVM_WR);
+  NVMCONCLR = NVM_WREN;
+  return (NVMCON & NVM_ERRORS) == 0;
+}
+#endif
+
+//core timer at static construction, before the core's init() and setup()
+static uint32_t bootTicks = ReadCoreTimer();
+
+/************************************************************************/
+/*  FNV-1a hash of the stored animation                                 */
+/************************************************************************/
+static uint32_t snapshotChecksum(const uint8_t *data, uint32_t length){
+  uint32_t hash = 2166136261U;
+  for(uint32_t i = 0; i < length; i++){
+    hash ^= data[i];
+    hash *= 16777619U;
+  }
+  return hash;
+}
+
+static uint32_t readWord(const uint8_t *p){
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void writeWord(uint8_t *p, uint32_t word){
+  p[0] = word;
+  p[1] = word >> 8;
+  p[2] = word >> 16;
+  p[3] = word >> 24;
+}
+
+/************************************************************************/
+/*  Construction for the PICxelSnapshot class.  page is the start of a  */
+/*  flash erase page, PICXEL_SNAPSHOT_PAGE() declares one, and bytes    */
+/*  may span several whole pages.                                       */
+/************************************************************************/
+PICxelSnapshot::PICxelSnapshot(const uint8_t *page, uint32_t bytes) : page(page),
+  size(bytes & ~3), restoreTicks(0), firstFrameTicks(0){
+}
+
+/************************************************************************/
+/*  Stores the colorArray, brightness and color mode of strip,          */
+/*  replacing the previous snapshot.  The scene is encoded into a heap  */
+/*  buffer first, so a save briefly needs about twice the colorArray    */
+/*  of free heap.  Returns false if that fails, if the scene does not   */
+/*  fit the page or if the flash reports an error.                      */
+/************************************************************************/
+bool PICxelSnapshot::save(PICxel &strip){
+  uint16_t leds = strip.getNumberOfLEDs();
+  uint8_t bytesPerLED = strip.getBytesPerLED();
+  uint32_t worst = PXS_HEADER_SIZE + PXA_HEADER_SIZE + (uint32_t)leds*(bytesPerLED + 1) + 1;
+  uint8_t *cleared = (uint8_t*)calloc(strip.getNumberOfBytes() + 1, sizeof(uint8_t));
+  uint8_t *image = (uint8_t*)malloc((worst + 3) & ~3);
+  bool saved = false;
+
+  if(cleared != NULL && image != NULL && strip.getColorArray() != NULL){
+    //a one frame animation, the frame a delta against a cleared strip
+    uint8_t *anim = image + PXS_HEADER_SIZE;
+    PXAwriteHeader(anim, leds, bytesPerLED, 1, 0);
+    uint32_t length = PXA_HEADER_SIZE +
+      PXAencodeFrame(cleared, strip.getColorArray(), leds, bytesPerLED, anim + PXA_HEADER_SIZE);
+    uint32_t total = (PXS_HEADER_SIZE + length + 3) & ~3;
+
+    image[0] = 'P';
+    image[1] = 'X';
+    image[2] = 'S';
+    image[3] = '1';
+    image[4] = strip.getBrightness();
+    image[5] = image[6] = image[7] = 0;
+    writeWord(&image[8], length);
+    writeWord(&image[12], snapshotChecksum(anim, length));
+    for(uint32_t i = PXS_HEADER_SIZE + length; i < total; i++)
+      image[i] = 0xFF;
+
+    //the magic goes last, so a reset part way leaves no snapshot
+    if(total <= size && erasePages())
+      saved = programWords(4, image + 4, total - 4) && programWords(0, image, 4);
+  }
+
+  free(cleared);
+  free(image);
+  return saved && isValid();
+}
+
+/************************************************************************/
+/*  Writes the snapshot into the colorArray and sets the brightness.    */
+/*  The strip must be in the color mode it was saved in and at least    */
+/*  as long, extra LEDs are cleared.  Nothing is sent.                  */
+/************************************************************************/
+bool PICxelSnapshot::load(PICxel &strip){
+  if(!isValid() || strip.getColorArray() == NULL)
+    return false;
+
+  const uint8_t *stored = readPointer();
+  PICxelAnim anim(strip, stored + PXS_HEADER_SIZE, storedLength());
+  if(!anim.begin() || !anim.decodeFrame())
+    return false;
+  strip.setBrightness(stored[4]);
+  return true;
+}
+
+/************************************************************************/
+/*  Loads the snapshot and sends it.  The time this took and the time   */
+/*  from static construction to the end of the frame are kept, see      */
+/*  getRestoreTicks() and getFirstFrameTicks().                         */
+/************************************************************************/
+bool PICxelSnapshot::restore(PICxel &strip){
+  uint32_t startTicks = ReadCoreTimer();
+
+  if(!load(strip))
+    return false;
+  strip.refreshLEDs();
+
+  uint32_t now = ReadCoreTimer();
+  restoreTicks = now - startTicks;
+  firstFrameTicks = now - bootTicks;
+  return true;
+}
+
+/************************************************************************/
+/*  Removes the snapshot, the next boot starts dark                     */
+/************************************************************************/
+bool PICxelSnapshot::erase(void){
+  return erasePages();
+}
+
+/************************************************************************/
+/*  Returns true if the page holds a complete, uncorrupted snapshot     */
+/************************************************************************/
+bool PICxelSnapshot::isValid(void){
+  const uint8_t *stored = readPointer();
+
+  if(size < PXS_HEADER_SIZE)
+    return false;
+  if(stored[0] != 'P' || stored[1] != 'X' || stored[2] != 'S' || stored[3] != '1')
+    return false;
+
+  uint32_t length = storedLength();
+  if(length < PXA_HEADER_SIZE || length > size - PXS_HEADER_SIZE)
+    return false;
+  return snapshotChecksum(stored + PXS_HEADER_SIZE, length) == readWord(&stored[12]);
+}
+
+/************************************************************************/
+/*  Returns the flash bytes the snapshot takes, 0 if there is none      */
+/************************************************************************/
+uint32_t PICxelSnapshot::getStoredBytes(void){
+  return isValid() ? PXS_HEADER_SIZE + storedLength() : 0;
+}
+
+/************************************************************************/
+/*  Returns the core timer ticks (F_CPU/2) the last restore() took to   */
+/*  decode and send the snapshot                                        */
+/************************************************************************/
+uint32_t PICxelSnapshot::getRestoreTicks(void){
+  return restoreTicks;
+}
+
+/************************************************************************/
+/*  Returns the core timer ticks from static construction, the closest  */
+/*  a sketch gets to reset, until the last restore() finished sending.  */
+/*  With begin() first in setup() this is the time to first frame.      */
+/************************************************************************/
+uint32_t PICxelSnapshot::getFirstFrameTicks(void){
+  return firstFrameTicks;
+}
+
+/************************************************************************/
+/*  Returns the page as it reads without the cache                      */
+/************************************************************************/
+const uint8_t* PICxelSnapshot::readPointer(void){
+#ifdef __mips__
+  return (const uint8_t*)KVA0_TO_KVA1((uint32_t)page);
+#else
+  return page;
+#endif
+}
+
+uint32_t PICxelSnapshot::storedLength(void){
+  return readWord(&readPointer()[8]);
+}
+
+/************************************************************************/
+/*  Erases every page the snapshot area covers                          */
+/************************************************************************/
+bool PICxelSnapshot::erasePages(void){
+#ifdef __mips__
+  for(uint32_t offset = 0; offset < size; offset += PICXEL_NVM_PAGE_BYTES){
+    NVMADDR = KVA_TO_PA(page + offset);
+    if(!nvmOperation(NVM_OP_PAGE_ERASE))
+      return false;
+  }
+#else
+  memset((uint8_t*)page, 0xFF, size);
+#endif
+  return true;
+}
+
+/************************************************************************/
+/*  Programs count bytes, a multiple of 4, at offset into the erased    */
+/*  page.  Words left all ones are already erased and are skipped.      */
+/************************************************************************/
+bool PICxelSnapshot::programWords(uint32_t offset, const uint8_t *bytes, uint32_t count){
+  for(uint32_t i = 0; i < count; i += 4){
+    uint32_t word = readWord(&bytes[i]);
+    if(word == 0xFFFFFFFF)
+      continue;
+#ifdef __mips__
+    NVMADDR = KVA_TO_PA(page + offset + i);
+#if defined(__PIC32MZ__)
+    NVMDATA0 = word;
+#else
+    NVMDATA = word;
+#endif
+    if(!nvmOperation(NVM_OP_WORD))
+      return false;
+#else
+    //flash can only clear bits
+    uint8_t *cell = (uint8_t*)page + offset + i;
+    for(uint8_t b = 0; b < 4; b++)
+      cell[b] &= bytes[i + b];
+#endif
+  }
+  return true;
+}
+
+/************************************************************************/
+/*  PICxel::begin() option that sends the snapshot as the first frame,  */
+/*  kept here so sketches without a snapshot do not link the NVM code.  */
+/*  Returns false, leaving the strip dark, when there is no snapshot    */
+/*  for this strip or the core clock is too slow for the LEDs.          */
+/************************************************************************/
+bool PICxel::begin(PICxelSnapshot &snapshot){
+  bool timing = begin();
+  return snapshot.restore(*this) && timing;
+}
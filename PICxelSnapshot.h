@@ -0,0 +1,82 @@
+/************************************************************************/
+/*  PICxelSnapshot.h  - PIC32 Neopixel Library                          */
+/*                                                                      */
+/*  Keeps the colorArray, brightness and color mode of a strip in a     */
+/*  reserved page of program flash, so the next boot can light the      */
+/*  strip before the sketch has rendered anything.  begin() with a      */
+/*  snapshot sends the saved scene as its first frame, call it first    */
+/*  thing in setup() and the strip goes from dark to the last scene in  */
+/*  the time of one decode and one refresh.                             */
+/*                                                                      */
+/*  Snapshot layout (16 byte header, little endian):                    */
+/*    'P' 'X' 'S' '1' (brightness)(0)(0)(0)                             */
+/*    (animation bytes, 4 bytes)(FNV-1a of the animation, 4 bytes)      */
+/*  followed by a one frame animation in the PICxelAnimFormat.h format, */
+/*  so solid and dark runs take a few bytes.  The magic is programmed   */
+/*  last, a save cut short by a reset reads as no snapshot.             */
+/*                                                                      */
+/*  Each save erases the page, flash endures some thousands of erases,  */
+/*  so save on a user action rather than on every frame.  Uploading a   */
+/*  sketch clears the page.                                             */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelSnapshot_H
+#define PICxelSnapshot_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+//size of a flash erase page
+#ifndef PICXEL_NVM_PAGE_BYTES
+#if defined(__PIC32MZ__)
+#define PICXEL_NVM_PAGE_BYTES 16384
+#elif defined(__PIC32_FEATURE_SET__) && (__PIC32_FEATURE_SET__ < 300)
+#define PICXEL_NVM_PAGE_BYTES 1024
+#else
+#define PICXEL_NVM_PAGE_BYTES 4096
+#endif
+#endif
+
+#define PXS_HEADER_SIZE 16
+
+/* Reserves one erase page of flash for a snapshot.  The initializer
+ * keeps the array out of RAM, and no valid snapshot starts with it.
+ * On the host the page is plain memory.
+ */
+#ifdef __mips__
+#define PICXEL_SNAPSHOT_PAGE(name) \
+  const uint8_t name[PICXEL_NVM_PAGE_BYTES] __attribute__((aligned(PICXEL_NVM_PAGE_BYTES))) = {0xFF}
+#else
+#define PICXEL_SNAPSHOT_PAGE(name) \
+  uint8_t name[PICXEL_NVM_PAGE_BYTES] __attribute__((aligned(4))) = {0xFF}
+#endif
+
+class PICxelSnapshot{
+public:
+  PICxelSnapshot(const uint8_t *page, uint32_t bytes);
+
+  bool save(PICxel &strip);
+  bool load(PICxel &strip);
+  bool restore(PICxel &strip);
+  bool erase(void);
+  bool isValid(void);
+  uint32_t getStoredBytes(void);
+
+  uint32_t getRestoreTicks(void);
+  uint32_t getFirstFrameTicks(void);
+
+private:
+  const uint8_t* readPointer(void);
+  uint32_t storedLength(void);
+  bool erasePages(void);
+  bool programWords(uint32_t offset, const uint8_t *bytes, uint32_t count);
+
+  const uint8_t *page;
+  uint32_t size;
+  uint32_t restoreTicks;
+  uint32_t firstFrameTicks;
+};
+#endif // PICxelSnapshot_H
@@ -0,0 +1,399 @@
+/************************************************************************/
+/*  PICxelSpectrum.cpp  - PIC32 Neopixel Library                        */
+/*                                                                      */
+/*  ADC sampling by DMA, fixed point FFT and band mapping for sound     */
+/*  reactive strips.                                                    */
+/*                                                                      */
+/*  The FFT works on Q15 values and halves them after every stage, so   */
+/*  it cannot overflow.  A full scale sine comes out of the Hann window */
+/*  and FFT near 8192 in its bin.  The tables are built once, with      */
+/*  floating point, when the first PICxelSpectrum is constructed.       */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <math.h>
+#include <string.h>
+#include "PICxelSpectrum.h"
+
+//AD1CON1 bits, auto convert after auto sample
+#define ADC_ON        0x8000
+#define ADC_SSRC_AUTO 0x00E0
+#define ADC_ASAM      0x0004
+
+//shortest ADC clock period, with margin for all PIC32MX parts
+#define ADC_MIN_TAD_NS 100
+
+//the registers below are the PIC32MX 10-bit ADC, the PIC32MZ ADC is a
+//different peripheral and is not driven
+#if defined(__mips__) && !defined(__PIC32MZ__)
+#define PICXEL_SPECTRUM_ADC
+#endif
+
+static int16_t cosTable[PICXEL_SPECTRUM_SIZE/2];
+static int16_t sinTable[PICXEL_SPECTRUM_SIZE/2];
+static int16_t hannTable[PICXEL_SPECTRUM_SIZE];
+static bool tablesReady = false;
+
+//FFT work space, shared since blocks are never processed concurrently
+static int16_t re[PICXEL_SPECTRUM_SIZE];
+static int16_t im[PICXEL_SPECTRUM_SIZE];
+
+static void buildTables(void){
+  const double pi = 3.14159265358979323846;
+
+  for(uint16_t i = 0; i < PICXEL_SPECTRUM_SIZE/2; i++){
+    cosTable[i] = (int16_t)floor(32767.0*cos(2*pi*i/PICXEL_SPECTRUM_SIZE) + 0.5);
+    sinTable[i] = (int16_t)floor(32767.0*sin(2*pi*i/PICXEL_SPECTRUM_SIZE) + 0.5);
+  }
+  for(uint16_t i = 0; i < PICXEL_SPECTRUM_SIZE; i++)
+    hannTable[i] = (int16_t)floor(32767.0*0.5*(1 - cos(2*pi*i/PICXEL_SPECTRUM_SIZE)) + 0.5);
+  tablesReady = true;
+}
+
+/************************************************************************/
+/*  Construction for the PICxelSpectrum class.  bands are spread over   */
+/*  the strip in equal runs of LEDs, lowest band first, and over the    */
+/*  FFT bins on a log scale.  At most PICXEL_SPECTRUM_MAX_BANDS, and no */
+/*  more than there are bins.                                           */
+/************************************************************************/
+PICxelSpectrum::PICxelSpectrum(PICxel &strip, uint8_t bands) : strip(&strip),
+  bands(bands), decay(200), noiseFloor(48), historyIndex(0), newSamples(0),
+  dmaChannel(0), sampleRate(0), nextHalf(0), blockCount(0), lastFFTTicks(0),
+  lastBlockTicks(0), maxBlockTicks(0){
+  if(!tablesReady)
+    buildTables();
+
+  if(this->bands > PICXEL_SPECTRUM_MAX_BANDS)
+    this->bands = PICXEL_SPECTRUM_MAX_BANDS;
+  if(this->bands > PICXEL_SPECTRUM_HOP - 1)
+    this->bands = PICXEL_SPECTRUM_HOP - 1;
+  if(this->bands == 0)
+    this->bands = 1;
+
+  //bin 0 is the DC offset and never shown
+  bandStart[0] = 1;
+  for(uint8_t b = 1; b < this->bands; b++){
+    uint32_t start = (uint32_t)floor(pow(PICXEL_SPECTRUM_HOP - 1.0, (double)b/this->bands) + 0.5);
+    uint32_t lowest = bandStart[b - 1] + 1;
+    uint32_t highest = PICXEL_SPECTRUM_HOP - (this->bands - b);
+    bandStart[b] = (start < lowest) ? lowest : (start > highest) ? highest : start;
+  }
+  bandStart[this->bands] = PICXEL_SPECTRUM_HOP;
+
+  memset(levels, 0, sizeof(levels));
+  memset(history, 0, sizeof(history));
+}
+
+/************************************************************************/
+/*  Starts sampling analog input adcChannel at close to sampleHz.  The  */
+/*  ADC converts back to back on its own clock, which is set by picking */
+/*  the ADC clock divider and sample time, so no timer is used.  DMA    */
+/*  channel dmaChannel copies each result into the ring, and poll()     */
+/*  processes each half once it is full.  pbHz is the peripheral bus    */
+/*  clock.  Returns false when sampleHz cannot be reached, and always   */
+/*  on a PIC32MZ, whose ADC is not supported; pushSamples() still works */
+/*  there.                                                              */
+/************************************************************************/
+bool PICxelSpectrum::beginADC(uint8_t adcChannel, uint32_t sampleHz, uint8_t dmaChannel, uint32_t pbHz){
+  uint32_t bestError = 0xFFFFFFFF;
+  uint32_t bestSamc = 0, bestAdcs = 0;
+
+#if defined(__mips__) && !defined(PICXEL_SPECTRUM_ADC)
+  return false;
+#endif
+  if(sampleHz == 0 || dmaChannel >= PICXEL_DMA_CHANNELS || adcChannel > 15)
+    return false;
+
+  //a conversion takes SAMC + 12 ADC clocks of 2*(ADCS + 1) bus clocks
+  for(uint32_t samc = 1; samc <= 31; samc++){
+    uint32_t divider = (pbHz/sampleHz + (samc + 12)) / (2*(samc + 12));
+    if(divider < 1)
+      divider = 1;
+    if(divider > 256)
+      continue;
+    if((uint64_t)2*divider*1000000000ULL < (uint64_t)ADC_MIN_TAD_NS*pbHz)
+      continue;
+
+    uint32_t rate = pbHz/(2*divider*(samc + 12));
+    uint32_t error = (rate > sampleHz) ? rate - sampleHz : sampleHz - rate;
+    if(error < bestError){
+      bestError = error;
+      bestSamc = samc;
+      bestAdcs = divider - 1;
+      sampleRate = rate;
+    }
+  }
+  //within 5%
+  if(bestSamc == 0 || bestError > sampleHz/20){
+    sampleRate = 0;
+    return false;
+  }
+
+  this->dmaChannel = dmaChannel;
+  nextHalf = 0;
+
+#ifdef PICXEL_SPECTRUM_ADC
+  picxel_dma_channel_t *channel = PICxelDMAchannel(dmaChannel);
+
+  AD1CON1 = 0;
+  AD1CON2 = 0;    //one result per interrupt, which starts the DMA cell
+  AD1CON3 = (bestSamc << 8) | bestAdcs;
+  AD1CHS = (uint32_t)adcChannel << 16;
+#ifdef _AD1PCFG_PCFG0_POSITION
+  AD1PCFGCLR = 1 << adcChannel;
+#endif
+
+  //no cache line of the ring may be written back over DMA results
+  PICxelDMAwriteback(adcRing, sizeof(adcRing));
+  PICxelDMAsetup(channel, (const void*)&ADC1BUF0, 2, adcRing, sizeof(adcRing), 2, _ADC_IRQ);
+  channel->CON.set = PICXEL_DMA_CHAEN | PICXEL_DMA_CHEN;
+
+  AD1CON1 = ADC_SSRC_AUTO | ADC_ASAM;
+  AD1CON1SET = ADC_ON;
+#else
+  (void)bestAdcs;
+#endif
+  return true;
+}
+
+/************************************************************************/
+/*  Returns the sample rate beginADC() set, 0 before                    */
+/************************************************************************/
+uint32_t PICxelSpectrum::getSampleRate(void){
+  return sampleRate;
+}
+
+/************************************************************************/
+/*  Processes the next half of the ADC ring once DMA has filled it and  */
+/*  draws the bands.  Returns true when the strip was redrawn and       */
+/*  should be refreshed.  Must be called at least once per hop, i.e.    */
+/*  every PICXEL_SPECTRUM_HOP/getSampleRate() seconds.                  */
+/************************************************************************/
+bool PICxelSpectrum::poll(void){
+#ifdef PICXEL_SPECTRUM_ADC
+  if(sampleRate == 0)
+    return false;
+
+  picxel_dma_channel_t *channel = PICxelDMAchannel(dmaChannel);
+  uint32_t flag = (nextHalf == 0) ? PICXEL_DMA_CHDHIF : PICXEL_DMA_CHDDIF;
+  if(!(channel->INT.reg & flag))
+    return false;
+  channel->INT.clr = flag;
+
+  //10-bit unsigned results to Q15 around mid scale
+  int16_t samples[PICXEL_SPECTRUM_HOP];
+  const volatile uint16_t *half = (const volatile uint16_t*)PICxelDMAuncached(adcRing) +
+    nextHalf*PICXEL_SPECTRUM_HOP;
+  for(uint16_t i = 0; i < PICXEL_SPECTRUM_HOP; i++)
+    samples[i] = ((int16_t)half[i] - 512)*64;
+  nextHalf ^= 1;
+
+  return pushSamples(samples, PICXEL_SPECTRUM_HOP) != 0;
+#else
+  return false;
+#endif
+}
+
+/************************************************************************/
+/*  Adds signed 16-bit samples, e.g. from a WAV file or an I2S codec,   */
+/*  in place of the ADC.  A block is processed and the strip drawn      */
+/*  after every PICXEL_SPECTRUM_HOP samples.  Returns the number of     */
+/*  blocks processed.                                                   */
+/************************************************************************/
+uint16_t PICxelSpectrum::pushSamples(const int16_t *samples, uint16_t count){
+  uint16_t blocks = 0;
+
+  while(count){
+    uint16_t n = PICXEL_SPECTRUM_HOP - newSamples;
+    if(n > count)
+      n = count;
+    for(uint16_t i = 0; i < n; i++){
+      history[historyIndex] = samples[i];
+      historyIndex = (historyIndex + 1) & (PICXEL_SPECTRUM_SIZE - 1);
+    }
+    samples += n;
+    count -= n;
+    newSamples += n;
+
+    if(newSamples == PICXEL_SPECTRUM_HOP){
+      newSamples = 0;
+      processBlock();
+      blocks++;
+    }
+  }
+  return blocks;
+}
+
+/************************************************************************/
+/*  In place radix-2 decimation in time FFT of PICXEL_SPECTRUM_SIZE     */
+/*  Q15 points.  Each stage halves its outputs, so the result is the    */
+/*  transform divided by PICXEL_SPECTRUM_SIZE.                          */
+/************************************************************************/
+void PICxelSpectrum::fft(int16_t *re, int16_t *im){
+  if(!tablesReady)
+    buildTables();
+
+  for(uint16_t i = 1, j = 0; i < PICXEL_SPECTRUM_SIZE; i++){
+    uint16_t bit = PICXEL_SPECTRUM_SIZE >> 1;
+    for(; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if(i < j){
+      int16_t t = re[i]; re[i] = re[j]; re[j] = t;
+      t = im[i]; im[i] = im[j]; im[j] = t;
+    }
+  }
+
+  for(uint16_t half = 1, stride = PICXEL_SPECTRUM_SIZE/2; half < PICXEL_SPECTRUM_SIZE; half <<= 1, stride >>= 1){
+    for(uint16_t k = 0; k < half; k++){
+      int32_t wr = cosTable[k*stride];
+      int32_t wi = -sinTable[k*stride];
+      for(uint16_t a = k; a < PICXEL_SPECTRUM_SIZE; a += 2*half){
+        uint16_t b = a + half;
+        int32_t tr = (wr*re[b] - wi*im[b]) >> 15;
+        int32_t ti = (wr*im[b] + wi*re[b]) >> 15;
+        re[b] = (re[a] - tr) >> 1;
+        im[b] = (im[a] - ti) >> 1;
+        re[a] = (re[a] + tr) >> 1;
+        im[a] = (im[a] + ti) >> 1;
+      }
+    }
+  }
+}
+
+/************************************************************************/
+/*  Windows the last PICXEL_SPECTRUM_SIZE samples, transforms them and  */
+/*  updates the band levels.  A band shows the loudest of its bins on a */
+/*  log scale of 16 steps per octave above the noise floor, and falls   */
+/*  by the decay when it gets quieter.                                  */
+/************************************************************************/
+void PICxelSpectrum::processBlock(void){
+  uint32_t startTicks = ReadCoreTimer();
+
+  for(uint16_t i = 0; i < PICXEL_SPECTRUM_SIZE; i++){
+    re[i] = ((int32_t)history[(historyIndex + i) & (PICXEL_SPECTRUM_SIZE - 1)]*hannTable[i]) >> 15;
+    im[i] = 0;
+  }
+  fft(re, im);
+  lastFFTTicks = ReadCoreTimer() - startTicks;
+
+  for(uint8_t b = 0; b < bands; b++){
+    uint32_t peak = 0;
+    for(uint16_t k = bandStart[b]; k < bandStart[b + 1]; k++){
+      uint32_t x = (re[k] < 0) ? -re[k] : re[k];
+      uint32_t y = (im[k] < 0) ? -im[k] : im[k];
+      //magnitude within 7% without a square root
+      uint32_t magnitude = (x > y) ? x + ((3*y) >> 3) : y + ((3*x) >> 3);
+      if(magnitude > peak)
+        peak = magnitude;
+    }
+
+    //16 steps per octave, 0-255 for magnitudes up to 2^15
+    uint32_t log16 = 0;
+    if(peak){
+      uint8_t bits = 0;
+      while(peak >> (bits + 1))
+        bits++;
+      log16 = bits*16 + (((peak << 4) >> bits) & 0xF);
+    }
+
+    uint32_t level = 0;
+    if(log16 > noiseFloor)
+      level = (log16 - noiseFloor)*255/(255 - noiseFloor);
+    if(level > 255)
+      level = 255;
+
+    uint8_t fallen = (levels[b]*decay) >> 8;
+    levels[b] = (level > fallen) ? level : fallen;
+  }
+
+  draw();
+  blockCount++;
+  lastBlockTicks = ReadCoreTimer() - startTicks;
+  if(lastBlockTicks > maxBlockTicks)
+    maxBlockTicks = lastBlockTicks;
+}
+
+/************************************************************************/
+/*  Draws each band as an equal run of LEDs, hue across the wheel from  */
+/*  red at the lowest band, value the band level                        */
+/************************************************************************/
+void PICxelSpectrum::draw(void){
+  uint16_t leds = strip->getNumberOfLEDs();
+
+  for(uint8_t b = 0; b < bands; b++){
+    uint16_t first = (uint32_t)b*leds/bands;
+    uint16_t next = (uint32_t)(b + 1)*leds/bands;
+    strip->fillRainbow(first, next - first, (uint32_t)b*1536/bands, 0, 255, levels[b]);
+  }
+}
+
+/************************************************************************/
+/*  Sets how fast bands fall, the level is multiplied by decay/256 per  */
+/*  block.  0 follows the sound exactly, 255 falls slowest.             */
+/************************************************************************/
+void PICxelSpectrum::setDecay(uint8_t decay){
+  this->decay = decay;
+}
+
+/************************************************************************/
+/*  Sets the level, in 16 steps per octave of FFT magnitude, that shows */
+/*  as off.  Raise it if a quiet input still lights the strip.          */
+/************************************************************************/
+void PICxelSpectrum::setNoiseFloor(uint8_t floor){
+  noiseFloor = (floor > 254) ? 254 : floor;
+}
+
+/************************************************************************/
+/*  Returns the number of bands in use                                  */
+/************************************************************************/
+uint8_t PICxelSpectrum::getBands(void){
+  return bands;
+}
+
+/************************************************************************/
+/*  Returns the level 0-255 of a band, for sketches drawing their own   */
+/************************************************************************/
+uint8_t PICxelSpectrum::getLevel(uint8_t band){
+  return (band < bands) ? levels[band] : 0;
+}
+
+/************************************************************************/
+/*  Returns the first FFT bin of a band, bin k is at                    */
+/*  k*sampleRate/PICXEL_SPECTRUM_SIZE Hz                                */
+/************************************************************************/
+uint16_t PICxelSpectrum::getBandStart(uint8_t band){
+  return (band <= bands) ? bandStart[band] : PICXEL_SPECTRUM_HOP;
+}
+
+/************************************************************************/
+/*  Returns the number of blocks processed                              */
+/************************************************************************/
+uint32_t PICxelSpectrum::getBlockCount(void){
+  return blockCount;
+}
+
+/************************************************************************/
+/*  Returns the core timer ticks (F_CPU/2) the window and FFT of the    */
+/*  last block took                                                     */
+/************************************************************************/
+uint32_t PICxelSpectrum::getLastFFTTicks(void){
+  return lastFFTTicks;
+}
+
+/************************************************************************/
+/*  Returns the core timer ticks the whole last block took, window,     */
+/*  FFT, bands and drawing                                              */
+/************************************************************************/
+uint32_t PICxelSpectrum::getLastBlockTicks(void){
+  return lastBlockTicks;
+}
+
+/************************************************************************/
+/*  Returns the core timer ticks of the slowest block so far            */
+/************************************************************************/
+uint32_t PICxelSpectrum::getMaxBlockTicks(void){
+  return maxBlockTicks;
+}
@@ -0,0 +1,81 @@
+/************************************************************************/
+/*  PICxelSpectrum.h  - PIC32 Neopixel Library                          */
+/*                                                                      */
+/*  Audio spectrum stage for sound reactive strips.  The ADC samples    */
+/*  on its own clock and DMA moves every result into a two half ring,   */
+/*  so the CPU is only needed once per half.  Each half is one hop of   */
+/*  a 50% overlapped block that gets a Hann window from a table, a      */
+/*  fixed point radix-2 FFT and a log scale, then the bins are grouped  */
+/*  into log spaced bands drawn onto a PICxel strip.  Bands fall by a   */
+/*  configurable decay per block, so peaks fade rather than flicker.    */
+/*                                                                      */
+/*  Samples can be pushed instead of sampled, which is how              */
+/*  extras/tools/picxel_spectrum_wav runs the stage on a WAV file.      */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelSpectrum_H
+#define PICxelSpectrum_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+#include "PICxelDMA.h"
+
+//FFT points, a power of two.  The DMA ring holds one hop per half in
+//PICXEL_DMA_MAX_BYTES, so 128 is the largest the ADC path takes.
+#define PICXEL_SPECTRUM_SIZE 128
+#define PICXEL_SPECTRUM_HOP (PICXEL_SPECTRUM_SIZE/2)
+#define PICXEL_SPECTRUM_MAX_BANDS 32
+
+class PICxelSpectrum{
+public:
+  PICxelSpectrum(PICxel &strip, uint8_t bands);
+
+  bool beginADC(uint8_t adcChannel, uint32_t sampleHz, uint8_t dmaChannel, uint32_t pbHz = F_CPU);
+  uint32_t getSampleRate(void);
+  bool poll(void);
+  uint16_t pushSamples(const int16_t *samples, uint16_t count);
+
+  void setDecay(uint8_t decay);
+  void setNoiseFloor(uint8_t floor);
+  uint8_t getBands(void);
+  uint8_t getLevel(uint8_t band);
+  uint16_t getBandStart(uint8_t band);
+
+  uint32_t getBlockCount(void);
+  uint32_t getLastFFTTicks(void);
+  uint32_t getLastBlockTicks(void);
+  uint32_t getMaxBlockTicks(void);
+
+  static void fft(int16_t *re, int16_t *im);
+
+private:
+  void processBlock(void);
+  void draw(void);
+
+  PICxel *strip;
+  uint8_t bands;
+  uint8_t bandStart[PICXEL_SPECTRUM_MAX_BANDS + 1];
+  uint8_t levels[PICXEL_SPECTRUM_MAX_BANDS];
+  uint8_t decay;
+  uint8_t noiseFloor;
+
+//the last PICXEL_SPECTRUM_SIZE samples, oldest at historyIndex
+  int16_t history[PICXEL_SPECTRUM_SIZE];
+  uint16_t historyIndex;
+  uint16_t newSamples;
+
+//ADC and DMA variables
+  uint8_t dmaChannel;
+  uint32_t sampleRate;
+  uint8_t nextHalf;
+  uint16_t adcRing[2*PICXEL_SPECTRUM_HOP] PICXEL_DMA_ALIGNED;
+
+  uint32_t blockCount;
+  uint32_t lastFFTTicks;
+  uint32_t lastBlockTicks;
+  uint32_t maxBlockTicks;
+};
+#endif // PICxelSpectrum_H
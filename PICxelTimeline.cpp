@@ -0,0 +1,252 @@
+/************************************************************************/
+/*  PICxelTimeline.cpp  - PIC32 Neopixel Library                        */
+/*                                                                      */
+/*  Keyframed shows with incremental fixed point blending.              */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelTimeline.h"
+
+#define HUE_STEPS 1536
+#define ONE_Q16   65536UL
+
+/************************************************************************/
+/*  Construction for the PICxelTimeline class, blending into the        */
+/*  colorArray of strip                                                 */
+/************************************************************************/
+PICxelTimeline::PICxelTimeline(PICxel &strip) : strip(&strip), buffer(NULL),
+  entries(strip.getNumberOfLEDs()), colorMode((strip.getBytesPerLED() == 3) ? GRB : HSV),
+  keys(NULL), numberOfKeys(0), loop(false), finished(true), values(NULL), steps(NULL){
+}
+
+/************************************************************************/
+/*  Construction for the PICxelTimeline class, blending into a buffer   */
+/*  of entries colors in colorArray layout                              */
+/************************************************************************/
+PICxelTimeline::PICxelTimeline(uint8_t *buffer, uint16_t entries, color_mode_t colorMode) :
+  strip(NULL), buffer(buffer), entries(entries), colorMode(colorMode), keys(NULL),
+  numberOfKeys(0), loop(false), finished(true), values(NULL), steps(NULL){
+}
+
+PICxelTimeline::~PICxelTimeline(void){
+  free(values);
+  free(steps);
+}
+
+/************************************************************************/
+/*  Sets the keyframes and allocates the channel state, 24 bytes per    */
+/*  LED.  The keyframes are not copied, they may be const arrays in     */
+/*  flash.  A timeline that does not loop ends holding the last         */
+/*  keyframe, whose frames value is not used.  Returns false if there   */
+/*  are no keyframes or the state can not be allocated.                 */
+/************************************************************************/
+bool PICxelTimeline::begin(const picxel_keyframe_t *keys, uint16_t numKeys, bool loop){
+  this->keys = keys;
+  this->numberOfKeys = numKeys;
+  this->loop = loop;
+  finished = true;
+
+  if(numKeys == 0 || entries == 0)
+    return false;
+
+  if(values == NULL)
+    values = (int32_t*)calloc(3*(uint32_t)entries, sizeof(int32_t));
+  if(steps == NULL)
+    steps = (int32_t*)calloc(3*(uint32_t)entries, sizeof(int32_t));
+  if(values == NULL || steps == NULL)
+    return false;
+
+  rewind();
+  return true;
+}
+
+/************************************************************************/
+/*  Restarts the timeline at the first keyframe                         */
+/************************************************************************/
+void PICxelTimeline::rewind(void){
+  if(values == NULL || numberOfKeys == 0)
+    return;
+  keyIndex = 0;
+  finished = false;
+  startSegment();
+}
+
+/************************************************************************/
+/*  Eases u, a 16.16 fraction of the segment from 0 to 1, returning     */
+/*  the blend fraction in the same format                               */
+/************************************************************************/
+uint32_t PICxelTimeline::ease(timeline_easing_t easing, uint32_t u){
+  uint64_t u2 = ((uint64_t)u*u) >> 16;
+
+  switch(easing){
+    case EASE_IN:
+      return u2;
+    case EASE_OUT:
+      return ONE_Q16 - (((uint64_t)(ONE_Q16 - u)*(ONE_Q16 - u)) >> 16);
+    case EASE_IN_OUT:
+      //smoothstep, 3u^2 - 2u^3
+      return (u2*(3*ONE_Q16 - 2*u)) >> 16;
+    case EASE_HOLD:
+      return (u < ONE_Q16) ? 0 : ONE_Q16;
+    default:
+      return u;
+  }
+}
+
+/************************************************************************/
+/*  Returns channel 0-2 of an LED in a keyframe.  HSV hue is 16 bits.   */
+/************************************************************************/
+int32_t PICxelTimeline::channelValue(const uint8_t *colors, uint16_t led, uint8_t channel){
+  if(colors == NULL)
+    return 0;
+  if(colorMode == GRB)
+    return colors[3*led + channel];
+
+  colors += 4*led;
+  if(channel == 0)
+    return colors[0] | colors[1] << 8;
+  return colors[channel + 1];
+}
+
+/************************************************************************/
+/*  Sets up the blend from keyIndex to the next keyframe.  The last     */
+/*  keyframe of a timeline that does not loop is held for one frame.    */
+/************************************************************************/
+void PICxelTimeline::startSegment(void){
+  const picxel_keyframe_t *key = &keys[keyIndex];
+
+  fromColors = key->colors;
+  if(!loop && keyIndex == numberOfKeys - 1){
+    toColors = fromColors;
+    segmentFrames = 1;
+    easing = EASE_LINEAR;
+  }
+  else{
+    toColors = keys[(keyIndex + 1) % numberOfKeys].colors;
+    segmentFrames = (key->frames) ? key->frames : 1;
+    easing = key->easing;
+  }
+
+  pieces = 1;
+  if(easing != EASE_LINEAR && easing != EASE_HOLD)
+    pieces = (segmentFrames < PICXEL_TIMELINE_PIECES) ? segmentFrames : PICXEL_TIMELINE_PIECES;
+
+  piece = 0;
+  segmentFrame = 0;
+  startPiece();
+}
+
+/************************************************************************/
+/*  Works out each channel's value at the start of the current piece    */
+/*  and the step that lands it on the curve at the end of the piece.    */
+/*  This is the only place that multiplies or divides.                  */
+/************************************************************************/
+void PICxelTimeline::startPiece(void){
+  uint16_t start = (uint32_t)piece*segmentFrames/pieces;
+  uint16_t end = (uint32_t)(piece + 1)*segmentFrames/pieces;
+  int32_t frames = end - start;
+  int32_t e0 = ease(easing, ((uint32_t)start << 16)/segmentFrames);
+  int32_t e1 = (easing == EASE_HOLD) ? e0 : ease(easing, ((uint32_t)end << 16)/segmentFrames);
+  int32_t *valuePtr = values;
+  int32_t *stepPtr = steps;
+
+  pieceEnd = end;
+
+  for(uint16_t led = 0; led < entries; led++){
+    for(uint8_t channel = 0; channel < 3; channel++){
+      int32_t from = channelValue(fromColors, led, channel);
+      int32_t delta = channelValue(toColors, led, channel) - from;
+
+      if(colorMode == HSV && channel == 0){
+        if(delta > HUE_STEPS/2)
+          delta -= HUE_STEPS;
+        else if(delta < -HUE_STEPS/2)
+          delta += HUE_STEPS;
+      }
+
+      //the half count offset makes the shift in step() round
+      int32_t v0 = (from << 16) + delta*e0 + 0x8000;
+      int32_t v1 = (from << 16) + delta*e1 + 0x8000;
+      *valuePtr++ = v0;
+      *stepPtr++ = (v1 - v0)/frames;
+    }
+  }
+}
+
+/************************************************************************/
+/*  Writes the next frame into the target and advances every channel   */
+/*  by its step.  Returns false once a timeline that does not loop has  */
+/*  shown its last keyframe.                                            */
+/************************************************************************/
+bool PICxelTimeline::step(void){
+  if(finished)
+    return false;
+
+  if(segmentFrame == pieceEnd){
+    if(++piece < pieces){
+      startPiece();
+    }
+    else{
+      if(++keyIndex >= numberOfKeys){
+        if(!loop){
+          finished = true;
+          return false;
+        }
+        keyIndex = 0;
+      }
+      startSegment();
+    }
+  }
+
+  uint8_t *out = (strip != NULL) ? strip->getColorArray() : buffer;
+  int32_t *valuePtr = values;
+  int32_t *stepPtr = steps;
+
+  if(colorMode == GRB){
+    for(uint32_t i = 0; i < 3*(uint32_t)entries; i++){
+      out[i] = valuePtr[i] >> 16;
+      valuePtr[i] += stepPtr[i];
+    }
+  }
+  else{
+    for(uint16_t led = 0; led < entries; led++){
+      int32_t hue = valuePtr[0] >> 16;
+      if(hue < 0)
+        hue += HUE_STEPS;
+      else if(hue >= HUE_STEPS)
+        hue -= HUE_STEPS;
+      out[0] = hue;
+      out[1] = hue >> 8;
+      out[2] = valuePtr[1] >> 16;
+      out[3] = valuePtr[2] >> 16;
+      valuePtr[0] += stepPtr[0];
+      valuePtr[1] += stepPtr[1];
+      valuePtr[2] += stepPtr[2];
+      valuePtr += 3;
+      stepPtr += 3;
+      out += 4;
+    }
+  }
+
+  segmentFrame++;
+  //the whole colorArray was rewritten
+  if(strip != NULL)
+    strip->recomputePowerEstimate();
+  return true;
+}
+
+/************************************************************************/
+/*  Returns the keyframe the current segment blends from                */
+/************************************************************************/
+uint16_t PICxelTimeline::getKeyIndex(void){
+  return keyIndex;
+}
+
+/************************************************************************/
+/*  Returns the number of frames shown in the current segment           */
+/************************************************************************/
+uint16_t PICxelTimeline::getSegmentFrame(void){
+  return segmentFrame;
+}
@@ -0,0 +1,83 @@
+/************************************************************************/
+/*  PICxelTimeline.h  - PIC32 Neopixel Library                          */
+/*                                                                      */
+/*  Keyframed shows.  A timeline is a list of keyframes, each a whole   */
+/*  color buffer laid out like the colorArray (brightness applied) and  */
+/*  the number of frames to blend from it to the next keyframe with an  */
+/*  easing curve.  step() writes one frame into the target buffer.      */
+/*                                                                      */
+/*  Every LED has three channels, green, red and blue for GRB or hue,   */
+/*  sat and val for HSV, kept as 16.16 fixed point values with a per    */
+/*  frame step, so a frame costs one add per channel.  The steps are    */
+/*  only worked out at keyframes, and for eased segments at the ends of */
+/*  PICXEL_TIMELINE_PIECES pieces that follow the curve to within about */
+/*  one count.  Hue blends the short way around the 1536 step wheel.    */
+/*                                                                      */
+/*  The target can be a strip or any buffer in the same layout, e.g. a  */
+/*  small HSV palette an effect looks colors up in.                     */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelTimeline_H
+#define PICxelTimeline_H
+
+#include <WProgram.h>
+#include <stdint.h>
+#include "PICxel.h"
+
+#define PICXEL_TIMELINE_PIECES 16
+
+enum timeline_easing_t {EASE_LINEAR, EASE_IN, EASE_OUT, EASE_IN_OUT, EASE_HOLD};
+
+typedef struct{
+  const uint8_t *colors;      //colorArray layout, NULL for all off
+  uint16_t frames;            //frames to blend to the next keyframe
+  timeline_easing_t easing;
+} picxel_keyframe_t;
+
+class PICxelTimeline{
+public:
+  PICxelTimeline(PICxel &strip);
+  PICxelTimeline(uint8_t *buffer, uint16_t entries, color_mode_t colorMode);
+  ~PICxelTimeline(void);
+
+  bool begin(const picxel_keyframe_t *keys, uint16_t numKeys, bool loop);
+  bool step(void);
+  void rewind(void);
+
+  uint16_t getKeyIndex(void);
+  uint16_t getSegmentFrame(void);
+  static uint32_t ease(timeline_easing_t easing, uint32_t u);
+
+private:
+  int32_t channelValue(const uint8_t *colors, uint16_t led, uint8_t channel);
+  void startSegment(void);
+  void startPiece(void);
+
+  PICxel *strip;
+  uint8_t *buffer;
+  uint16_t entries;
+  color_mode_t colorMode;
+
+  const picxel_keyframe_t *keys;
+  uint16_t numberOfKeys;
+  bool loop;
+  bool finished;
+
+//current segment
+  uint16_t keyIndex;
+  const uint8_t *fromColors;
+  const uint8_t *toColors;
+  uint16_t segmentFrames;
+  timeline_easing_t easing;
+  uint16_t segmentFrame;
+  uint8_t piece;
+  uint8_t pieces;
+  uint16_t pieceEnd;
+
+//16.16 channel values and per frame steps, 3 per LED
+  int32_t *values;
+  int32_t *steps;
+};
+#endif // PICxelTimeline_H
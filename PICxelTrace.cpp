@@ -0,0 +1,60 @@
+/************************************************************************/
+/*  PICxelTrace.cpp  - PIC32 Neopixel Library                           */
+/*                                                                      */
+/*  Storage and dump for the trace ring.                                */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include "PICxelTrace.h"
+
+#ifdef PICXEL_TRACE_ENABLE
+picxel_trace_entry_t picxelTraceRing[PICXEL_TRACE_DEPTH];
+volatile uint32_t picxelTraceCount = 0;
+volatile bool picxelTracePaused = false;
+#endif
+
+static const char *const traceEventNames[] = {"FRAME_START", "FRAME_RECEIVED",
+  "RENDER_START", "RENDER_END", "REFRESH_START", "IRQ_OFF", "LAST_BIT", "IRQ_ON"};
+
+/************************************************************************/
+/*  Empties the ring                                                    */
+/************************************************************************/
+void PICxelTraceClear(void){
+#ifdef PICXEL_TRACE_ENABLE
+  picxelTraceCount = 0;
+#endif
+}
+
+/************************************************************************/
+/*  Prints the ring oldest event first as CSV, ticks,event,arg.  The    */
+/*  header line gives F_CPU so ticks can be turned into time.  Events   */
+/*  are dropped while printing so the dump is consistent.               */
+/************************************************************************/
+void PICxelTraceDump(Print &out){
+  out.print("# PICxel trace, F_CPU ");
+  out.println((unsigned long)F_CPU);
+  out.println("ticks,event,arg");
+
+#ifdef PICXEL_TRACE_ENABLE
+  picxelTracePaused = true;
+  uint32_t count = picxelTraceCount;
+  uint32_t first = (count > PICXEL_TRACE_DEPTH) ? count - PICXEL_TRACE_DEPTH : 0;
+
+  for(uint32_t i = first; i < count; i++){
+    picxel_trace_entry_t *entry = &picxelTraceRing[i & (PICXEL_TRACE_DEPTH - 1)];
+    out.print((unsigned long)entry->ticks);
+    out.print(",");
+    if(entry->event < sizeof(traceEventNames)/sizeof(traceEventNames[0]))
+      out.print(traceEventNames[entry->event]);
+    else
+      out.print((unsigned long)entry->event);
+    out.print(",");
+    out.println((unsigned long)entry->arg);
+  }
+  picxelTracePaused = false;
+#else
+  (void)traceEventNames;
+#endif
+}
@@ -0,0 +1,81 @@
+/************************************************************************/
+/*  PICxelTrace.h  - PIC32 Neopixel Library                             */
+/*                                                                      */
+/*  Hot path trace ring for input to photon latency.  Trace points in   */
+/*  the library record core timer stamped events into a fixed ring:     */
+/*    FRAME_START     first byte of a received frame (receiver)         */
+/*    FRAME_RECEIVED  last byte of a received frame (receiver)          */
+/*    RENDER_START    frame decode/render begins (anim, sketch)         */
+/*    RENDER_END      frame decode/render done                          */
+/*    REFRESH_START   refreshLEDs() called                              */
+/*    IRQ_OFF         interrupts disabled for the bitstream             */
+/*    LAST_BIT        last bit of the frame has left the pin            */
+/*    IRQ_ON          interrupts restored                               */
+/*  PICxelController lockstep refreshes pass their group as the arg.    */
+/*  Sketches can add their own points with PICXEL_TRACE().              */
+/*                                                                      */
+/*  Tracing is off unless PICXEL_TRACE_ENABLE is defined here or on the */
+/*  compiler command line, and then every trace point compiles to       */
+/*  nothing.  PICxelTraceDump() prints the ring as CSV for              */
+/*  extras/tools/picxel_trace_histogram.                                */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxelTrace_H
+#define PICxelTrace_H
+
+#include <WProgram.h>
+#include <stdint.h>
+
+//#define PICXEL_TRACE_ENABLE
+
+//events kept, a power of two
+#ifndef PICXEL_TRACE_DEPTH
+#define PICXEL_TRACE_DEPTH 256
+#endif
+
+enum trace_event_t {PICXEL_TRACE_FRAME_START, PICXEL_TRACE_FRAME_RECEIVED,
+  PICXEL_TRACE_RENDER_START, PICXEL_TRACE_RENDER_END, PICXEL_TRACE_REFRESH_START,
+  PICXEL_TRACE_IRQ_OFF, PICXEL_TRACE_LAST_BIT, PICXEL_TRACE_IRQ_ON};
+
+typedef struct{
+  uint32_t ticks;   //core timer, F_CPU/2
+  uint16_t arg;     //frame number or other event detail
+  uint8_t event;
+} picxel_trace_entry_t;
+
+void PICxelTraceClear(void);
+void PICxelTraceDump(Print &out);
+
+#ifdef PICXEL_TRACE_ENABLE
+
+extern picxel_trace_entry_t picxelTraceRing[PICXEL_TRACE_DEPTH];
+extern volatile uint32_t picxelTraceCount;
+extern volatile bool picxelTracePaused;
+
+/************************************************************************/
+/*  Records one event.  Safe from interrupts, the slot is claimed with  */
+/*  interrupts held off for a few instructions.  Dropped while the ring */
+/*  is being dumped.                                                    */
+/************************************************************************/
+static inline void __attribute__((always_inline)) PICxelTraceRecord(uint8_t event, uint16_t arg){
+  if(picxelTracePaused)
+    return;
+  uint32_t interruptBits = disableInterrupts();
+  picxel_trace_entry_t *entry = &picxelTraceRing[picxelTraceCount++ & (PICXEL_TRACE_DEPTH - 1)];
+  entry->ticks = ReadCoreTimer();
+  entry->arg = arg;
+  entry->event = event;
+  restoreInterrupts(interruptBits);
+}
+
+#define PICXEL_TRACE(event, arg) PICxelTraceRecord((event), (arg))
+
+#else
+
+#define PICXEL_TRACE(event, arg) do{}while(0)
+
+#endif
+
+#endif // PICxelTrace_H
@@ -302,15 +302,14 @@ void reRainbowWrap(){
     fxVars[0] = 1; // Effect initialized
   }
 
-  byte *ptr = strip.getColorArray();
-  long color, i;
-  for(i=0; i<strip.getNumberOfLEDs(); i++) {
-   color = hsv2rgb(fxVars[3] + fxVars[1] * i / strip.getNumberOfLEDs(), 255, 255);
-
-    *ptr++ = color >> 16;
-    *ptr++ = color >> 8;
-    *ptr++ = color;
-  }
+  // Hue of the first LED and the hue step per LED in 16.16 fixed point,
+  // fillRainbow() only converts to RGB once per sextant of the wheel.
+  // Like the library setters it scales by the strip brightness set in
+  // setup().
+  long hue = fxVars[3] % 1536;
+  if(hue < 0) hue += 1536;
+  strip.fillRainbow(0, strip.getNumberOfLEDs(), hue,
+    (long long)fxVars[1] * 65536 / strip.getNumberOfLEDs());
   fxVars[3] += fxVars[2];
 }
 
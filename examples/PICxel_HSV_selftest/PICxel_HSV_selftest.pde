@@ -0,0 +1,68 @@
+/************************************************************************/
+/*  PICxel_HSV_selftest.pde - PIC32 Neopixel Library self test          */
+/*																		*/
+/*  Checks the assembly HSVToColor() against the portable C reference   */
+/*  HSVToColorReference() for every hue, saturation and value, then     */
+/*  times both refresh routines with the core timer and prints the      */
+/*  average bit period, which should be close to 1250 ns.  No LEDs are  */
+/*  needed, the pin only has to be free.                                */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+
+#define number_of_LEDs 100
+#define LED_pin 0
+
+PICxel grbStrip(number_of_LEDs, LED_pin, GRB);
+PICxel hsvStrip(number_of_LEDs, LED_pin, HSV);
+
+void printBitPeriod(const char *name, PICxel &strip){
+	uint32_t start = ReadCoreTimer();
+	strip.refreshLEDs();
+	uint32_t ticks = ReadCoreTimer() - start;
+
+	//core timer runs at F_CPU/2
+	uint32_t ns = (uint32_t)(((uint64_t)ticks*2000000000ULL/F_CPU)/(24UL*number_of_LEDs));
+	Serial.print(name);
+	Serial.print(" bit period ns: ");
+	Serial.println(ns);
+}
+
+void setup(){
+	Serial.begin(115200);
+	delay(2000);
+	bool timing = grbStrip.begin();
+	timing &= hsvStrip.begin();
+	if(!timing)
+		Serial.println("core clock too slow for the LED timing, nothing will be sent");
+
+	uint32_t mismatches = 0;
+	for(uint32_t hue = 0; hue < 1536; hue++){
+		for(uint32_t sat = 0; sat < 256; sat++){
+			for(uint32_t val = 0; val < 256; val++){
+				uint32_t hsv = hue | sat << 16 | val << 24;
+				if(grbStrip.HSVToColor(hsv) != PICxel::HSVToColorReference(hsv)){
+					if(mismatches < 10){
+						Serial.print("mismatch at 0x");
+						Serial.println(hsv, HEX);
+					}
+					mismatches++;
+				}
+			}
+		}
+	}
+	Serial.print("HSVToColor mismatches: ");
+	Serial.println(mismatches);
+
+	for(int i = 0; i < number_of_LEDs; i++){
+		grbStrip.GRBsetLEDColor(i, i, 255 - i, 0x55);
+		hsvStrip.HSVsetLEDColor(i, i*15, 255, 128);
+	}
+	printBitPeriod("GRB", grbStrip);
+	printBitPeriod("HSV", hsvStrip);
+}
+
+void loop(){
+}
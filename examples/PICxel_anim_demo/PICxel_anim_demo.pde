@@ -0,0 +1,37 @@
+/************************************************************************/
+/*  PICxel_anim_demo.pde - PIC32 Neopixel Library Demo                  */
+/*																		*/
+/*  Plays a compressed animation stored in flash.  chase_animation.h    */
+/*  was generated with extras/tools/picxel_anim_encode.  Decode time    */
+/*  per frame is printed in core timer ticks (F_CPU/2).                 */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+#include <PICxelAnim.h>
+#include "chase_animation.h"
+
+#define number_of_LEDs 15
+#define LED_pin 0
+
+PICxel strip(number_of_LEDs, LED_pin, GRB);
+PICxelAnim anim(strip, chase_animation, sizeof(chase_animation));
+
+void setup(){
+	Serial.begin(115200);
+	strip.begin();
+	if(!anim.begin())
+		Serial.println("animation does not fit the strip");
+}
+
+void loop(){
+	if(!anim.decodeFrame()){
+		Serial.print("max decode ticks: ");
+		Serial.println(anim.getMaxDecodeTicks());
+		anim.rewind();
+		return;
+	}
+	strip.refreshLEDs();
+	delay(anim.getFramePeriod());
+}
@@ -0,0 +1,13 @@
+// generated by picxel_anim_encode
+const uint8_t chase_animation[156] = {
+  0x50, 0x58, 0x41, 0x31, 0x0F, 0x00, 0x03, 0x00, 0x0F, 0x00, 0x32, 0x00, 0x80, 0x00, 0x28, 0x00,
+  0x0D, 0xC0, 0x81, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x0C, 0xC0, 0x00, 0x81, 0x00, 0x00, 0x00,
+  0x00, 0x28, 0x00, 0x0B, 0xC0, 0x01, 0x81, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x0A, 0xC0, 0x02,
+  0x81, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x09, 0xC0, 0x03, 0x81, 0x00, 0x00, 0x00, 0x00, 0x28,
+  0x00, 0x08, 0xC0, 0x04, 0x81, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x07, 0xC0, 0x05, 0x81, 0x00,
+  0x00, 0x00, 0x00, 0x28, 0x00, 0x06, 0xC0, 0x06, 0x81, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x05,
+  0xC0, 0x07, 0x81, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x04, 0xC0, 0x08, 0x81, 0x00, 0x00, 0x00,
+  0x00, 0x28, 0x00, 0x03, 0xC0, 0x09, 0x81, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x02, 0xC0, 0x0A,
+  0x81, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0x01, 0xC0, 0x0B, 0x81, 0x00, 0x00, 0x00, 0x00, 0x28,
+  0x00, 0x00, 0xC0, 0x0C, 0x81, 0x00, 0x00, 0x00, 0x00, 0x28, 0x00, 0xC0,
+};
@@ -0,0 +1,66 @@
+/************************************************************************/
+/*  PICxel_arena_demo.pde - PIC32 Neopixel Library Demo                 */
+/*																		*/
+/*  Three strips and a back buffer share one static block instead of   */
+/*  the heap.  The strips are built noalloc and attached to the arena,  */
+/*  and each begin() prints the framebuffer total, then the arena lists */
+/*  its buffers.                                                        */
+/*  The back buffer is drawn into and copied to the first strip.        */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+#include <PICxelArena.h>
+
+#define number_of_LEDs_strip1 60
+#define number_of_LEDs_strip2 30
+#define number_of_LEDs_strip3 30
+
+PICXEL_ARENA_BLOCK(frameMemory, 3*number_of_LEDs_strip1 + 3*number_of_LEDs_strip2 +
+  4*number_of_LEDs_strip3 + 3*number_of_LEDs_strip1);
+
+PICxelArena arena(frameMemory, sizeof(frameMemory));
+PICxel strip1(number_of_LEDs_strip1, 0, GRB, noalloc);
+PICxel strip2(number_of_LEDs_strip2, 1, GRB, noalloc);
+PICxel strip3(number_of_LEDs_strip3, 2, HSV, noalloc);
+uint8_t *backBuffer;
+
+uint16_t hue = 0;
+
+void setup(){
+	Serial.begin(115200);
+
+	if(!arena.attach(strip1, "strip1") || !arena.attach(strip2, "strip2") ||
+	   !arena.attach(strip3, "strip3") ||
+	   (backBuffer = arena.allocateFor(strip1, "back")) == NULL){
+		Serial.println("frameMemory is too small");
+		while(1);
+	}
+
+	strip1.begin(Serial);
+	strip2.begin(Serial);
+	strip3.begin(Serial);
+	arena.report(Serial);
+}
+
+void loop(){
+	//draw the next frame of strip1 in the back buffer, then show it
+	for(int i = 0; i < number_of_LEDs_strip1; i++){
+		uint32_t color = strip1.HSVToColor(((hue + 25*i) % 1536) | 255L << 16 | 60L << 24);
+		backBuffer[3*i] = color >> 8;
+		backBuffer[3*i + 1] = color >> 16;
+		backBuffer[3*i + 2] = color;
+	}
+	memcpy(strip1.getColorArray(), backBuffer, strip1.getNumberOfBytes());
+
+	strip2.fillRainbow(0, number_of_LEDs_strip2, 1535 - hue, 51L << 16, 255, 60);
+	strip3.fillRainbow(0, number_of_LEDs_strip3, hue, 51L << 16, 255, 60);
+
+	strip1.refreshLEDs();
+	strip2.refreshLEDs();
+	strip3.refreshLEDs();
+
+	hue = (hue + 4) % 1536;
+	delay(20);
+}
@@ -0,0 +1,27 @@
+/************************************************************************/
+/*  PICxel_benchmark.pde - PIC32 Neopixel Library benchmark             */
+/*																		*/
+/*  Runs the PICxelBench suite and prints CSV over Serial, one line per */
+/*  kernel and strip size.  Grow the buffer on boards with more RAM to  */
+/*  include the larger strip sizes (4 bytes per LED).                   */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+#include <PICxelBench.h>
+
+#define LED_pin 0
+
+uint8_t buffer[4*1024];
+
+void setup(){
+	Serial.begin(115200);
+	delay(2000);
+
+	PICxelBench bench(Serial, LED_pin, buffer, sizeof(buffer));
+	bench.run();
+}
+
+void loop(){
+}
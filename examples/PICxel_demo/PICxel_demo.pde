@@ -22,7 +22,11 @@
 PICxel strip(number_of_LEDs, LED_pin, GRB);
 
 void setup(){
-	strip.begin();
+	Serial.begin(9600);
+	//begin() returns false when the core clock is too slow for the LEDs,
+	//refreshLEDs() then sends nothing
+	if(!strip.begin())
+		Serial.println("PICxel: core clock too slow for the LED timing");
 	strip.setBrightness(30);
 	strip.clear();
 }
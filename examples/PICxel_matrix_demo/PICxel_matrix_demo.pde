@@ -0,0 +1,45 @@
+/************************************************************************/
+/*  PICxel_matrix_demo.pde - PIC32 Neopixel Library Demo                */
+/*																		*/
+/*  Scrolls a small sprite across a 32x16 serpentine LED matrix.  Each  */
+/*  scroll step is one memmove per row, not 512 setLEDColor calls.      */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+#include <PICxelMatrix.h>
+
+#define matrix_width 32
+#define matrix_height 16
+#define LED_pin 0
+#define millisecond_delay 40
+
+//3x3 GRB sprite, stored in flash
+const uint8_t arrow[3*3*3] = {
+	 0, 40, 0,   0,  0, 0,   0,  0, 0,
+	40, 40, 0,  40, 40, 0,  40, 40, 0,
+	 0, 40, 0,   0,  0, 0,   0,  0, 0,
+};
+
+PICxel strip(matrix_width*matrix_height, LED_pin, GRB);
+PICxelMatrix matrix(strip, matrix_width, matrix_height, SERPENTINE);
+
+int step = 0;
+
+void setup(){
+	strip.begin();
+	strip.setBrightness(40);
+	strip.clear();
+	matrix.rectFill(0, matrix_height - 1, matrix_width, 1, 0x000000FF);
+}
+
+void loop(){
+	matrix.scroll(1, 0);
+	if(step % 8 == 0)
+		matrix.blit(arrow, 3, 3, 0, (step / 8) % (matrix_height - 4));
+	step++;
+
+	strip.refreshLEDs();
+	delay(millisecond_delay);
+}
@@ -0,0 +1,31 @@
+/************************************************************************/
+/*  PICxel_receiver_demo.pde - PIC32 Neopixel Library Demo              */
+/*																		*/
+/*  Drives a strip from a PC running an Adalight compatible program     */
+/*  (Prismatik, Hyperion, ...).  Frames are written straight into the   */
+/*  strip's color array and the strip refreshes when a frame completes. */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+#include <PICxelReceiver.h>
+
+#define number_of_LEDs 60
+#define LED_pin 0
+#define baud_rate 115200
+
+PICxel strip(number_of_LEDs, LED_pin, GRB);
+PICxelReceiver receiver(strip, Serial, ADALIGHT);
+
+void setup(){
+	Serial.begin(baud_rate);
+	strip.begin();
+	strip.clear();
+	strip.refreshLEDs();
+	receiver.begin();
+}
+
+void loop(){
+	receiver.poll();
+}
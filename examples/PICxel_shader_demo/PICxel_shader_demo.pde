@@ -0,0 +1,38 @@
+/************************************************************************/
+/*  PICxel_shader_demo.pde - PIC32 Neopixel Library Demo                */
+/*																		*/
+/*  A moving rainbow on a long strip with no color array at all.  The   */
+/*  strip is built in noalloc mode and every LED color is computed by   */
+/*  the rainbow() shader while the previous LED is being sent.          */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+
+#define number_of_LEDs 2000
+#define LED_pin 0
+#define millisecond_delay 20
+
+PICxel strip(number_of_LEDs, LED_pin, GRB, noalloc);
+
+uint32_t rainbow(uint16_t index, uint32_t frameTime){
+	uint32_t hue = (index*4 + frameTime*8) % 1536;
+	return PICxel::HSVToColorReference(hue | 0xFFFF0000);
+}
+
+uint32_t frame = 0;
+
+void setup(){
+	Serial.begin(115200);
+	strip.begin();
+	strip.setBrightness(60);
+
+	if(!strip.shaderFits<rainbow>(0, 2))
+		Serial.println("rainbow() is too slow for the time between LEDs");
+}
+
+void loop(){
+	strip.shaderRefreshLEDs<rainbow>(frame++);
+	delay(millisecond_delay);
+}
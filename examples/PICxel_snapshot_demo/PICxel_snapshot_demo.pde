@@ -0,0 +1,64 @@
+/************************************************************************/
+/*  PICxel_snapshot_demo.pde - PIC32 Neopixel Library Demo              */
+/*																		*/
+/*  Brings the strip back up with the last saved scene.  begin() sends  */
+/*  the snapshot from flash before anything else in setup(), then the   */
+/*  time to first frame is printed.  A slow rainbow runs afterwards,    */
+/*  pressing the button on button_pin saves the current scene for the   */
+/*  next reset.                                                         */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+#include <PICxelSnapshot.h>
+
+#define number_of_LEDs 60
+#define LED_pin 0
+#define button_pin 2
+
+PICXEL_SNAPSHOT_PAGE(bootScene);
+PICxelSnapshot snapshot(bootScene, sizeof(bootScene));
+PICxel strip(number_of_LEDs, LED_pin, GRB);
+
+uint16_t hue = 0;
+int lastButton = HIGH;
+
+void setup(){
+	//first, so the saved scene is up before anything else runs
+	bool restored = strip.begin(snapshot);
+
+	Serial.begin(115200);
+	pinMode(button_pin, INPUT_PULLUP);
+
+	if(restored){
+		Serial.print("snapshot of ");
+		Serial.print(snapshot.getStoredBytes());
+		Serial.print(" bytes shown in ");
+		Serial.print(snapshot.getRestoreTicks()/(F_CPU/2000000));
+		Serial.print(" us, first frame ");
+		Serial.print(snapshot.getFirstFrameTicks()/(F_CPU/2000000));
+		Serial.println(" us after start");
+		delay(2000);
+	}
+	else{
+		Serial.println("no snapshot");
+		strip.setBrightness(60);
+	}
+}
+
+void loop(){
+	strip.fillRainbow(0, number_of_LEDs, hue, (1536L << 16)/number_of_LEDs);
+	strip.refreshLEDs();
+	hue = (hue + 2) % 1536;
+
+	int button = digitalRead(button_pin);
+	if(button == LOW && lastButton == HIGH){
+		if(snapshot.save(strip))
+			Serial.println("scene saved");
+		else
+			Serial.println("save failed");
+	}
+	lastButton = button;
+	delay(20);
+}
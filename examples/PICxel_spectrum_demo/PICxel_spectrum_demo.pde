@@ -0,0 +1,46 @@
+/************************************************************************/
+/*  PICxel_spectrum_demo.pde - PIC32 Neopixel Library Demo              */
+/*																		*/
+/*  Sound reactive bars from a microphone amplifier on analog input 0.  */
+/*  The ADC and DMA sample at 10 kHz without the CPU, and every 6.4 ms  */
+/*  poll() transforms the newest samples and redraws 12 bands.  The     */
+/*  cost of a block is printed once a second.                           */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+#include <PICxelSpectrum.h>
+
+#define number_of_LEDs 60
+#define LED_pin 0
+#define analog_channel 0
+#define dma_channel 1
+
+PICxel strip(number_of_LEDs, LED_pin, GRB);
+PICxelSpectrum spectrum(strip, 12);
+
+unsigned long lastReport = 0;
+
+void setup(){
+	Serial.begin(115200);
+	strip.begin();
+	strip.setBrightness(80);
+	spectrum.setDecay(220);
+
+	if(!spectrum.beginADC(analog_channel, 10000, dma_channel))
+		Serial.println("10 kHz ADC sampling is not possible on this board");
+}
+
+void loop(){
+	if(spectrum.poll())
+		strip.refreshLEDs();
+
+	if(millis() - lastReport >= 1000){
+		lastReport = millis();
+		Serial.print("block us: ");
+		Serial.print(spectrum.getLastBlockTicks()*2000000UL/F_CPU);
+		Serial.print(" max us: ");
+		Serial.println(spectrum.getMaxBlockTicks()*2000000UL/F_CPU);
+	}
+}
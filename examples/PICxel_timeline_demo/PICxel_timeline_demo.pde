@@ -0,0 +1,50 @@
+/************************************************************************/
+/*  PICxel_timeline_demo.pde - PIC32 Neopixel Library Demo              */
+/*																		*/
+/*  Blends an 8 LED strip between three keyframes stored in flash.      */
+/*  The blend costs one add per color channel per frame, the easing is  */
+/*  only worked out at a handful of points in each segment.             */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#include <PICxel.h>
+#include <PICxelTimeline.h>
+
+#define number_of_LEDs 8
+#define LED_pin 0
+#define millisecond_delay 20
+
+//GRB keyframes, brightness already applied
+const uint8_t sunrise[number_of_LEDs*3] = {
+	 4, 30, 0,   4, 30, 0,   4, 30, 0,   4, 30, 0,
+	 4, 30, 0,   4, 30, 0,   4, 30, 0,   4, 30, 0,
+};
+const uint8_t noon[number_of_LEDs*3] = {
+	50, 60, 40,  50, 60, 40,  50, 60, 40,  50, 60, 40,
+	50, 60, 40,  50, 60, 40,  50, 60, 40,  50, 60, 40,
+};
+const uint8_t dusk[number_of_LEDs*3] = {
+	 0, 40, 20,  0, 30, 30,  0, 20, 40,  0, 10, 50,
+	 0, 10, 50,  0, 20, 40,  0, 30, 30,  0, 40, 20,
+};
+
+const picxel_keyframe_t show[] = {
+	{sunrise, 150, EASE_IN_OUT},
+	{noon,    100, EASE_OUT},
+	{dusk,    200, EASE_IN},
+};
+
+PICxel strip(number_of_LEDs, LED_pin, GRB);
+PICxelTimeline timeline(strip);
+
+void setup(){
+	strip.begin();
+	timeline.begin(show, 3, true);
+}
+
+void loop(){
+	timeline.step();
+	strip.refreshLEDs();
+	delay(millisecond_delay);
+}
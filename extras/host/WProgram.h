@@ -0,0 +1,92 @@
+/************************************************************************/
+/*  WProgram.h  - PICxel host build shim                                */
+/*                                                                      */
+/*  Just enough of the chipKIT core for the PICxel sources to build     */
+/*  and run on a desktop machine for the tools in extras/tools.  Port   */
+/*  registers are plain memory and the core timer is emulated from the  */
+/*  system clock at F_CPU/2 so timing code reports comparable ticks.    */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+#ifndef PICxel_host_WProgram_H
+#define PICxel_host_WProgram_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifndef F_CPU
+#define F_CPU 80000000L
+#endif
+
+#define OUTPUT 1
+#define HEX 16
+#define DEC 10
+
+//fake LAT, LATCLR, LATSET registers for every port
+inline volatile uint32_t* portOutputRegister(uint8_t port){
+  static volatile uint32_t registers[8][4];
+  return registers[port & 7];
+}
+inline uint8_t digitalPinToPort(uint8_t pin){ return pin >> 4; }
+inline uint32_t digitalPinToBitMask(uint8_t pin){ return 1UL << (pin & 15); }
+inline void pinMode(uint8_t, uint8_t){}
+
+inline uint32_t disableInterrupts(void){ return 0; }
+inline void restoreInterrupts(uint32_t){}
+inline void noInterrupts(void){}
+inline void interrupts(void){}
+
+inline uint64_t hostNanoseconds(void){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+inline uint32_t ReadCoreTimer(void){ return (uint32_t)(hostNanoseconds()*(F_CPU/2/1000000)/1000); }
+inline unsigned long millis(void){ return (unsigned long)(hostNanoseconds()/1000000); }
+inline unsigned long micros(void){ return (unsigned long)(hostNanoseconds()/1000); }
+inline void delay(unsigned long){}
+
+class Print{
+public:
+  virtual ~Print(){}
+  virtual size_t write(uint8_t c){ return fputc(c, stdout) == EOF ? 0 : 1; }
+  size_t print(const char *s){ size_t n = 0; while(*s) n += write(*s++); return n; }
+  size_t print(char c){ return write(c); }
+  size_t print(unsigned long v, int base = DEC){ return printNumber(v, base); }
+  size_t print(long v, int base = DEC){
+    if(v < 0 && base == DEC) return write('-') + printNumber(-(unsigned long)v, base);
+    return printNumber(v, base);
+  }
+  size_t print(unsigned int v, int base = DEC){ return print((unsigned long)v, base); }
+  size_t print(int v, int base = DEC){ return print((long)v, base); }
+  size_t println(void){ return write('\n'); }
+  template<typename T> size_t println(T v){ return print(v) + println(); }
+  template<typename T> size_t println(T v, int base){ return print(v, base) + println(); }
+private:
+  size_t printNumber(unsigned long v, int base){
+    char buf[8*sizeof(long) + 1];
+    char *p = &buf[sizeof(buf) - 1];
+    *p = 0;
+    do{ *--p = "0123456789ABCDEF"[v % base]; v /= base; }while(v);
+    return print(p);
+  }
+};
+
+class Stream : public Print{
+public:
+  virtual int available(void){ return 0; }
+  virtual int read(void){ return -1; }
+  size_t readBytes(char *buffer, size_t length){
+    size_t n = 0;
+    int c;
+    while(n < length && (c = read()) >= 0)
+      buffer[n++] = c;
+    return n;
+  }
+};
+
+#endif // PICxel_host_WProgram_H
@@ -0,0 +1,107 @@
+/************************************************************************/
+/*  picxel_anim_encode.cpp  - PIC32 Neopixel Library host tool          */
+/*                                                                      */
+/*  Encodes raw frames into the PICxelAnim format (PICxelAnimFormat.h). */
+/*  The input is a file of back to back frames laid out exactly like    */
+/*  the colorArray: LEDs*3 bytes GRB or LEDs*4 bytes HSV per frame.     */
+/*                                                                      */
+/*  The output is either a binary .pxa file for an SD card, or, when    */
+/*  the output name ends in .h, a C header holding a const array that   */
+/*  the PIC32 compiler places in flash.                                 */
+/*                                                                      */
+/*  build: g++ -O2 -o picxel_anim_encode picxel_anim_encode.cpp         */
+/*  usage: picxel_anim_encode <LEDs> <3|4> <period ms> <in> <out>       */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+#include "../../PICxelAnimFormat.h"
+
+static bool writeHeaderFile(const char *path, const std::vector<uint8_t> &out){
+  std::string name(path);
+  size_t slash = name.find_last_of("/\\");
+  if(slash != std::string::npos)
+    name = name.substr(slash + 1);
+  name = name.substr(0, name.size() - 2);
+  for(size_t i = 0; i < name.size(); i++)
+    if(!isalnum((unsigned char)name[i]))
+      name[i] = '_';
+
+  FILE *f = fopen(path, "w");
+  if(f == NULL)
+    return false;
+  fprintf(f, "// generated by picxel_anim_encode\n");
+  fprintf(f, "const uint8_t %s[%u] = {", name.c_str(), (unsigned)out.size());
+  for(size_t i = 0; i < out.size(); i++)
+    fprintf(f, "%s0x%02X,", (i % 16) ? " " : "\n  ", out[i]);
+  fprintf(f, "\n};\n");
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv){
+  if(argc != 6){
+    fprintf(stderr, "usage: %s <LEDs> <3|4> <period ms> <in> <out[.pxa|.h]>\n", argv[0]);
+    return 1;
+  }
+
+  uint32_t numLEDs = strtoul(argv[1], NULL, 0);
+  uint32_t bytesPerLED = strtoul(argv[2], NULL, 0);
+  uint32_t periodMs = strtoul(argv[3], NULL, 0);
+  if(numLEDs == 0 || numLEDs > 0xFFFF || (bytesPerLED != 3 && bytesPerLED != 4) || periodMs > 0xFFFF){
+    fprintf(stderr, "invalid LED count, bytes per LED or period\n");
+    return 1;
+  }
+
+  FILE *in = fopen(argv[4], "rb");
+  if(in == NULL){
+    perror(argv[4]);
+    return 1;
+  }
+
+  uint32_t frameSize = numLEDs*bytesPerLED;
+  std::vector<uint8_t> prev(frameSize, 0);
+  std::vector<uint8_t> cur(frameSize);
+  std::vector<uint8_t> frame(numLEDs*(bytesPerLED + 1) + 1);
+  std::vector<uint8_t> out(PXA_HEADER_SIZE);
+  uint32_t frames = 0;
+
+  while(fread(&cur[0], 1, frameSize, in) == frameSize){
+    uint32_t len = PXAencodeFrame(&prev[0], &cur[0], numLEDs, bytesPerLED, &frame[0]);
+    out.insert(out.end(), frame.begin(), frame.begin() + len);
+    prev.swap(cur);
+    if(++frames == 0xFFFF)
+      break;
+  }
+  fclose(in);
+
+  PXAwriteHeader(&out[0], numLEDs, bytesPerLED, frames, periodMs);
+
+  std::string outPath(argv[5]);
+  bool ok;
+  if(outPath.size() > 2 && outPath.compare(outPath.size() - 2, 2, ".h") == 0){
+    ok = writeHeaderFile(argv[5], out);
+  }
+  else{
+    FILE *f = fopen(argv[5], "wb");
+    ok = (f != NULL) && fwrite(&out[0], 1, out.size(), f) == out.size();
+    if(f != NULL)
+      fclose(f);
+  }
+  if(!ok){
+    perror(argv[5]);
+    return 1;
+  }
+
+  fprintf(stderr, "%u frames, %u raw bytes -> %u bytes (%.1f%%)\n", frames,
+    frames*frameSize, (unsigned)out.size(),
+    frames ? 100.0*out.size()/(frames*frameSize) : 0.0);
+  return 0;
+}
@@ -0,0 +1,27 @@
+/************************************************************************/
+/*  picxel_bench.cpp  - PIC32 Neopixel Library host tool                */
+/*                                                                      */
+/*  Runs the PICxelBench suite on the host with the shim in             */
+/*  extras/host and prints CSV to stdout.  The same suite runs on the   */
+/*  board with the PICxel_benchmark example.                            */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -I../host -I../.. -o picxel_bench picxel_bench.cpp \      */
+/*      ../../PICxel.cpp ../../PICxelHSVCache.cpp \                     */
+/*      ../../PICxelBench.cpp                                           */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <WProgram.h>
+#include "PICxelBench.h"
+
+static uint8_t buffer[4*4096];
+
+int main(void){
+  Print out;
+  PICxelBench bench(out, 0, buffer, sizeof(buffer));
+  bench.run();
+  return 0;
+}
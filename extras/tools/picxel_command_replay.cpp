@@ -0,0 +1,300 @@
+/************************************************************************/
+/*  picxel_command_replay.cpp  - PIC32 Neopixel Library host tool       */
+/*                                                                      */
+/*  Replays a recorded PICxelCommand stream through the parser built    */
+/*  with the shim in extras/host and reports commands/s.  The stream is */
+/*  fed in serial sized pieces so commands split across reads are       */
+/*  exercised the same way they are on the board.                       */
+/*                                                                      */
+/*  The stream is then played once more through poll() from a Stream    */
+/*  that makes one piece available per call, behind a span too long for */
+/*  the receive buffer, so compaction and the overflow drop are run     */
+/*  too.  The span's payload must be skipped, not applied.  Both        */
+/*  passes must end on the same frame, and on --expect when it is       */
+/*  given.                                                              */
+/*                                                                      */
+/*  --record writes a synthetic show to replay: per frame a brightness, */
+/*  a background fill, RGB and HSV spans and a swap.  It prints the     */
+/*  hash the last frame of the show should have.                        */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -I../host -I../.. -o picxel_command_replay \              */
+/*      picxel_command_replay.cpp ../../PICxel.cpp \                    */
+/*      ../../PICxelHSVCache.cpp ../../PICxelCommand.cpp                */
+/*  usage:                                                              */
+/*    picxel_command_replay --record <out> <LEDs> <frames>              */
+/*    picxel_command_replay <in> <LEDs> [repeats] [piece bytes]         */
+/*      [--expect <hash>]                                               */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <WProgram.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <chrono>
+
+#include "PICxel.h"
+#include "PICxelCommand.h"
+
+static void put16(std::vector<uint8_t> &out, uint16_t value){
+  out.push_back(value);
+  out.push_back(value >> 8);
+}
+
+/************************************************************************/
+/*  Colors of the synthetic show, shared by record() and the expected   */
+/*  last frame                                                          */
+/************************************************************************/
+static void spanRGB(uint16_t i, uint32_t f, uint8_t *grb){
+  grb[0] = i*10;
+  grb[1] = f*3;
+  grb[2] = 255 - i*10;
+}
+
+static void spanHSV(uint16_t i, uint32_t f, uint8_t *hsv){
+  hsv[0] = (i*64 + f*8) % 1536;
+  hsv[1] = ((i*64 + f*8) % 1536) >> 8;
+  hsv[2] = 255;
+  hsv[3] = 200;
+}
+
+//FNV-1a, as picxel_golden
+static uint64_t hashFrame(const uint8_t *data, uint32_t length){
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  for(uint32_t i = 0; i < length; i++){
+    hash ^= data[i];
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+/************************************************************************/
+/*  Works out the last frame of the synthetic show from the command     */
+/*  definitions alone: every LED is filled, then spans of 24 LEDs start */
+/*  every 40, odd ones HSV, all scaled unless the brightness is full.   */
+/************************************************************************/
+static uint64_t expectedHash(uint16_t leds, uint32_t frames){
+  PICxel strip(1, 0, GRB);
+  std::vector<uint8_t> frame(3*(uint32_t)leds);
+  uint32_t f = frames - 1;
+  uint8_t brightness = 128 + (f & 127);
+
+  for(uint16_t led = 0; led < leds; led++){
+    uint8_t *dst = &frame[3*led];
+    uint16_t offset = led - f % 7;
+    dst[0] = f;
+    dst[1] = 0;
+    dst[2] = 16;
+    if(led >= f % 7 && offset % 40 < 24){
+      if((offset / 40) & 1){
+        uint8_t hsv[4];
+        spanHSV(offset % 40, f, hsv);
+        uint32_t color = strip.HSVToColor(hsv[0] | hsv[1] << 8 | hsv[2] << 16 | hsv[3] << 24);
+        dst[0] = color >> 8;
+        dst[1] = color >> 16;
+        dst[2] = color;
+      }
+      else
+        spanRGB(offset % 40, f, dst);
+    }
+    for(uint8_t c = 0; c < 3 && brightness != 255; c++)
+      dst[c] = (dst[c]*brightness) >> 8;
+  }
+  return hashFrame(&frame[0], frame.size());
+}
+
+static int record(const char *path, uint16_t leds, uint32_t frames){
+  std::vector<uint8_t> out;
+
+  for(uint32_t f = 0; f < frames; f++){
+    out.push_back(PICXEL_CMD_BRIGHTNESS);
+    out.push_back(128 + (f & 127));
+
+    out.push_back(PICXEL_CMD_FILL);
+    put16(out, 0);
+    put16(out, leds);
+    out.push_back(f);
+    out.push_back(0);
+    out.push_back(16);
+
+    //spans short enough for the board's receive buffer
+    for(uint16_t first = f % 7; first < leds; first += 40){
+      uint16_t count = (leds - first < 24) ? leds - first : 24;
+      out.push_back((first / 40) & 1 ? PICXEL_CMD_HSV_SPAN : PICXEL_CMD_SPAN);
+      put16(out, first);
+      put16(out, count);
+      for(uint16_t i = 0; i < count; i++){
+        uint8_t color[4];
+        if((first / 40) & 1){
+          spanHSV(i, f, color);
+          out.insert(out.end(), color, color + 4);
+        }
+        else{
+          spanRGB(i, f, color);
+          out.insert(out.end(), color, color + 3);
+        }
+      }
+    }
+
+    out.push_back(PICXEL_CMD_SWAP);
+  }
+
+  FILE *f = fopen(path, "wb");
+  if(f == NULL || fwrite(&out[0], 1, out.size(), f) != out.size()){
+    perror(path);
+    return 1;
+  }
+  fclose(f);
+  fprintf(stderr, "%u frames, %u bytes, last frame %016llx\n", frames, (unsigned)out.size(),
+    (unsigned long long)(frames ? expectedHash(leds, frames) : 0));
+  return 0;
+}
+
+/************************************************************************/
+/*  Stream over a byte vector that makes one more piece available each  */
+/*  time arrive() is called, like a serial driver between polls         */
+/************************************************************************/
+class PieceStream : public Stream{
+public:
+  PieceStream(const std::vector<uint8_t> &data) : data(data), position(0), end(0){}
+
+  void arrive(uint32_t piece){
+    end = (data.size() - end < piece) ? data.size() : end + piece;
+  }
+  bool drained(void){
+    return position == data.size();
+  }
+  int available(void){
+    return end - position;
+  }
+  int read(void){
+    return (position < end) ? data[position++] : -1;
+  }
+
+private:
+  const std::vector<uint8_t> &data;
+  size_t position;
+  size_t end;
+};
+
+int main(int argc, char **argv){
+  if(argc >= 5 && strcmp(argv[1], "--record") == 0)
+    return record(argv[2], strtoul(argv[3], NULL, 0), strtoul(argv[4], NULL, 0));
+
+  const char *expectArg = NULL;
+  if(argc >= 5 && strcmp(argv[argc - 2], "--expect") == 0){
+    expectArg = argv[argc - 1];
+    argc -= 2;
+  }
+  if(argc < 3){
+    fprintf(stderr, "usage: %s --record <out> <LEDs> <frames>\n"
+      "       %s <in> <LEDs> [repeats] [piece bytes] [--expect <hash>]\n", argv[0], argv[0]);
+    return 1;
+  }
+
+  uint16_t leds = strtoul(argv[2], NULL, 0);
+  uint32_t repeats = (argc > 3) ? strtoul(argv[3], NULL, 0) : 10;
+  uint32_t piece = (argc > 4) ? strtoul(argv[4], NULL, 0) : 64;
+  if(leds == 0 || repeats == 0 || piece == 0){
+    fprintf(stderr, "invalid LED count, repeats or piece size\n");
+    return 1;
+  }
+
+  FILE *in = fopen(argv[1], "rb");
+  if(in == NULL){
+    perror(argv[1]);
+    return 1;
+  }
+  std::vector<uint8_t> stream;
+  uint8_t chunk[4096];
+  size_t n;
+  while((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+    stream.insert(stream.end(), chunk, chunk + n);
+  fclose(in);
+
+  PICxel strip(leds, 0, GRB);
+  std::vector<uint8_t> back(3*(uint32_t)leds);
+  PICxelCommand command(strip);
+  command.setBackBuffer(&back[0]);
+  strip.begin();
+
+  //bytes received but not yet part of a complete command
+  std::vector<uint8_t> pending;
+  uint64_t processHash = 0;
+  uint32_t processCommands = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for(uint32_t r = 0; r < repeats; r++){
+    for(size_t offset = 0; offset < stream.size(); offset += piece){
+      size_t size = (stream.size() - offset < piece) ? stream.size() - offset : piece;
+      const uint8_t *data = &stream[offset];
+      uint32_t used;
+
+      if(pending.empty()){
+        used = command.process(data, size);
+        pending.assign(data + used, data + size);
+      }
+      else{
+        pending.insert(pending.end(), data, data + size);
+        used = command.process(&pending[0], pending.size());
+        pending.erase(pending.begin(), pending.begin() + used);
+      }
+    }
+    if(r == 0){
+      processHash = hashFrame(strip.getColorArray(), 3*(uint32_t)leds);
+      processCommands = command.getCommandCount();
+    }
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("commands,errors,bytes,seconds,commands_per_s,mbytes_per_s\n");
+  printf("%u,%u,%u,%.3f,%.0f,%.2f\n", command.getCommandCount(), command.getErrorCount(),
+    (unsigned)(stream.size()*repeats), seconds, command.getCommandCount()/seconds,
+    stream.size()*repeats/seconds/1e6);
+  bool failed = command.getErrorCount() || !pending.empty();
+
+  //once through poll(), behind a span twice the receive buffer that
+  //poll() has to drop.  Its payload is SWAP op codes, so any of it
+  //parsed as commands changes the command count and the last frame.
+  uint16_t overflowCount = 2*PICXEL_COMMAND_BUFFER/3;
+  std::vector<uint8_t> polled;
+  polled.push_back(PICXEL_CMD_SPAN);
+  put16(polled, 0);
+  put16(polled, overflowCount);
+  polled.resize(5 + 3*(uint32_t)overflowCount, PICXEL_CMD_SWAP);
+  uint32_t overflowErrors = 1;
+  polled.insert(polled.end(), stream.begin(), stream.end());
+
+  PICxel pollStrip(leds, 0, GRB);
+  std::vector<uint8_t> pollBack(3*(uint32_t)leds);
+  PICxelCommand pollCommand(pollStrip);
+  PieceStream serial(polled);
+  pollCommand.setBackBuffer(&pollBack[0]);
+  pollStrip.begin();
+  while(!serial.drained()){
+    serial.arrive(piece);
+    pollCommand.poll(serial);
+  }
+  uint64_t pollHash = hashFrame(pollStrip.getColorArray(), 3*(uint32_t)leds);
+  bool pollPass = pollHash == processHash && pollCommand.getCommandCount() == processCommands &&
+    pollCommand.getErrorCount() == overflowErrors;
+  printf("# poll() with a %u byte overflow: %u commands, %u errors (%u expected) %s\n",
+    (unsigned)(polled.size() - stream.size()), pollCommand.getCommandCount(),
+    pollCommand.getErrorCount(), overflowErrors, pollPass ? "pass" : "FAIL");
+  failed |= !pollPass;
+
+  if(expectArg != NULL){
+    uint64_t expected = strtoull(expectArg, NULL, 16);
+    printf("# last frame %016llx, expected %016llx %s\n", (unsigned long long)processHash,
+      (unsigned long long)expected, processHash == expected ? "pass" : "FAIL");
+    failed |= processHash != expected;
+  }
+  else
+    printf("# last frame %016llx\n", (unsigned long long)processHash);
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,567 @@
+/************************************************************************/
+/*  picxel_golden.cpp  - PIC32 Neopixel Library host tool               */
+/*                                                                      */
+/*  Golden frame check for the library and demo effects, built with the */
+/*  shim in extras/host.  Each effect runs for a fixed number of frames */
+/*  with a seeded generator in place of random(), and the bytes         */
+/*  fillOutputBytes() would put on the wire are hashed, so index maps,  */
+/*  HSV conversion and power limit scaling are part of what is checked. */
+/*  The hashes are compared with picxel_golden.txt and the render time  */
+/*  per frame is printed next to them, one CSV line per effect:         */
+/*                                                                      */
+/*    effect,leds,frames,hash,result,ns_per_frame,max_ns_per_frame      */
+/*                                                                      */
+/*  --update rewrites the golden file after an intended change, --ppm   */
+/*  writes one image per effect with a row per frame to look at.  The   */
+/*  demo effects are ports of the examples and have to follow them.     */
+/*  An effect with no golden hash, or one taken over a different frame  */
+/*  count, fails the run unless --update is given.  The golden file     */
+/*  defaults to picxel_golden.txt next to the tool.                     */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -I../host -I../.. -o picxel_golden picxel_golden.cpp \    */
+/*      ../../PICxel.cpp ../../PICxelHSVCache.cpp \                     */
+/*      ../../PICxelTimeline.cpp                                        */
+/*  usage:                                                              */
+/*    picxel_golden [--update] [--ppm <dir>] [--frames <n>] [golden]    */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <WProgram.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <map>
+
+#include "PICxel.h"
+#include "PICxelParticles.h"
+#include "PICxelTimeline.h"
+
+/************************************************************************/
+/*  Seeded stand-in for random(), reset before each effect so effects   */
+/*  do not depend on the order they run in                              */
+/************************************************************************/
+static uint32_t randomState;
+
+static void goldenSeed(void){
+  randomState = 0x2545F491;
+}
+
+static long goldenRandom(long howBig){
+  //xorshift32
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return (howBig > 0) ? (long)(randomState % (uint32_t)howBig) : 0;
+}
+
+/************************************************************************/
+/*  Library effects                                                     */
+/************************************************************************/
+static void rainbowSetup(PICxel &strip){
+  strip.setBrightness(200);
+}
+
+static void rainbowFrame(PICxel &strip, uint32_t frame){
+  strip.fillRainbow(0, strip.getNumberOfLEDs(), (frame*24) % 1536,
+    (1536L << 16)/strip.getNumberOfLEDs());
+}
+
+static void hsvRainbowFrame(PICxel &strip, uint32_t frame){
+  strip.fillRainbow(0, strip.getNumberOfLEDs(), (frame*7) % 1536, -(3L << 16) - 1234, 220, 160);
+}
+
+static void gradientHSVFrame(PICxel &strip, uint32_t frame){
+  strip.fillGradientHSV(0, strip.getNumberOfLEDs(), ((frame*5) % 1536) | 0xFF400000,
+    ((frame*5 + 900) % 1536) | 0x30FF0000);
+}
+
+static void gradientRGBFrame(PICxel &strip, uint32_t frame){
+  strip.fillGradientRGB(0, strip.getNumberOfLEDs(), ((frame*3) & 0xFF) << 16 | 0x0020,
+    0x00FF00 | (255 - (frame & 0xFF)));
+}
+
+//a budget far under a full white strip, so the output is always scaled
+static void powerLimitSetup(PICxel &strip){
+  strip.setPowerBudget(400);
+}
+
+static void powerLimitFrame(PICxel &strip, uint32_t frame){
+  for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++)
+    strip.GRBsetLEDColor(i, 255, (i*4 + frame) & 0xFF, 200);
+}
+
+//two halves folded onto each other with a gap, like a zig-zag panel
+static const picxel_segment_t foldSegments[] = {{0, 30, 1}, {PICXEL_NO_LED, 2, 1}, {59, 30, -1}};
+
+static void indexMapSetup(PICxel &strip){
+  strip.setIndexMap(foldSegments, 3);
+}
+
+//a 24 LED pattern reflected along 150 LEDs, the last copy cut short
+static void tiledSetup(PICxel &strip){
+  strip.setTiling(150, true);
+  strip.setPowerBudget(1500);
+}
+
+static void particlesFrame(PICxel &strip, uint32_t frame){
+  static PICxelParticles<64> particles(120, true);
+  if(frame == 0)
+    particles.clear();
+
+  if(goldenRandom(4) == 0){
+    particles.spawn((uint32_t)goldenRandom(120) << 16, goldenRandom(0x20000) - 0x10000,
+      strip.HSVToColor(goldenRandom(1536) | 0xFFFF0000), 255, 240, 0);
+  }
+  particles.update();
+  strip.clear();
+  particles.render(strip);
+}
+
+/************************************************************************/
+/*  The keyframes of the PICxel_timeline_demo example                   */
+/************************************************************************/
+static const uint8_t sunrise[8*3] = {
+   4, 30, 0,   4, 30, 0,   4, 30, 0,   4, 30, 0,
+   4, 30, 0,   4, 30, 0,   4, 30, 0,   4, 30, 0,
+};
+static const uint8_t noon[8*3] = {
+  50, 60, 40,  50, 60, 40,  50, 60, 40,  50, 60, 40,
+  50, 60, 40,  50, 60, 40,  50, 60, 40,  50, 60, 40,
+};
+static const uint8_t dusk[8*3] = {
+   0, 40, 20,  0, 30, 30,  0, 20, 40,  0, 10, 50,
+   0, 10, 50,  0, 20, 40,  0, 30, 30,  0, 40, 20,
+};
+static const picxel_keyframe_t show[] = {
+  {sunrise, 150, EASE_IN_OUT},
+  {noon,    100, EASE_OUT},
+  {dusk,    200, EASE_IN},
+};
+
+static void timelineFrame(PICxel &strip, uint32_t frame){
+  static PICxelTimeline *timeline = NULL;
+  if(frame == 0){
+    delete timeline;
+    timeline = new PICxelTimeline(strip);
+    timeline->begin(show, 3, true);
+  }
+  timeline->step();
+}
+
+/************************************************************************/
+/*  Effects of the BLT_Patterns_demo example                            */
+/************************************************************************/
+static long fxVars[50];
+
+static void bltSetup(PICxel &strip){
+  strip.setBrightness(100);
+  memset(fxVars, 0, sizeof(fxVars));
+}
+
+//reRainbowWrap()
+static void bltRainbowWrapFrame(PICxel &strip, uint32_t){
+  if(fxVars[0] == 0){
+    fxVars[1] = (1 + goldenRandom(3*((strip.getNumberOfLEDs() + 31)/32)))*1536;
+    fxVars[2] = 10 + goldenRandom(fxVars[1])/strip.getNumberOfLEDs();
+    if(goldenRandom(2) == 0) fxVars[1] = -fxVars[1];
+    if(goldenRandom(2) == 0) fxVars[2] = -fxVars[2];
+    fxVars[3] = 0;
+    fxVars[0] = 1;
+  }
+
+  long hue = fxVars[3] % 1536;
+  if(hue < 0) hue += 1536;
+  strip.fillRainbow(0, strip.getNumberOfLEDs(), hue,
+    (long long)fxVars[1]*65536/strip.getNumberOfLEDs());
+  fxVars[3] += fxVars[2];
+}
+
+//reConfetti(), the sparkles are converted with HSVToColor()
+static void bltConfettiFrame(PICxel &strip, uint32_t){
+  uint8_t *ptr = strip.getColorArray();
+  if(fxVars[0] == 0){
+    fxVars[1] = goldenRandom(1536);
+    fxVars[2] = goldenRandom(50);
+    fxVars[3] = 2 + goldenRandom(10);
+    memset(ptr, 0, 3*strip.getNumberOfLEDs());
+    fxVars[0] = 1;
+  }
+
+  uint8_t fade = fxVars[3];
+  for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++, ptr += 3){
+    if(goldenRandom(fxVars[2]) == 0){
+      uint32_t color = strip.HSVToColor(goldenRandom(1536) | 0xFF0000 | (uint32_t)strip.getBrightness() << 24);
+      ptr[0] = color >> 8;
+      ptr[1] = color >> 16;
+      ptr[2] = color;
+    }
+    else{
+      for(uint8_t c = 0; c < 3; c++)
+        ptr[c] = (ptr[c] > fade) ? ptr[c] - fade : 0;
+    }
+  }
+  strip.recomputePowerEstimate();
+}
+
+//hsv2rgb() of the demo, green in bits 16-23 and red in bits 8-15
+static long bltHsv2rgb(long h, uint8_t s, uint8_t v){
+  uint8_t r, g, b, lo;
+  int s1;
+  long v1;
+
+  h %= 1536;
+  if(h < 0) h += 1536;
+  lo = h & 255;
+  switch(h >> 8){
+  case 0 : r = 255;      g = lo;       b = 0;        break;
+  case 1 : r = 255 - lo; g = 255;      b = 0;        break;
+  case 2 : r = 0;        g = 255;      b = lo;       break;
+  case 3 : r = 0;        g = 255 - lo; b = 255;      break;
+  case 4 : r = lo;       g = 0;        b = 255;      break;
+  default: r = 255;      g = 0;        b = 255 - lo; break;
+  }
+
+  s1 = s + 1;
+  r = 255 - (((255 - r)*s1) >> 8);
+  g = 255 - (((255 - g)*s1) >> 8);
+  b = 255 - (((255 - b)*s1) >> 8);
+
+  v1 = v + 1;
+  return (((g*v1) & 0xff00) << 8) | ((r*v1) & 0xff00) | ((b*v1) >> 8);
+}
+
+//fades every byte of one LED by step, floored at 0
+static void bltFade(uint8_t *ptr, uint8_t step){
+  for(uint8_t c = 0; c < 3; c++)
+    ptr[c] = (ptr[c] > step) ? ptr[c] - step : 0;
+}
+
+//reUSAConfetti()
+static void bltUSAConfettiFrame(PICxel &strip, uint32_t){
+  static const uint8_t usa[3][3] = {{0, 255, 0}, {200, 200, 200}, {0, 0, 255}};
+  uint8_t *ptr = strip.getColorArray();
+  if(fxVars[0] == 0){
+    fxVars[1] = goldenRandom(1536);
+    fxVars[2] = 60 + goldenRandom(50);
+    fxVars[3] = 2;
+    memset(ptr, 0, 3*strip.getNumberOfLEDs());
+    fxVars[0] = 1;
+  }
+
+  for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++, ptr += 3){
+    if(goldenRandom(fxVars[2]) == 0)
+      memcpy(ptr, usa[goldenRandom(3)], 3);
+    else
+      bltFade(ptr, fxVars[3]);
+  }
+  strip.recomputePowerEstimate();
+}
+
+//reBeadChase(), positions are in twentieths of an LED
+static void bltBeadChaseFrame(PICxel &strip, uint32_t){
+  long span = 20L*strip.getNumberOfLEDs();
+  uint8_t *ptr = strip.getColorArray();
+  if(fxVars[0] == 0){
+    fxVars[1] = 6 + goldenRandom(4);
+    fxVars[2] = 4 + goldenRandom(8);
+    for(long j = 0; j < fxVars[1]; j++){
+      fxVars[3 + j*3] = goldenRandom(1536);
+      fxVars[3 + j*3 + 1] = 3 + goldenRandom(8);
+      fxVars[3 + j*3 + 2] = goldenRandom(span);
+      if(goldenRandom(2) == 0) fxVars[3 + j*3 + 1] = -fxVars[3 + j*3 + 1];
+    }
+    memset(ptr, 0, 3*strip.getNumberOfLEDs());
+    fxVars[0] = 1;
+  }
+
+  for(uint16_t i = 0; i < 3*strip.getNumberOfLEDs(); i++){
+    if(ptr[i] > 150)
+      ptr[i] = 150;
+  }
+  for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++)
+    bltFade(ptr + 3*i, fxVars[2]);
+
+  //the first bead on an LED wins
+  for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++, ptr += 3){
+    for(long j = 0; j < fxVars[1]; j++){
+      if(i == fxVars[3 + j*3 + 2]/20){
+        long color = bltHsv2rgb(fxVars[3 + j*3], 255, 255);
+        ptr[0] = color >> 16;
+        ptr[1] = color >> 8;
+        ptr[2] = color;
+        break;
+      }
+    }
+  }
+
+  for(long j = 0; j < fxVars[1]; j++){
+    fxVars[3 + j*3 + 2] = (fxVars[3 + j*3 + 2] + fxVars[3 + j*3 + 1]) % span;
+    if(fxVars[3 + j*3 + 2] < 0)
+      fxVars[3 + j*3 + 2] = (span - 1) - fxVars[3 + j*3 + 2];
+  }
+  strip.recomputePowerEstimate();
+}
+
+//reDigilentConfetti()
+static void bltDigilentConfettiFrame(PICxel &strip, uint32_t){
+  uint8_t *ptr = strip.getColorArray();
+  if(fxVars[0] == 0){
+    fxVars[1] = goldenRandom(1536);
+    fxVars[2] = 60 + goldenRandom(50);
+    fxVars[3] = 2 + goldenRandom(3);
+    memset(ptr, 0, 3*strip.getNumberOfLEDs());
+    fxVars[0] = 1;
+  }
+
+  for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++, ptr += 3){
+    if(goldenRandom(fxVars[2]) == 0){
+      if(goldenRandom(3) == 0){
+        ptr[0] = ptr[1] = ptr[2] = 200;
+      }
+      else{
+        ptr[0] = 255;
+        ptr[1] = 0;
+        ptr[2] = 0;
+      }
+    }
+    else
+      bltFade(ptr, fxVars[3]);
+  }
+  strip.recomputePowerEstimate();
+}
+
+//reDigilentSolidTwinkle(), white twinkles fade back to fxVars[4..6]
+static void bltSolidTwinkleFrame(PICxel &strip, uint32_t){
+  uint8_t *ptr = strip.getColorArray();
+  if(fxVars[0] == 0){
+    fxVars[1] = goldenRandom(1536);
+    fxVars[2] = 20 + goldenRandom(50);
+    fxVars[3] = 7 + goldenRandom(10);
+    fxVars[4] = 255;
+    fxVars[5] = 0;
+    fxVars[6] = 0;
+    for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++){
+      ptr[3*i] = fxVars[4];
+      ptr[3*i + 1] = fxVars[5];
+      ptr[3*i + 2] = fxVars[6];
+    }
+    fxVars[0] = 1;
+  }
+
+  uint8_t step = fxVars[3];
+  for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++, ptr += 3){
+    if(goldenRandom(fxVars[2]) == 0){
+      ptr[0] = ptr[1] = ptr[2] = 255;
+      continue;
+    }
+    for(uint8_t c = 0; c < 3; c++){
+      uint8_t background = fxVars[4 + c];
+      //int arithmetic, as in the demo
+      if(ptr[c] < background - step)
+        ptr[c] += step;
+      else if(ptr[c] > background + step)
+        ptr[c] -= step;
+      else
+        ptr[c] = background;
+    }
+  }
+  strip.recomputePowerEstimate();
+}
+
+typedef struct{
+  const char *name;
+  color_mode_t mode;
+  uint16_t leds;
+  void (*setup)(PICxel &strip);
+  void (*frame)(PICxel &strip, uint32_t frame);
+} golden_effect_t;
+
+static const golden_effect_t effects[] = {
+  {"rainbow",              GRB, 60,  rainbowSetup,    rainbowFrame},
+  {"rainbow_hsv",          HSV, 60,  NULL,            hsvRainbowFrame},
+  {"gradient_hsv",         GRB, 144, NULL,            gradientHSVFrame},
+  {"gradient_rgb",         GRB, 144, rainbowSetup,    gradientRGBFrame},
+  {"power_limit",          GRB, 120, powerLimitSetup, powerLimitFrame},
+  {"index_map",            GRB, 60,  indexMapSetup,   rainbowFrame},
+  {"tiled_mirror",         GRB, 24,  tiledSetup,      rainbowFrame},
+  {"particles",            GRB, 120, NULL,            particlesFrame},
+  {"timeline",             GRB, 8,   NULL,            timelineFrame},
+  {"blt_rainbowwrap",      GRB, 60,  bltSetup,        bltRainbowWrapFrame},
+  {"blt_confetti",         GRB, 60,  bltSetup,        bltConfettiFrame},
+  {"blt_usaconfetti",      GRB, 60,  bltSetup,        bltUSAConfettiFrame},
+  {"blt_beadchase",        GRB, 60,  bltSetup,        bltBeadChaseFrame},
+  {"blt_digilentconfetti", GRB, 60,  bltSetup,        bltDigilentConfettiFrame},
+  {"blt_solidtwinkle",     GRB, 60,  bltSetup,        bltSolidTwinkleFrame},
+};
+
+/************************************************************************/
+/*  Golden file, one "effect frames hash" line per effect               */
+/************************************************************************/
+static std::map<std::string, std::pair<uint32_t, uint64_t> > readGolden(const char *path){
+  std::map<std::string, std::pair<uint32_t, uint64_t> > golden;
+  FILE *f = fopen(path, "r");
+  char line[256], name[64];
+  unsigned long frames;
+  unsigned long long hash;
+
+  if(f == NULL)
+    return golden;
+  while(fgets(line, sizeof(line), f) != NULL){
+    if(line[0] != '#' && sscanf(line, "%63s %lu %llx", name, &frames, &hash) == 3)
+      golden[name] = std::make_pair((uint32_t)frames, (uint64_t)hash);
+  }
+  fclose(f);
+  return golden;
+}
+
+static bool writePPM(const std::string &path, uint16_t width, uint32_t height,
+    const std::vector<uint8_t> &rows){
+  FILE *f = fopen(path.c_str(), "wb");
+  if(f == NULL)
+    return false;
+  fprintf(f, "P6\n%u %u\n255\n", width, height);
+  //the wire order is green, red, blue
+  for(size_t i = 0; i + 2 < rows.size(); i += 3){
+    fputc(rows[i + 1], f);
+    fputc(rows[i], f);
+    fputc(rows[i + 2], f);
+  }
+  return fclose(f) == 0;
+}
+
+/************************************************************************/
+/*  Finds a file of the repository from the directory of the tool, as   */
+/*  built by the line above, or of this source, so the tool runs from   */
+/*  any working directory                                               */
+/************************************************************************/
+static std::string toolPath(const char *argv0, const char *relative){
+  const char *bases[2] = {argv0, __FILE__};
+  for(int i = 0; i < 2; i++){
+    std::string base(bases[i]);
+    size_t slash = base.rfind('/');
+    std::string path = ((slash == std::string::npos) ? std::string(".") : base.substr(0, slash)) + "/" + relative;
+    FILE *f = fopen(path.c_str(), "r");
+    if(f != NULL){
+      fclose(f);
+      return path;
+    }
+  }
+  return relative;
+}
+
+int main(int argc, char **argv){
+  std::string goldenPath = toolPath(argv[0], "picxel_golden.txt");
+  const char *ppmDir = NULL;
+  bool update = false;
+  uint32_t frames = 240;
+
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "--update") == 0)
+      update = true;
+    else if(strcmp(argv[i], "--ppm") == 0 && i + 1 < argc)
+      ppmDir = argv[++i];
+    else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+      frames = strtoul(argv[++i], NULL, 0);
+    else if(argv[i][0] != '-')
+      goldenPath = argv[i];
+    else{
+      fprintf(stderr, "usage: %s [--update] [--ppm <dir>] [--frames <n>] [golden]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(frames == 0){
+    fprintf(stderr, "invalid frame count\n");
+    return 1;
+  }
+
+  std::map<std::string, std::pair<uint32_t, uint64_t> > golden = readGolden(goldenPath.c_str());
+  std::vector<std::pair<std::string, uint64_t> > results;
+  unsigned failures = 0;
+
+  printf("# PICxel golden frames, F_CPU %lu\n", (unsigned long)F_CPU);
+  printf("effect,leds,frames,hash,result,ns_per_frame,max_ns_per_frame\n");
+
+  for(size_t e = 0; e < sizeof(effects)/sizeof(effects[0]); e++){
+    const golden_effect_t &effect = effects[e];
+    PICxel strip(effect.leds, 0, effect.mode);
+    strip.begin();
+    goldenSeed();
+    if(effect.setup != NULL)
+      effect.setup(strip);
+
+    uint16_t outputLEDs = strip.getOutputLength();
+    std::vector<uint8_t> wire(3*(uint32_t)outputLEDs);
+    std::vector<uint8_t> rows;
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    uint64_t totalTicks = 0;
+    uint32_t maxTicks = 0;
+
+    for(uint32_t f = 0; f < frames; f++){
+      uint32_t start = ReadCoreTimer();
+      effect.frame(strip, f);
+      uint32_t ticks = ReadCoreTimer() - start;
+      totalTicks += ticks;
+      if(ticks > maxTicks)
+        maxTicks = ticks;
+
+      strip.fillOutputBytes(&wire[0], 0, outputLEDs);
+      //FNV-1a
+      for(size_t i = 0; i < wire.size(); i++){
+        hash ^= wire[i];
+        hash *= 0x100000001B3ULL;
+      }
+      if(ppmDir != NULL)
+        rows.insert(rows.end(), wire.begin(), wire.end());
+    }
+
+    const char *result;
+    if(update)
+      result = "updated";
+    else if(golden.count(effect.name) == 0){
+      result = "no_golden";
+      failures++;
+    }
+    else if(golden[effect.name].first != frames){
+      result = "frames_mismatch";
+      failures++;
+    }
+    else if(golden[effect.name].second == hash)
+      result = "pass";
+    else{
+      result = "FAIL";
+      failures++;
+    }
+
+    printf("%s,%u,%u,%016llx,%s,%llu,%llu\n", effect.name, outputLEDs, frames,
+      (unsigned long long)hash, result,
+      (unsigned long long)(totalTicks*2000000000ULL/F_CPU/frames),
+      (unsigned long long)((uint64_t)maxTicks*2000000000ULL/F_CPU));
+    results.push_back(std::make_pair(std::string(effect.name), hash));
+
+    if(ppmDir != NULL && !writePPM(std::string(ppmDir) + "/" + effect.name + ".ppm",
+        outputLEDs, frames, rows)){
+      perror(ppmDir);
+      return 1;
+    }
+  }
+
+  if(update){
+    FILE *f = fopen(goldenPath.c_str(), "w");
+    if(f == NULL){
+      perror(goldenPath.c_str());
+      return 1;
+    }
+    fprintf(f, "# picxel_golden hashes, effect frames hash\n");
+    for(size_t i = 0; i < results.size(); i++)
+      fprintf(f, "%s %u %016llx\n", results[i].first.c_str(), frames,
+        (unsigned long long)results[i].second);
+    fclose(f);
+  }
+
+  return failures ? 1 : 0;
+}
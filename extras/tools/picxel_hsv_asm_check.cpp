@@ -0,0 +1,545 @@
+/************************************************************************/
+/*  picxel_hsv_asm_check.cpp  - PIC32 Neopixel Library host tool        */
+/*                                                                      */
+/*  Runs the inline assembly of PICxel::HSVrefreshLEDs() on the PC.     */
+/*  The asm template is taken from PICxel.cpp, with its HSV_* delay     */
+/*  macros from PICxel.h, and its operands are bound to fixed           */
+/*  registers.  llvm-mc assembles it for a little endian MIPS32r2 core, */
+/*  and a small interpreter of the instructions it uses runs it against */
+/*  an emulated colorArray and LATxSET/LATxCLR pair.                    */
+/*                                                                      */
+/*  Every pin write is stamped with the number of instructions retired  */
+/*  so far.  The waveform is decoded back into bytes, which must equal  */
+/*  HSVToColorReference() for every hue at several saturations and     */
+/*  values, and for a value of 0.  The high time and period of each of  */
+/*  the 24 bit slots of an LED are reported in instructions and in ns   */
+/*  at --mhz, one instruction per cycle, and checked against the T0H,   */
+/*  T1H and low time limits of the LEDs.                                */
+/*                                                                      */
+/*  Instruction counts are not cycle counts: flash wait states, the     */
+/*  prefetch cache and peripheral bus stalls are not modelled.  llvm-mc */
+/*  fills branch delay slots with nops, where GNU as may move the       */
+/*  instruction before a branch into the slot, one instruction less.    */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -I../host -I../.. -o picxel_hsv_asm_check \               */
+/*      picxel_hsv_asm_check.cpp ../../PICxel.cpp \                     */
+/*      ../../PICxelHSVCache.cpp                                        */
+/*  usage:                                                              */
+/*    picxel_hsv_asm_check [--mhz <n>] [--llvm-mc <cmd>] [source dir]   */
+/*  The source dir defaults to the repository the tool was built in.    */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <WProgram.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "PICxel.h"
+
+//emulated address map, code is loaded at 0 so j targets need no relocation
+#define CODE_BASE     0x00000000
+#define OPERANDS_BASE 0x00100000  //portClr, portSet, colorArray pointers
+#define LAT_CLR       0x00200004
+#define LAT_SET       0x00200008
+#define ARRAY_BASE    0x00300000
+#define MEMORY_BYTES  0x00400000
+
+#define PIN_MASK      0x00000400
+#define TEST_LEDS     64
+
+/************************************************************************/
+/*  Source extraction                                                   */
+/************************************************************************/
+static bool readFile(const std::string &path, std::string &text){
+  FILE *f = fopen(path.c_str(), "rb");
+  char buffer[4096];
+  size_t n;
+
+  if(f == NULL)
+    return false;
+  text.clear();
+  while((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    text.append(buffer, n);
+  fclose(f);
+  return true;
+}
+
+//reads the C string literal starting at text[i], which is a quote
+static std::string readLiteral(const std::string &text, size_t &i){
+  std::string value;
+  for(i++; i < text.size() && text[i] != '"'; i++){
+    if(text[i] != '\\' || i + 1 >= text.size()){
+      value += text[i];
+      continue;
+    }
+    char c = text[++i];
+    value += (c == 'n') ? '\n' : (c == 't') ? '\t' : c;
+  }
+  i++;
+  return value;
+}
+
+//the HSV_* string macros of PICxel.h
+static std::map<std::string, std::string> readDelayMacros(const std::string &header){
+  std::map<std::string, std::string> macros;
+  size_t pos = 0;
+
+  while((pos = header.find("#define HSV_", pos)) != std::string::npos){
+    size_t nameStart = pos + 8;
+    size_t nameEnd = nameStart;
+    while(nameEnd < header.size() && (isalnum(header[nameEnd]) || header[nameEnd] == '_'))
+      nameEnd++;
+    size_t quote = header.find('"', nameEnd);
+    size_t lineEnd = header.find('\n', nameEnd);
+    if(quote != std::string::npos && quote < lineEnd)
+      macros[header.substr(nameStart, nameEnd - nameStart)] = readLiteral(header, quote);
+    pos = nameEnd;
+  }
+  return macros;
+}
+
+/************************************************************************/
+/*  Returns the asm template of HSVrefreshLEDs() with its string        */
+/*  literals joined and macros expanded, up to the operand list.        */
+/************************************************************************/
+static bool extractTemplate(const std::string &source, const std::map<std::string, std::string> &macros,
+    std::string &asmText){
+  size_t i = source.find("void PICxel::HSVrefreshLEDs");
+  if(i == std::string::npos || (i = source.find("asm volatile(", i)) == std::string::npos)
+    return false;
+  i += 13;
+
+  asmText.clear();
+  while(i < source.size()){
+    char c = source[i];
+    if(c == '"')
+      asmText += readLiteral(source, i);
+    else if(c == '/' && i + 1 < source.size() && source[i + 1] == '/')
+      i = source.find('\n', i);
+    else if(c == ':')
+      return true;
+    else if(isalpha(c) || c == '_'){
+      size_t start = i;
+      while(i < source.size() && (isalnum(source[i]) || source[i] == '_'))
+        i++;
+      std::map<std::string, std::string>::const_iterator macro = macros.find(source.substr(start, i - start));
+      if(macro == macros.end()){
+        fprintf(stderr, "unknown name in asm template: %s\n", source.substr(start, i - start).c_str());
+        return false;
+      }
+      asmText += "\n" + macro->second + "\n";
+    }
+    else
+      i++;
+    if(i == std::string::npos)
+      break;
+  }
+  return false;
+}
+
+/************************************************************************/
+/*  Binds the operands: "r"(pinMask) to $a0, "r"(numberOfLEDs) to $a1   */
+/*  and the "m" operands portClr, portSet and colorArray to words at    */
+/*  $a3.                                                                */
+/************************************************************************/
+static std::string bindOperands(const std::string &text){
+  static const char *operands[] = {"$a0", "$a1", "0($a3)", "4($a3)", "8($a3)"};
+  std::string bound;
+  for(size_t i = 0; i < text.size(); i++){
+    if(text[i] == '%' && i + 1 < text.size() && text[i + 1] >= '0' && text[i + 1] <= '4'){
+      bound += operands[text[i + 1] - '0'];
+      i++;
+    }
+    else
+      bound += text[i];
+  }
+  return bound;
+}
+
+/************************************************************************/
+/*  Returns the .text section of a little endian ELF32 object           */
+/************************************************************************/
+static bool readText(const std::string &object, std::vector<uint8_t> &text){
+  const uint8_t *p = (const uint8_t*)object.data();
+  if(object.size() < 52 || memcmp(p, "\177ELF", 4) != 0 || p[4] != 1 || p[5] != 1)
+    return false;
+
+  #define U16(o) (uint32_t)(p[o] | p[(o) + 1] << 8)
+  #define U32(o) (uint32_t)(p[o] | p[(o) + 1] << 8 | p[(o) + 2] << 16 | (uint32_t)p[(o) + 3] << 24)
+  uint32_t shoff = U32(32), shentsize = U16(46), shnum = U16(48), shstrndx = U16(50);
+  if(shoff + shnum*shentsize > object.size() || shstrndx >= shnum)
+    return false;
+  uint32_t strtab = U32(shoff + shstrndx*shentsize + 16);
+
+  for(uint32_t s = 0; s < shnum; s++){
+    uint32_t header = shoff + s*shentsize;
+    uint32_t name = strtab + U32(header);
+    uint32_t offset = U32(header + 16), size = U32(header + 20);
+    if(name < object.size() && strcmp((const char*)p + name, ".text") == 0 &&
+       offset + size <= object.size()){
+      text.assign(p + offset, p + offset + size);
+      return true;
+    }
+  }
+  return false;
+  #undef U16
+  #undef U32
+}
+
+/************************************************************************/
+/*  MIPS32 interpreter, just the instructions the refresh uses          */
+/************************************************************************/
+typedef struct{
+  uint64_t instructions;
+  bool high;
+} pin_edge_t;
+
+class Mips{
+public:
+  Mips(const std::vector<uint8_t> &code) : memory(MEMORY_BYTES, 0), codeEnd(code.size()){
+    memcpy(&memory[CODE_BASE], &code[0], code.size());
+  }
+
+  uint32_t load(uint32_t address){
+    if(address + 4 > memory.size() || (address & 3)){
+      fault = true;
+      return 0;
+    }
+    return memory[address] | memory[address + 1] << 8 | memory[address + 2] << 16 |
+      (uint32_t)memory[address + 3] << 24;
+  }
+
+  void store(uint32_t address, uint32_t value){
+    if(address == LAT_SET || address == LAT_CLR){
+      if(value & PIN_MASK){
+        pin_edge_t edge = {instructions, address == LAT_SET};
+        edges.push_back(edge);
+      }
+      return;
+    }
+    if(address + 4 > memory.size() || (address & 3) || address < codeEnd){
+      fault = true;
+      return;
+    }
+    for(int b = 0; b < 4; b++)
+      memory[address + b] = value >> (8*b);
+  }
+
+  //runs from address 0 until the code falls off its end, false on a fault
+  bool run(uint64_t limit);
+
+  uint32_t reg[32];
+  std::vector<uint8_t> memory;
+  std::vector<pin_edge_t> edges;
+  uint64_t instructions;
+  bool fault;
+  std::string faultText;
+
+private:
+  uint32_t codeEnd;
+};
+
+bool Mips::run(uint64_t limit){
+  uint32_t pc = CODE_BASE, nextPc = CODE_BASE + 4;
+  uint32_t lo = 0, hi = 0;
+  char text[96];
+
+  instructions = 0;
+  fault = false;
+  edges.clear();
+
+  while(pc != codeEnd){
+    if(instructions++ > limit || pc > codeEnd){
+      faultText = "ran away";
+      return false;
+    }
+    uint32_t op = load(pc);
+    uint32_t rs = (op >> 21) & 31, rt = (op >> 16) & 31, rd = (op >> 11) & 31;
+    uint32_t shamt = (op >> 6) & 31;
+    uint32_t imm = op & 0xFFFF;
+    int32_t simm = (int16_t)imm;
+    uint32_t target = nextPc + 4;  //pc after nextPc unless a branch is taken
+    bool taken = false;
+    uint32_t branchTo = nextPc + ((uint32_t)simm << 2);
+
+    switch(op >> 26){
+      case 0x00:
+        switch(op & 0x3F){
+          case 0x00: reg[rd] = reg[rt] << shamt; break;                   //sll, nop
+          case 0x02: reg[rd] = reg[rt] >> shamt; break;                   //srl
+          case 0x08: taken = true; branchTo = reg[rs]; break;             //jr
+          case 0x10: reg[rd] = hi; break;                                 //mfhi
+          case 0x12: reg[rd] = lo; break;                                 //mflo
+          case 0x19:{                                                     //multu
+            uint64_t product = (uint64_t)reg[rs]*reg[rt];
+            lo = product;
+            hi = product >> 32;
+            break;
+          }
+          case 0x20: case 0x21: reg[rd] = reg[rs] + reg[rt]; break;       //add, addu
+          case 0x22: case 0x23: reg[rd] = reg[rs] - reg[rt]; break;       //sub, subu
+          case 0x24: reg[rd] = reg[rs] & reg[rt]; break;                  //and
+          case 0x25: reg[rd] = reg[rs] | reg[rt]; break;                  //or
+          case 0x2A: reg[rd] = (int32_t)reg[rs] < (int32_t)reg[rt]; break; //slt
+          case 0x2B: reg[rd] = reg[rs] < reg[rt]; break;                  //sltu
+          default: goto unknown;
+        }
+        break;
+      case 0x01:
+        if(rt == 0x01)                                                    //bgez
+          taken = (int32_t)reg[rs] >= 0;
+        else if(rt == 0x00)                                               //bltz
+          taken = (int32_t)reg[rs] < 0;
+        else
+          goto unknown;
+        break;
+      case 0x02:                                                          //j
+        taken = true;
+        branchTo = (nextPc & 0xF0000000) | ((op & 0x03FFFFFF) << 2);
+        break;
+      case 0x04: taken = reg[rs] == reg[rt]; break;                       //beq
+      case 0x05: taken = reg[rs] != reg[rt]; break;                       //bne
+      case 0x06: taken = (int32_t)reg[rs] <= 0; break;                    //blez
+      case 0x07: taken = (int32_t)reg[rs] > 0; break;                     //bgtz
+      case 0x08: case 0x09: reg[rt] = reg[rs] + simm; break;              //addi, addiu
+      case 0x0A: reg[rt] = (int32_t)reg[rs] < simm; break;                //slti
+      case 0x0C: reg[rt] = reg[rs] & imm; break;                          //andi
+      case 0x0D: reg[rt] = reg[rs] | imm; break;                          //ori
+      case 0x0F: reg[rt] = imm << 16; break;                              //lui
+      case 0x23: reg[rt] = load(reg[rs] + simm); break;                   //lw
+      case 0x2B: store(reg[rs] + simm, reg[rt]); break;                   //sw
+      default: goto unknown;
+    }
+    reg[0] = 0;
+    if(fault){
+      snprintf(text, sizeof(text), "bad access at 0x%X", pc);
+      faultText = text;
+      return false;
+    }
+
+    //branches and jumps take effect after their delay slot
+    if(taken)
+      target = branchTo;
+    pc = nextPc;
+    nextPc = target;
+    continue;
+
+unknown:
+    snprintf(text, sizeof(text), "unknown instruction 0x%08X at 0x%X", op, pc);
+    faultText = text;
+    return false;
+  }
+  return true;
+}
+
+/************************************************************************/
+/*  Runs one strip and decodes the waveform.  Each rising edge starts a */
+/*  bit, the falling edge that follows ends its high time.             */
+/************************************************************************/
+typedef struct{
+  uint32_t minHigh[2], maxHigh[2];
+  uint32_t minPeriod, maxPeriod;
+  uint32_t maxLow;
+} slot_stats_t;
+
+static bool runStrip(Mips &cpu, const uint32_t *hsv, uint16_t leds, std::vector<uint8_t> &bytes,
+    slot_stats_t *slots, uint32_t threshold){
+  for(uint16_t i = 0; i < leds; i++)
+    cpu.store(ARRAY_BASE + 4*i, hsv[i]);
+  cpu.store(OPERANDS_BASE, LAT_CLR);
+  cpu.store(OPERANDS_BASE + 4, LAT_SET);
+  cpu.store(OPERANDS_BASE + 8, ARRAY_BASE);
+  for(int r = 0; r < 32; r++)
+    cpu.reg[r] = 0;
+  cpu.reg[4] = PIN_MASK;
+  cpu.reg[5] = leds;
+  cpu.reg[7] = OPERANDS_BASE;
+  cpu.reg[29] = MEMORY_BYTES - 16;
+
+  if(!cpu.run(100000ULL*leds + 1000)){
+    fprintf(stderr, "emulation stopped: %s\n", cpu.faultText.c_str());
+    return false;
+  }
+
+  //keep only the edges that change the pin
+  std::vector<pin_edge_t> edges;
+  bool level = false;
+  for(size_t e = 0; e < cpu.edges.size(); e++){
+    if(cpu.edges[e].high != level){
+      edges.push_back(cpu.edges[e]);
+      level = cpu.edges[e].high;
+    }
+  }
+
+  bytes.assign(3*(uint32_t)leds, 0);
+  uint32_t bit = 0;
+  for(size_t e = 0; e + 1 < edges.size(); e += 2, bit++){
+    if(!edges[e].high || edges[e + 1].high || bit >= 24*(uint32_t)leds)
+      return false;
+    uint32_t high = edges[e + 1].instructions - edges[e].instructions;
+    uint32_t value = high > threshold;
+    bytes[bit/8] |= value << (7 - bit % 8);
+
+    slot_stats_t &slot = slots[bit % 24];
+    if(high < slot.minHigh[value]) slot.minHigh[value] = high;
+    if(high > slot.maxHigh[value]) slot.maxHigh[value] = high;
+    if(e + 2 < edges.size()){
+      uint32_t period = edges[e + 2].instructions - edges[e].instructions;
+      uint32_t low = edges[e + 2].instructions - edges[e + 1].instructions;
+      if(period < slot.minPeriod) slot.minPeriod = period;
+      if(period > slot.maxPeriod) slot.maxPeriod = period;
+      if(low > slot.maxLow) slot.maxLow = low;
+    }
+  }
+  return bit == 24*(uint32_t)leds && (edges.size() & 1) == 0;
+}
+
+/************************************************************************/
+/*  Finds a file of the repository from the directory of the tool, as   */
+/*  built by the line above, or of this source, so the tool runs from   */
+/*  any working directory                                               */
+/************************************************************************/
+static std::string toolPath(const char *argv0, const char *relative){
+  const char *bases[2] = {argv0, __FILE__};
+  for(int i = 0; i < 2; i++){
+    std::string base(bases[i]);
+    size_t slash = base.rfind('/');
+    std::string path = ((slash == std::string::npos) ? std::string(".") : base.substr(0, slash)) + "/" + relative;
+    FILE *f = fopen(path.c_str(), "r");
+    if(f != NULL){
+      fclose(f);
+      return path;
+    }
+  }
+  return relative;
+}
+
+int main(int argc, char **argv){
+  std::string sourceDir;
+  std::string llvmMc = "llvm-mc";
+  uint32_t mhz = 80;
+
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "--mhz") == 0 && i + 1 < argc)
+      mhz = strtoul(argv[++i], NULL, 0);
+    else if(strcmp(argv[i], "--llvm-mc") == 0 && i + 1 < argc)
+      llvmMc = argv[++i];
+    else if(argv[i][0] != '-')
+      sourceDir = argv[i];
+    else{
+      fprintf(stderr, "usage: %s [--mhz <n>] [--llvm-mc <cmd>] [source dir]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(mhz == 0){
+    fprintf(stderr, "invalid clock\n");
+    return 1;
+  }
+  if(sourceDir.empty()){
+    std::string path = toolPath(argv[0], "../../PICxel.cpp");
+    sourceDir = path.substr(0, path.rfind('/'));
+  }
+
+  std::string source, header, asmText, object;
+  if(!readFile(sourceDir + "/PICxel.cpp", source) || !readFile(sourceDir + "/PICxel.h", header)){
+    fprintf(stderr, "cannot read PICxel.cpp and PICxel.h in %s\n", sourceDir.c_str());
+    return 1;
+  }
+  if(!extractTemplate(source, readDelayMacros(header), asmText)){
+    fprintf(stderr, "cannot find the asm template of HSVrefreshLEDs()\n");
+    return 1;
+  }
+
+  //assemble in reorder mode, as inline asm is, into a temporary object
+  char asmPath[] = "/tmp/picxel_hsv_asmXXXXXX";
+  int fd = mkstemp(asmPath);
+  if(fd < 0){
+    perror("mkstemp");
+    return 1;
+  }
+  std::string objectPath = std::string(asmPath) + ".o";
+  std::string program = ".text\n.set reorder\n" + bindOperands(asmText) + "\n";
+  FILE *f = fdopen(fd, "w");
+  fwrite(program.data(), 1, program.size(), f);
+  fclose(f);
+  std::string command = llvmMc + " -triple=mipsel -mcpu=mips32r2 -filetype=obj -o " +
+    objectPath + " " + asmPath + " 2>&1";
+  int status = system(command.c_str());
+  remove(asmPath);
+  std::vector<uint8_t> code;
+  bool assembled = status == 0 && readFile(objectPath, object) && readText(object, code);
+  remove(objectPath.c_str());
+  if(!assembled || code.empty()){
+    fprintf(stderr, "%s could not assemble the template\n", llvmMc.c_str());
+    return 1;
+  }
+
+  Mips cpu(code);
+  slot_stats_t slots[24];
+  for(int s = 0; s < 24; s++){
+    slots[s].minHigh[0] = slots[s].minHigh[1] = slots[s].minPeriod = 0xFFFFFFFF;
+    slots[s].maxHigh[0] = slots[s].maxHigh[1] = slots[s].maxPeriod = slots[s].maxLow = 0;
+  }
+
+  //a 0 and a 1 are told apart at the midpoint of the limits
+  uint32_t threshold = (uint32_t)((uint64_t)(PICXEL_LOOP_T0H_MAX_NS + 550)/2*mhz/1000);
+  static const uint8_t levels[] = {0, 1, 64, 128, 200, 255};
+  uint32_t strips = 0, mismatches = 0;
+  bool decoded = true;
+
+  for(uint8_t s = 0; s < sizeof(levels) && decoded; s++){
+    for(uint8_t v = 0; v < sizeof(levels) && decoded; v++){
+      for(uint32_t firstHue = 0; firstHue < 1536 && decoded; firstHue += TEST_LEDS){
+        uint32_t hsv[TEST_LEDS];
+        std::vector<uint8_t> bytes;
+        for(uint16_t i = 0; i < TEST_LEDS; i++)
+          hsv[i] = ((firstHue + i) % 1536) | (uint32_t)levels[s] << 16 | (uint32_t)levels[v] << 24;
+
+        decoded = runStrip(cpu, hsv, TEST_LEDS, bytes, slots, threshold);
+        strips++;
+        for(uint16_t i = 0; i < TEST_LEDS && decoded; i++){
+          uint32_t color = (hsv[i] >> 24) ? PICxel::HSVToColorReference(hsv[i]) : 0;
+          uint8_t expected[3] = {(uint8_t)(color >> 8), (uint8_t)(color >> 16), (uint8_t)color};
+          if(memcmp(expected, &bytes[3*i], 3) != 0){
+            if(mismatches++ < 10)
+              printf("mismatch: HSV 0x%08X sent %02X %02X %02X, reference %02X %02X %02X\n",
+                hsv[i], bytes[3*i], bytes[3*i + 1], bytes[3*i + 2],
+                expected[0], expected[1], expected[2]);
+          }
+        }
+      }
+    }
+  }
+  if(!decoded){
+    printf("waveform could not be decoded\n");
+    return 1;
+  }
+
+  //per slot timing, one instruction per cycle at mhz
+  double ns = 1000.0/mhz;
+  unsigned timingFailures = 0;
+  printf("# HSVrefreshLEDs, %u bytes of code, %u strips of %u LEDs, %u mismatches\n",
+    (unsigned)code.size(), strips, TEST_LEDS, mismatches);
+  printf("# instructions, and ns at %u MHz with one instruction per cycle\n", mhz);
+  printf("slot,t0h,t1h_min,t1h_max,period_min,period_max,max_low,t0h_ns,t1h_min_ns,max_low_ns,result\n");
+  for(int s = 0; s < 24; s++){
+    const slot_stats_t &slot = slots[s];
+    bool ok = slot.maxHigh[0]*ns <= PICXEL_LOOP_T0H_MAX_NS &&
+      (slot.minHigh[1] == 0xFFFFFFFF || slot.minHigh[1]*ns >= 550) &&
+      slot.maxLow*ns < 5000;
+    if(!ok)
+      timingFailures++;
+    printf("%s%d,%u,%u,%u,%u,%u,%u,%.0f,%.0f,%.0f,%s\n", (s < 8) ? "g" : (s < 16) ? "r" : "b", 7 - s % 8,
+      slot.maxHigh[0], slot.minHigh[1], slot.maxHigh[1], slot.minPeriod, slot.maxPeriod, slot.maxLow,
+      slot.maxHigh[0]*ns, slot.minHigh[1]*ns, slot.maxLow*ns, ok ? "pass" : "FAIL");
+  }
+  return (mismatches || timingFailures) ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+/************************************************************************/
+/*  picxel_lockstep_check.cpp  - PIC32 Neopixel Library host tool       */
+/*                                                                      */
+/*  Checks the high times of the PICxelController lockstep bitstream.   */
+/*  The GRB_delay_* nop tables are read from PICxel.h for every F_CPU   */
+/*  they cover, and the port writes of GRBrefreshLEDs() and of          */
+/*  lockstepRefresh() are simulated one instruction per core clock for  */
+/*  two strips sending different bytes on one PORT.  Each pin's high    */
+/*  times are checked against the WS2812 T0H and T1H windows and        */
+/*  against a single strip sending the same bit.                        */
+/*                                                                      */
+/*  Instructions are not cycles: flash wait states and bus stalls are   */
+/*  not modelled, so this catches a wrong delay table, not a marginal   */
+/*  one.  Scope the pins for that.                                      */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -o picxel_lockstep_check picxel_lockstep_check.cpp        */
+/*  usage:                                                              */
+/*    picxel_lockstep_check [PICxel.h]                                  */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+//WS2812B high time windows
+#define T0H_MIN_NS 200
+#define T0H_MAX_NS 500
+#define T1H_MIN_NS 550
+#define T1H_MAX_NS 1000
+
+//instructions a lockstep bit may differ from a single strip bit by
+#define MATCH_INSTRUCTIONS 2
+
+enum {DELAY_T0H, DELAY_T0L, DELAY_T1H, DELAY_T1H_MINUS_T0H, DELAY_T1L, DELAYS};
+static const char *delayNames[DELAYS] = {"GRB_delay_T0H", "GRB_delay_T0L", "GRB_delay_T1H",
+  "GRB_delay_T1H_minus_T0H", "GRB_delay_T1L"};
+
+typedef struct{
+  unsigned long cpuHz;
+  int nops[DELAYS];
+} nop_table_t;
+
+/************************************************************************/
+/*  Reads the nop count of every delay macro in each F_CPU block        */
+/************************************************************************/
+static std::vector<nop_table_t> readTables(const char *path){
+  std::vector<nop_table_t> tables;
+  FILE *f = fopen(path, "r");
+  char line[8192];
+  unsigned long hz;
+
+  if(f == NULL){
+    perror(path);
+    return tables;
+  }
+  while(fgets(line, sizeof(line), f) != NULL){
+    if(strstr(line, "F_CPU == ") != NULL && sscanf(strstr(line, "F_CPU == "), "F_CPU == %lu", &hz) == 1 &&
+        line[0] == '#'){
+      nop_table_t table;
+      table.cpuHz = hz;
+      for(int d = 0; d < DELAYS; d++)
+        table.nops[d] = -1;
+      tables.push_back(table);
+      continue;
+    }
+    if(strncmp(line, "#else", 5) == 0 || strncmp(line, "#endif", 6) == 0){
+      hz = 0;
+      continue;
+    }
+    if(tables.empty() || hz == 0)
+      continue;
+
+    for(int d = 0; d < DELAYS; d++){
+      std::string define = std::string("#define ") + delayNames[d] + "();";
+      const char *at = strstr(line, define.c_str());
+      if(at == NULL)
+        continue;
+      int count = 0;
+      for(const char *p = at; (p = strstr(p, "nop")) != NULL; p += 3)
+        count++;
+      tables.back().nops[d] = count;
+    }
+  }
+  fclose(f);
+  return tables;
+}
+
+/************************************************************************/
+/*  Pin trace of one simulated bitstream, the clock of every edge       */
+/************************************************************************/
+typedef struct{
+  std::vector<uint64_t> rise;
+  std::vector<uint64_t> fall;
+} pin_trace_t;
+
+static void setPins(std::vector<pin_trace_t> &pins, std::vector<bool> &level, uint32_t mask, uint64_t clock){
+  for(size_t p = 0; p < pins.size(); p++){
+    if((mask & (1u << p)) && !level[p]){
+      pins[p].rise.push_back(clock);
+      level[p] = true;
+    }
+  }
+}
+
+static void clearPins(std::vector<pin_trace_t> &pins, std::vector<bool> &level, uint32_t mask, uint64_t clock){
+  for(size_t p = 0; p < pins.size(); p++){
+    if((mask & (1u << p)) && level[p]){
+      pins[p].fall.push_back(clock);
+      level[p] = false;
+    }
+  }
+}
+
+/************************************************************************/
+/*  GRBrefreshLEDs(): store, delay, store, delay per bit                */
+/************************************************************************/
+static pin_trace_t simulateSingle(const nop_table_t &table, uint8_t data){
+  std::vector<pin_trace_t> pins(1);
+  std::vector<bool> level(1, false);
+  uint64_t clock = 0;
+
+  for(uint8_t b = 0; b < 8; b++){
+    bool one = data & (0x80 >> b);
+    setPins(pins, level, 1, ++clock);
+    clock += table.nops[one ? DELAY_T1H : DELAY_T0H];
+    clearPins(pins, level, 1, ++clock);
+    clock += table.nops[one ? DELAY_T1L : DELAY_T0L];
+  }
+  return pins[0];
+}
+
+/************************************************************************/
+/*  lockstepRefresh(): all pins high, the zero mask is loaded and its   */
+/*  pins dropped after T0H, every pin dropped after the second delay    */
+/************************************************************************/
+static std::vector<pin_trace_t> simulateLockstep(const nop_table_t &table, const uint8_t *data, uint8_t strips){
+  std::vector<pin_trace_t> pins(strips);
+  std::vector<bool> level(strips, false);
+  uint32_t activeMask = (1u << strips) - 1;
+  uint64_t clock = 0;
+
+  for(uint8_t b = 0; b < 8; b++){
+    uint32_t zeroMask = 0;
+    for(uint8_t s = 0; s < strips; s++)
+      if(!(data[s] & (0x80 >> b)))
+        zeroMask |= 1u << s;
+
+    setPins(pins, level, activeMask, ++clock);
+    clock += table.nops[DELAY_T0H];
+    clock++;
+    clearPins(pins, level, zeroMask, ++clock);
+    clock += table.nops[DELAY_T1H_MINUS_T0H];
+    clearPins(pins, level, activeMask, ++clock);
+    clock += table.nops[DELAY_T1L];
+  }
+  return pins;
+}
+
+/************************************************************************/
+/*  Checks one nop table, returns the number of failures                */
+/************************************************************************/
+static unsigned checkTable(const nop_table_t &table){
+  static const uint8_t patterns[][2] = {{0xFF, 0x00}, {0xAA, 0x55}, {0x0F, 0xF0}, {0x96, 0x69}};
+  double nsPerClock = 1e9/table.cpuHz;
+  unsigned failures = 0;
+
+  for(int d = 0; d < DELAYS; d++){
+    if(table.nops[d] < 0){
+      printf("%lu,%s missing\n", table.cpuHz, delayNames[d]);
+      return 1;
+    }
+  }
+
+  uint64_t high[2][2] = {{~0ULL, 0}, {~0ULL, 0}};
+  for(size_t p = 0; p < sizeof(patterns)/sizeof(patterns[0]); p++){
+    std::vector<pin_trace_t> pins = simulateLockstep(table, patterns[p], 2);
+    for(uint8_t s = 0; s < 2; s++){
+      pin_trace_t single = simulateSingle(table, patterns[p][s]);
+      if(pins[s].rise.size() != 8 || pins[s].fall.size() != 8){
+        printf("%lu,pattern 0x%02X has %u pulses\n", table.cpuHz, patterns[p][s], (unsigned)pins[s].rise.size());
+        failures++;
+        continue;
+      }
+      for(uint8_t b = 0; b < 8; b++){
+        bool one = patterns[p][s] & (0x80 >> b);
+        uint64_t lockstepHigh = pins[s].fall[b] - pins[s].rise[b];
+        uint64_t singleHigh = single.fall[b] - single.rise[b];
+        if(lockstepHigh < high[one][0]) high[one][0] = lockstepHigh;
+        if(lockstepHigh > high[one][1]) high[one][1] = lockstepHigh;
+        if(lockstepHigh > singleHigh + MATCH_INSTRUCTIONS || singleHigh > lockstepHigh + MATCH_INSTRUCTIONS){
+          printf("%lu,pattern 0x%02X bit %u high %llu instructions, single strip %llu\n", table.cpuHz,
+            patterns[p][s], 7 - b, (unsigned long long)lockstepHigh, (unsigned long long)singleHigh);
+          failures++;
+        }
+      }
+    }
+  }
+
+  double t0h[2] = {high[0][0]*nsPerClock, high[0][1]*nsPerClock};
+  double t1h[2] = {high[1][0]*nsPerClock, high[1][1]*nsPerClock};
+  bool timing = t0h[0] >= T0H_MIN_NS && t0h[1] <= T0H_MAX_NS && t1h[0] >= T1H_MIN_NS && t1h[1] <= T1H_MAX_NS;
+  if(!timing)
+    failures++;
+
+  printf("%lu,%.0f,%.0f,%.0f,%.0f,%s\n", table.cpuHz, t0h[0], t0h[1], t1h[0], t1h[1],
+    (timing && failures == 0) ? "pass" : "FAIL");
+  return failures;
+}
+
+/************************************************************************/
+/*  Finds a file of the repository from the directory of the tool, as   */
+/*  built by the line above, or of this source, so the tool runs from   */
+/*  any working directory                                               */
+/************************************************************************/
+static std::string toolPath(const char *argv0, const char *relative){
+  const char *bases[2] = {argv0, __FILE__};
+  for(int i = 0; i < 2; i++){
+    std::string base(bases[i]);
+    size_t slash = base.rfind('/');
+    std::string path = ((slash == std::string::npos) ? std::string(".") : base.substr(0, slash)) + "/" + relative;
+    FILE *f = fopen(path.c_str(), "r");
+    if(f != NULL){
+      fclose(f);
+      return path;
+    }
+  }
+  return relative;
+}
+
+int main(int argc, char **argv){
+  std::string path = (argc > 1) ? argv[1] : toolPath(argv[0], "../../PICxel.h");
+  std::vector<nop_table_t> tables = readTables(path.c_str());
+  unsigned failures = 0;
+
+  if(tables.empty()){
+    fprintf(stderr, "no nop tables found in %s\n", path.c_str());
+    return 1;
+  }
+
+  printf("cpu_hz,t0h_min_ns,t0h_max_ns,t1h_min_ns,t1h_max_ns,result\n");
+  for(size_t t = 0; t < tables.size(); t++)
+    failures += checkTable(tables[t]);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+/************************************************************************/
+/*  picxel_oc_check.cpp  - PIC32 Neopixel Library host tool             */
+/*                                                                      */
+/*  Checks the duty values PICxelOC sends.  For each peripheral bus     */
+/*  clock the tool runs begin(), turns the zero and one duty values     */
+/*  into high times and checks them against the WS2812 T0H and T1H      */
+/*  windows.  Known byte patterns are then encoded with encodeDuty()    */
+/*  and every duty word is compared with the one expected for its bit,  */
+/*  most significant bit first.  A strip with the OC output set is      */
+/*  refreshed as well, which runs the chunked encoder end to end.       */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -I../host -I../.. -o picxel_oc_check \                    */
+/*      picxel_oc_check.cpp ../../PICxel.cpp \                          */
+/*      ../../PICxelHSVCache.cpp ../../PICxelOC.cpp                     */
+/*  usage:                                                              */
+/*    picxel_oc_check [timer MHz ...]                                   */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <WProgram.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "PICxel.h"
+#include "PICxelOC.h"
+
+//WS2812B high time windows
+#define T0H_MIN_NS 200
+#define T0H_MAX_NS 500
+#define T1H_MIN_NS 550
+#define T1H_MAX_NS 1000
+
+static const uint8_t patterns[] = {0x00, 0xFF, 0xAA, 0x55, 0x80, 0x01, 0x0F, 0xF0, 0x96};
+
+/************************************************************************/
+/*  Checks one bus clock, returns the number of failures                */
+/************************************************************************/
+static unsigned checkClock(uint32_t timerHz){
+  PICxelOC oc(1, 0);
+  unsigned failures = 0;
+
+  if(!oc.begin(timerHz)){
+    printf("%lu,begin refused\n", (unsigned long)timerHz);
+    return 0;
+  }
+
+  uint32_t period = ((uint64_t)timerHz*PICXEL_OC_PERIOD_NS)/1000000000ULL;
+  double tickNs = 1e9/timerHz;
+  double t0h = oc.getZeroDuty()*tickNs;
+  double t1h = oc.getOneDuty()*tickNs;
+  bool timing = t0h >= T0H_MIN_NS && t0h <= T0H_MAX_NS && t1h >= T1H_MIN_NS && t1h <= T1H_MAX_NS &&
+    oc.getOneDuty() < period;
+  if(!timing)
+    failures++;
+
+  //every bit of every pattern, MSB first
+  uint8_t duty[8*sizeof(patterns)];
+  uint32_t words = PICxelOC::encodeDuty(patterns, sizeof(patterns), duty, oc.getZeroDuty(), oc.getOneDuty());
+  unsigned wrong = (words == sizeof(duty)) ? 0 : 1;
+  for(uint32_t i = 0; i < sizeof(duty) && !wrong; i++){
+    bool bit = patterns[i/8] & (0x80 >> (i % 8));
+    if(duty[i] != (bit ? oc.getOneDuty() : oc.getZeroDuty())){
+      printf("%lu,pattern 0x%02X bit %lu has duty %u\n", (unsigned long)timerHz, patterns[i/8],
+        (unsigned long)(7 - i % 8), duty[i]);
+      wrong++;
+    }
+  }
+  failures += wrong;
+
+  printf("%lu,%lu,%u,%u,%.0f,%.0f,%s,%s\n", (unsigned long)timerHz, (unsigned long)period,
+    oc.getZeroDuty(), oc.getOneDuty(), t0h, t1h, timing ? "pass" : "FAIL", wrong ? "FAIL" : "pass");
+  return failures;
+}
+
+int main(int argc, char **argv){
+  static const uint32_t defaultMHz[] = {10, 40, 48, 80, 100, 200};
+  unsigned failures = 0;
+
+  printf("timer_hz,period_ticks,zero_duty,one_duty,t0h_ns,t1h_ns,timing,patterns\n");
+  if(argc > 1){
+    for(int i = 1; i < argc; i++)
+      failures += checkClock(strtoul(argv[i], NULL, 0)*1000000UL);
+  }
+  else{
+    for(uint8_t i = 0; i < sizeof(defaultMHz)/sizeof(defaultMHz[0]); i++)
+      failures += checkClock(defaultMHz[i]*1000000UL);
+  }
+
+  //a strip longer than one duty buffer half, through the output stage
+  PICxel strip(3*PICXEL_OC_CHUNK_LEDS + 1, 0, GRB);
+  PICxelOC oc(1, 0);
+  strip.begin();
+  for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++)
+    strip.GRBsetLEDColor(i, patterns[i % sizeof(patterns)], 0x55, 0xAA);
+  bool refreshed = oc.begin(80000000UL);
+  strip.setOutput(&oc);
+  strip.refreshLEDs();
+  printf("# chunked refresh of %u LEDs %s\n", strip.getNumberOfLEDs(), refreshed ? "ran" : "FAILED");
+  if(!refreshed)
+    failures++;
+
+  return failures ? 1 : 0;
+}
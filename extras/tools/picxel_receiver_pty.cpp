@@ -0,0 +1,243 @@
+/************************************************************************/
+/*  picxel_receiver_pty.cpp  - PIC32 Neopixel Library host tool         */
+/*                                                                      */
+/*  Round trip test of PICxelReceiver over a pseudo terminal.  A writer */
+/*  thread plays the PC: it waits for the Adalight greeting, streams    */
+/*  frames into the master side and the receiver, built with the shim   */
+/*  in extras/host, polls the slave side as it would the serial port.   */
+/*  The last frame must land in the colorArray byte for byte, then a    */
+/*  TPM2 run with one frame missing its end byte must count the error   */
+/*  and leave the power estimate true to the colorArray.  Reports       */
+/*  frames/s and the payload rate.                                      */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -pthread -I../host -I../.. -o picxel_receiver_pty \       */
+/*      picxel_receiver_pty.cpp ../../PICxel.cpp \                      */
+/*      ../../PICxelHSVCache.cpp ../../PICxelReceiver.cpp               */
+/*  usage:                                                              */
+/*    picxel_receiver_pty [LEDs] [frames]                               */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#define _XOPEN_SOURCE 600
+#include <WProgram.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include "PICxel.h"
+#include "PICxelReceiver.h"
+
+/************************************************************************/
+/*  Stream over the slave side of the pty, the board's serial port      */
+/************************************************************************/
+class PtyStream : public Stream{
+public:
+  PtyStream(int fd) : fd(fd){}
+  int available(void){
+    int count = 0;
+    return (ioctl(fd, FIONREAD, &count) == 0) ? count : 0;
+  }
+  int read(void){
+    uint8_t c;
+    return (::read(fd, &c, 1) == 1) ? c : -1;
+  }
+  size_t write(uint8_t c){
+    return (::write(fd, &c, 1) == 1) ? 1 : 0;
+  }
+private:
+  int fd;
+};
+
+static bool writeAll(int fd, const std::vector<uint8_t> &data){
+  size_t done = 0;
+  while(done < data.size()){
+    ssize_t n = write(fd, &data[done], data.size() - done);
+    if(n < 0)
+      return false;
+    done += n;
+  }
+  return true;
+}
+
+//RGB of LED i in frame f, as the PC sends it
+static void frameColor(uint32_t f, uint16_t i, uint8_t rgb[3]){
+  rgb[0] = i*7 + f;
+  rgb[1] = f*3 + 50;
+  rgb[2] = 255 - i;
+}
+
+static std::vector<uint8_t> adalightFrame(uint32_t f, uint16_t leds){
+  std::vector<uint8_t> out;
+  uint8_t hi = (leds - 1) >> 8, lo = leds - 1;
+  out.push_back('A');
+  out.push_back('d');
+  out.push_back('a');
+  out.push_back(hi);
+  out.push_back(lo);
+  out.push_back(hi ^ lo ^ 0x55);
+  for(uint16_t i = 0; i < leds; i++){
+    uint8_t rgb[3];
+    frameColor(f, i, rgb);
+    out.insert(out.end(), rgb, rgb + 3);
+  }
+  return out;
+}
+
+static std::vector<uint8_t> tpm2Frame(uint32_t f, uint16_t leds, bool goodEnd){
+  std::vector<uint8_t> out;
+  uint16_t size = 3*leds;
+  out.push_back(0xC9);
+  out.push_back(0xDA);
+  out.push_back(size >> 8);
+  out.push_back(size);
+  for(uint16_t i = 0; i < leds; i++){
+    uint8_t rgb[3];
+    frameColor(f, i, rgb);
+    out.insert(out.end(), rgb, rgb + 3);
+  }
+  out.push_back(goodEnd ? 0x36 : 0x00);
+  return out;
+}
+
+static bool matchesFrame(PICxel &strip, uint32_t f){
+  const uint8_t *array = strip.getColorArray();
+  for(uint16_t i = 0; i < strip.getNumberOfLEDs(); i++){
+    uint8_t rgb[3];
+    frameColor(f, i, rgb);
+    if(array[3*i] != rgb[1] || array[3*i + 1] != rgb[0] || array[3*i + 2] != rgb[2])
+      return false;
+  }
+  return true;
+}
+
+/************************************************************************/
+/*  Polls until the receiver has counted frames frames and errors       */
+/*  errors, or a second passes with nothing new                         */
+/************************************************************************/
+static bool pollUntil(PICxelReceiver &receiver, uint32_t frames, uint32_t errors){
+  uint32_t lastProgress = millis();
+  uint32_t seen = 0;
+  while(receiver.getFrameCount() < frames || receiver.getErrorCount() < errors){
+    receiver.poll();
+    if(receiver.getFrameCount() + receiver.getErrorCount() != seen){
+      seen = receiver.getFrameCount() + receiver.getErrorCount();
+      lastProgress = millis();
+    }
+    if(millis() - lastProgress > 1000)
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv){
+  uint16_t leds = (argc > 1) ? strtoul(argv[1], NULL, 0) : 150;
+  uint32_t frames = (argc > 2) ? strtoul(argv[2], NULL, 0) : 500;
+  unsigned failures = 0;
+
+  if(leds == 0 || frames < 2){
+    fprintf(stderr, "usage: %s [LEDs] [frames >= 2]\n", argv[0]);
+    return 1;
+  }
+
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if(master < 0 || grantpt(master) != 0 || unlockpt(master) != 0){
+    perror("posix_openpt");
+    return 1;
+  }
+  int slave = open(ptsname(master), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if(slave < 0){
+    perror(ptsname(master));
+    return 1;
+  }
+  struct termios raw;
+  tcgetattr(slave, &raw);
+  cfmakeraw(&raw);
+  tcsetattr(slave, TCSANOW, &raw);
+  tcgetattr(master, &raw);
+  cfmakeraw(&raw);
+  tcsetattr(master, TCSANOW, &raw);
+
+  PtyStream serial(slave);
+  PICxel strip(leds, 0, GRB);
+  strip.begin();
+  strip.setPowerBudget(1000);
+
+  //Adalight: the PC waits for the greeting, then streams
+  PICxelReceiver adalight(strip, serial, ADALIGHT);
+  adalight.setAutoRefresh(false);
+  std::thread pc([&](){
+    char greeting[4];
+    size_t got = 0;
+    while(got < sizeof(greeting)){
+      ssize_t n = read(master, greeting + got, sizeof(greeting) - got);
+      if(n <= 0)
+        return;
+      got += n;
+    }
+    if(memcmp(greeting, "Ada\n", 4) != 0)
+      return;
+    for(uint32_t f = 0; f < frames; f++)
+      writeAll(master, adalightFrame(f, leds));
+  });
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if(!adalight.begin()){
+    printf("adalight begin failed\n");
+    failures++;
+  }
+  bool complete = pollUntil(adalight, frames, 0);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  pc.join();
+
+  printf("adalight,%u frames,%u errors,%s\n", adalight.getFrameCount(), adalight.getErrorCount(),
+    (complete && matchesFrame(strip, frames - 1)) ? "pass" : "FAIL");
+  if(!complete || !matchesFrame(strip, frames - 1) || adalight.getErrorCount() != 0)
+    failures++;
+  printf("adalight,%.0f frames/s,%.2f MB/s payload\n", frames/seconds,
+    frames*3.0*leds/seconds/1e6);
+
+  //TPM2: frame 1 has a bad end byte, frame 2 is good
+  PICxelReceiver tpm2(strip, serial, TPM2);
+  tpm2.setAutoRefresh(false);
+  tpm2.begin();
+  writeAll(master, tpm2Frame(0, leds, true));
+  writeAll(master, tpm2Frame(1, leds, false));
+  complete = pollUntil(tpm2, 1, 1);
+  uint32_t estimate = strip.getPowerEstimate();
+  strip.recomputePowerEstimate();
+  bool sumsKept = complete && estimate == strip.getPowerEstimate();
+  writeAll(master, tpm2Frame(2, leds, true));
+  complete = complete && pollUntil(tpm2, 2, 1);
+
+  printf("tpm2,%u frames,%u errors,%s\n", tpm2.getFrameCount(), tpm2.getErrorCount(),
+    (complete && sumsKept && matchesFrame(strip, 2)) ? "pass" : "FAIL");
+  if(!complete || !sumsKept || !matchesFrame(strip, 2))
+    failures++;
+
+  //the receiver carries RGB and must refuse an HSV strip
+  PICxel hsv(leds, 0, HSV);
+  PICxelReceiver refused(hsv, serial, TPM2);
+  bool accepted = refused.begin();
+  writeAll(master, tpm2Frame(3, leds, true));
+  pollUntil(refused, 1, 0);
+  bool untouched = true;
+  for(uint32_t i = 0; i < 4*(uint32_t)leds; i++)
+    untouched = untouched && hsv.getColorArray()[i] == 0;
+  printf("hsv_refused,%s\n", (!accepted && untouched) ? "pass" : "FAIL");
+  if(accepted || !untouched)
+    failures++;
+
+  close(slave);
+  close(master);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,334 @@
+/************************************************************************/
+/*  picxel_render.cpp  - PIC32 Neopixel Library host tool               */
+/*                                                                      */
+/*  Pre-renders a show on a build machine into the PICxelAnim format.   */
+/*  Every frame is drawn with the library itself, built with the shim   */
+/*  in extras/host: the setters and brightness, PICxelMatrix mapping    */
+/*  and HSVToColor(), which on the host is HSVToColorReference() and    */
+/*  matches the board's assembly bit for bit.  The stored bytes are the */
+/*  ones fillOutputBytes() hands to the wire, so playing the file on a  */
+/*  GRB strip with no index map sends exactly what the board would have */
+/*  rendered live.                                                      */
+/*                                                                      */
+/*  Frames are independent, so they are rendered and then delta encoded */
+/*  on every core.  Each worker starts with its own block of frames and */
+/*  steals from the back of another worker's block when it runs dry.    */
+/*  --scaling renders the show at 1, 2, 4... threads and reports        */
+/*  frames/s for each, checking every run gives the same bytes.         */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -pthread -I../host -I../.. -o picxel_render \             */
+/*      picxel_render.cpp ../../PICxel.cpp ../../PICxelHSVCache.cpp \   */
+/*      ../../PICxelMatrix.cpp                                          */
+/*  usage:                                                              */
+/*    picxel_render <rainbow|chase|plasma> <LEDs|WxH> <frames>          */
+/*      <period ms> <out[.pxa|.h]> [-t threads] [-b brightness]         */
+/*      [--scaling]                                                     */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <WProgram.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <chrono>
+
+#include "PICxel.h"
+#include "PICxelMatrix.h"
+#include "PICxelAnimFormat.h"
+
+enum effect_t {RAINBOW, CHASE, PLASMA};
+
+struct show_t{
+  effect_t effect;
+  uint16_t numLEDs;
+  uint16_t width;
+  uint16_t height;
+  uint8_t brightness;
+};
+
+/************************************************************************/
+/*  Effects.  Integer only, so the board computes the same colors.      */
+/************************************************************************/
+static uint32_t triangle(uint32_t x){
+  x &= 511;
+  return (x < 256) ? x : 511 - x;
+}
+
+static void renderFrame(const show_t &show, uint32_t frame, PICxel &strip, PICxelMatrix *matrix){
+  switch(show.effect){
+    case RAINBOW:
+      for(uint16_t i = 0; i < show.numLEDs; i++)
+        strip.HSVsetLEDColor(i, (i*4 + frame*8) % 1536, 255, 255);
+      break;
+
+    case CHASE:{
+      strip.clear();
+      uint16_t head = frame % show.numLEDs;
+      for(uint16_t tail = 0; tail < 16 && tail <= head; tail++){
+        uint8_t level = 255 >> (tail/2);
+        strip.GRBsetLEDColor(head - tail, level, level/4, 0);
+      }
+      break;
+    }
+
+    case PLASMA:
+      for(uint16_t y = 0; y < show.height; y++){
+        for(uint16_t x = 0; x < show.width; x++){
+          uint32_t hue = (triangle(x*16 + frame*4) + triangle(y*16 + frame*3) +
+            triangle((x + y)*8 + frame*5))*2 % 1536;
+          //HSVToColorReference() gives 0x00RRGGBB, the layout setPixel() takes
+          matrix->setPixel(x, y, PICxel::HSVToColorReference(hue | 0xFFFF0000));
+        }
+      }
+      break;
+  }
+}
+
+/************************************************************************/
+/*  Work stealing scheduler.  Tasks are indexes 0..count-1 split into   */
+/*  one contiguous block per worker.  A worker takes from the front of  */
+/*  its own queue, which keeps neighbouring frames on one core, and     */
+/*  steals from the back of the others.                                 */
+/************************************************************************/
+struct work_queue_t{
+  std::mutex lock;
+  std::deque<uint32_t> tasks;
+};
+
+template<typename FUNC>
+static void runParallel(uint32_t count, uint32_t threads, FUNC func){
+  std::vector<work_queue_t> queues(threads);
+  std::vector<std::thread> workers;
+
+  for(uint32_t t = 0; t < threads; t++){
+    for(uint32_t i = count*t/threads; i < count*(t + 1)/threads; i++)
+      queues[t].tasks.push_back(i);
+  }
+
+  for(uint32_t t = 0; t < threads; t++){
+    workers.push_back(std::thread([&queues, &func, t, threads](){
+      while(true){
+        bool found = false;
+        uint32_t task = 0;
+
+        for(uint32_t k = 0; k < threads && !found; k++){
+          work_queue_t &queue = queues[(t + k) % threads];
+          std::lock_guard<std::mutex> guard(queue.lock);
+          if(queue.tasks.empty())
+            continue;
+          if(k == 0){
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+          }
+          else{
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+          }
+          found = true;
+        }
+
+        //no task is ever added, so one empty scan means done
+        if(!found)
+          return;
+        func(t, task);
+      }
+    }));
+  }
+
+  for(uint32_t t = 0; t < threads; t++)
+    workers[t].join();
+}
+
+/************************************************************************/
+/*  Renders every frame into frames, frameSize bytes each               */
+/************************************************************************/
+static void renderShow(const show_t &show, uint32_t numFrames, uint32_t threads,
+  std::vector<uint8_t> &frames){
+  uint32_t frameSize = 3*(uint32_t)show.numLEDs;
+  std::vector<PICxel*> strips(threads);
+  std::vector<PICxelMatrix*> matrices(threads, (PICxelMatrix*)NULL);
+
+  frames.assign((size_t)frameSize*numFrames, 0);
+
+  for(uint32_t t = 0; t < threads; t++){
+    strips[t] = new PICxel(show.numLEDs, 0, (show.effect == RAINBOW) ? HSV : GRB);
+    strips[t]->setBrightness(show.brightness);
+    if(show.effect == PLASMA)
+      matrices[t] = new PICxelMatrix(*strips[t], show.width, show.height, SERPENTINE);
+  }
+
+  runParallel(numFrames, threads, [&](uint32_t t, uint32_t frame){
+    renderFrame(show, frame, *strips[t], matrices[t]);
+    strips[t]->fillOutputBytes(&frames[(size_t)frame*frameSize], 0, show.numLEDs);
+  });
+
+  for(uint32_t t = 0; t < threads; t++){
+    delete matrices[t];
+    delete strips[t];
+  }
+}
+
+/************************************************************************/
+/*  Delta encodes every frame against the one before it in parallel and */
+/*  joins the results behind the file header                            */
+/************************************************************************/
+static void encodeShow(const show_t &show, uint32_t numFrames, uint16_t periodMs,
+  uint32_t threads, const std::vector<uint8_t> &frames, std::vector<uint8_t> &out){
+  uint32_t frameSize = 3*(uint32_t)show.numLEDs;
+  std::vector<uint8_t> blank(frameSize, 0);
+  std::vector<std::vector<uint8_t> > encoded(numFrames);
+
+  runParallel(numFrames, threads, [&](uint32_t, uint32_t frame){
+    const uint8_t *prev = frame ? &frames[(size_t)(frame - 1)*frameSize] : &blank[0];
+    encoded[frame].resize(show.numLEDs*4 + 1);
+    uint32_t len = PXAencodeFrame(prev, &frames[(size_t)frame*frameSize], show.numLEDs, 3,
+      &encoded[frame][0]);
+    encoded[frame].resize(len);
+  });
+
+  out.assign(PXA_HEADER_SIZE, 0);
+  PXAwriteHeader(&out[0], show.numLEDs, 3, numFrames, periodMs);
+  for(uint32_t f = 0; f < numFrames; f++)
+    out.insert(out.end(), encoded[f].begin(), encoded[f].end());
+}
+
+static bool writeHeaderFile(const char *path, const std::vector<uint8_t> &out){
+  std::string name(path);
+  size_t slash = name.find_last_of("/\\");
+  if(slash != std::string::npos)
+    name = name.substr(slash + 1);
+  name = name.substr(0, name.size() - 2);
+  for(size_t i = 0; i < name.size(); i++)
+    if(!isalnum((unsigned char)name[i]))
+      name[i] = '_';
+
+  FILE *f = fopen(path, "w");
+  if(f == NULL)
+    return false;
+  fprintf(f, "// generated by picxel_render\n");
+  fprintf(f, "const uint8_t %s[%u] = {", name.c_str(), (unsigned)out.size());
+  for(size_t i = 0; i < out.size(); i++)
+    fprintf(f, "%s0x%02X,", (i % 16) ? " " : "\n  ", out[i]);
+  fprintf(f, "\n};\n");
+  fclose(f);
+  return true;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start){
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv){
+  if(argc < 6){
+    fprintf(stderr, "usage: %s <rainbow|chase|plasma> <LEDs|WxH> <frames> <period ms> "
+      "<out[.pxa|.h]> [-t threads] [-b brightness] [--scaling]\n", argv[0]);
+    return 1;
+  }
+
+  show_t show;
+  uint32_t threads = std::thread::hardware_concurrency();
+  bool scaling = false;
+
+  if(strcmp(argv[1], "rainbow") == 0)
+    show.effect = RAINBOW;
+  else if(strcmp(argv[1], "chase") == 0)
+    show.effect = CHASE;
+  else if(strcmp(argv[1], "plasma") == 0)
+    show.effect = PLASMA;
+  else{
+    fprintf(stderr, "unknown effect %s\n", argv[1]);
+    return 1;
+  }
+
+  unsigned long width = 0, height = 1;
+  char *end;
+  width = strtoul(argv[2], &end, 0);
+  if(*end == 'x')
+    height = strtoul(end + 1, NULL, 0);
+  uint32_t numFrames = strtoul(argv[3], NULL, 0);
+  uint32_t periodMs = strtoul(argv[4], NULL, 0);
+  show.width = width;
+  show.height = height;
+  show.numLEDs = width*height;
+  show.brightness = 255;
+
+  for(int i = 6; i < argc; i++){
+    if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+      threads = strtoul(argv[++i], NULL, 0);
+    else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+      show.brightness = strtoul(argv[++i], NULL, 0);
+    else if(strcmp(argv[i], "--scaling") == 0)
+      scaling = true;
+  }
+
+  if(width*height == 0 || width*height > 0xFFFF || numFrames == 0 || numFrames > 0xFFFF ||
+    periodMs > 0xFFFF){
+    fprintf(stderr, "invalid LED count, frame count or period\n");
+    return 1;
+  }
+  if(show.effect == PLASMA && height < 2){
+    fprintf(stderr, "plasma needs a WxH matrix\n");
+    return 1;
+  }
+  if(threads == 0)
+    threads = 1;
+
+  std::vector<uint8_t> frames;
+  std::vector<uint8_t> out;
+
+  if(scaling){
+    std::vector<uint8_t> reference;
+    printf("threads,frames_per_s,speedup\n");
+    double base = 0;
+    for(uint32_t t = 1; t <= threads; t *= 2){
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      renderShow(show, numFrames, t, frames);
+      double fps = numFrames/secondsSince(start);
+      if(t == 1){
+        base = fps;
+        reference = frames;
+      }
+      else if(frames != reference){
+        fprintf(stderr, "%u threads rendered different frames\n", t);
+        return 1;
+      }
+      printf("%u,%.1f,%.2f\n", t, fps, fps/base);
+      if(t < threads && t*2 > threads)
+        t = threads/2;
+    }
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  renderShow(show, numFrames, threads, frames);
+  double renderSeconds = secondsSince(start);
+  encodeShow(show, numFrames, periodMs, threads, frames, out);
+
+  std::string outPath(argv[5]);
+  bool ok;
+  if(outPath.size() > 2 && outPath.compare(outPath.size() - 2, 2, ".h") == 0){
+    ok = writeHeaderFile(argv[5], out);
+  }
+  else{
+    FILE *f = fopen(argv[5], "wb");
+    ok = (f != NULL) && fwrite(&out[0], 1, out.size(), f) == out.size();
+    if(f != NULL)
+      fclose(f);
+  }
+  if(!ok){
+    perror(argv[5]);
+    return 1;
+  }
+
+  fprintf(stderr, "%u frames on %u threads, %.1f frames/s, %u raw bytes -> %u bytes\n",
+    numFrames, threads, numFrames/renderSeconds, (unsigned)frames.size(), (unsigned)out.size());
+  return 0;
+}
@@ -0,0 +1,164 @@
+/************************************************************************/
+/*  picxel_spectrum_wav.cpp  - PIC32 Neopixel Library host tool         */
+/*                                                                      */
+/*  Runs PICxelSpectrum on a WAV file with the shim in extras/host, in  */
+/*  place of the ADC, and reports the cost per block against the time   */
+/*  a block of samples lasts.  16-bit PCM, channels are mixed to mono.  */
+/*  --levels also prints the band levels of every block.                */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -I../host -I../.. -o picxel_spectrum_wav \                */
+/*      picxel_spectrum_wav.cpp ../../PICxel.cpp \                      */
+/*      ../../PICxelHSVCache.cpp ../../PICxelSpectrum.cpp               */
+/*  usage:                                                              */
+/*    picxel_spectrum_wav <in.wav> [LEDs] [bands] [--levels]            */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <WProgram.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "PICxel.h"
+#include "PICxelSpectrum.h"
+
+static uint32_t read32(const uint8_t *p){
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t read16(const uint8_t *p){
+  return p[0] | p[1] << 8;
+}
+
+/************************************************************************/
+/*  Reads a 16-bit PCM WAV file into mono samples                       */
+/************************************************************************/
+static bool readWav(const char *path, std::vector<int16_t> &samples, uint32_t &rate){
+  FILE *f = fopen(path, "rb");
+  if(f == NULL){
+    perror(path);
+    return false;
+  }
+  std::vector<uint8_t> file;
+  uint8_t chunk[4096];
+  size_t n;
+  while((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    file.insert(file.end(), chunk, chunk + n);
+  fclose(f);
+
+  if(file.size() < 12 || memcmp(&file[0], "RIFF", 4) || memcmp(&file[8], "WAVE", 4)){
+    fprintf(stderr, "%s: not a WAV file\n", path);
+    return false;
+  }
+
+  uint16_t channels = 0, bits = 0;
+  size_t position = 12;
+  while(position + 8 <= file.size()){
+    uint32_t size = read32(&file[position + 4]);
+    const uint8_t *body = &file[position + 8];
+    if(position + 8 + size > file.size())
+      size = file.size() - position - 8;
+
+    if(memcmp(&file[position], "fmt ", 4) == 0 && size >= 16){
+      if(read16(body) != 1){
+        fprintf(stderr, "%s: only PCM is supported\n", path);
+        return false;
+      }
+      channels = read16(body + 2);
+      rate = read32(body + 4);
+      bits = read16(body + 14);
+    }
+    else if(memcmp(&file[position], "data", 4) == 0){
+      if(channels == 0 || bits != 16){
+        fprintf(stderr, "%s: only 16-bit PCM is supported\n", path);
+        return false;
+      }
+      for(uint32_t i = 0; i + 2*channels <= size; i += 2*channels){
+        int32_t sum = 0;
+        for(uint16_t c = 0; c < channels; c++)
+          sum += (int16_t)read16(body + i + 2*c);
+        samples.push_back(sum/channels);
+      }
+      return true;
+    }
+    position += 8 + size + (size & 1);
+  }
+  fprintf(stderr, "%s: no data chunk\n", path);
+  return false;
+}
+
+int main(int argc, char **argv){
+  bool printLevels = false;
+  std::vector<const char*> args;
+
+  for(int i = 1; i < argc; i++){
+    if(strcmp(argv[i], "--levels") == 0)
+      printLevels = true;
+    else
+      args.push_back(argv[i]);
+  }
+  if(args.empty()){
+    fprintf(stderr, "usage: %s <in.wav> [LEDs] [bands] [--levels]\n", argv[0]);
+    return 1;
+  }
+
+  uint16_t leds = (args.size() > 1) ? strtoul(args[1], NULL, 0) : 60;
+  uint8_t bands = (args.size() > 2) ? strtoul(args[2], NULL, 0) : 12;
+  std::vector<int16_t> samples;
+  uint32_t rate = 0;
+
+  if(leds == 0 || !readWav(args[0], samples, rate))
+    return 1;
+
+  PICxel strip(leds, 0, GRB);
+  strip.begin();
+  PICxelSpectrum spectrum(strip, bands);
+  std::vector<uint8_t> wire(3*(uint32_t)leds);
+
+  uint64_t blockTicks = 0, fftTicks = 0;
+  uint32_t blocks = 0;
+
+  if(printLevels){
+    printf("block");
+    for(uint8_t b = 0; b < spectrum.getBands(); b++)
+      printf(",%uHz", (unsigned)(spectrum.getBandStart(b)*(uint64_t)rate/PICXEL_SPECTRUM_SIZE));
+    printf("\n");
+  }
+
+  //one hop at a time, as poll() hands over each half of the DMA ring
+  for(size_t offset = 0; offset + PICXEL_SPECTRUM_HOP <= samples.size(); offset += PICXEL_SPECTRUM_HOP){
+    if(spectrum.pushSamples(&samples[offset], PICXEL_SPECTRUM_HOP) == 0)
+      continue;
+    blockTicks += spectrum.getLastBlockTicks();
+    fftTicks += spectrum.getLastFFTTicks();
+    blocks++;
+    strip.fillOutputBytes(&wire[0], 0, leds);
+
+    if(printLevels){
+      printf("%u", blocks - 1);
+      for(uint8_t b = 0; b < spectrum.getBands(); b++)
+        printf(",%u", spectrum.getLevel(b));
+      printf("\n");
+    }
+  }
+
+  if(blocks == 0){
+    fprintf(stderr, "%s: shorter than one block\n", args[0]);
+    return 1;
+  }
+
+  double nsPerTick = 2e9/F_CPU;
+  double hopNs = PICXEL_SPECTRUM_HOP*1e9/rate;
+  double blockNs = blockTicks*nsPerTick/blocks;
+  printf("# %u Hz, %u point FFT, hop %u samples (%.0f us)\n", rate, PICXEL_SPECTRUM_SIZE,
+    PICXEL_SPECTRUM_HOP, hopNs/1000);
+  printf("blocks,leds,bands,fft_ns_per_block,ns_per_block,max_ns_per_block,load_percent\n");
+  printf("%u,%u,%u,%.0f,%.0f,%.0f,%.2f\n", blocks, leds, spectrum.getBands(),
+    fftTicks*nsPerTick/blocks, blockNs, spectrum.getMaxBlockTicks()*nsPerTick,
+    100*blockNs/hopNs);
+  return 0;
+}
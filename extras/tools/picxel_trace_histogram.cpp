@@ -0,0 +1,177 @@
+/************************************************************************/
+/*  picxel_trace_histogram.cpp  - PIC32 Neopixel Library host tool      */
+/*                                                                      */
+/*  Turns a PICxelTraceDump() capture into latency histograms.  Events  */
+/*  are paired in the order they were recorded:                         */
+/*    input to photon   FRAME_START    -> next LAST_BIT                 */
+/*    received to photon FRAME_RECEIVED -> next LAST_BIT                */
+/*    render            RENDER_START   -> RENDER_END                    */
+/*    refresh           REFRESH_START  -> LAST_BIT                      */
+/*    interrupts off    IRQ_OFF        -> IRQ_ON                        */
+/*  A frame received while an earlier one is still waiting to be shown  */
+/*  replaces it, the earlier one is counted as dropped.                 */
+/*                                                                      */
+/*  build (from extras/tools):                                          */
+/*    g++ -O2 -o picxel_trace_histogram picxel_trace_histogram.cpp      */
+/*  usage:                                                              */
+/*    picxel_trace_histogram [capture] [buckets]                        */
+/*  with no capture file the dump is read from stdin.                   */
+/*                                                                      */
+/*  This library is protected under the GNU GPL v3.0 license            */
+/*  http://www.gnu.org/licenses/                                        */
+/************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+enum {FRAME_START, FRAME_RECEIVED, RENDER_START, RENDER_END, REFRESH_START,
+  IRQ_OFF, LAST_BIT, IRQ_ON, EVENT_COUNT};
+
+static const char *const eventNames[EVENT_COUNT] = {"FRAME_START", "FRAME_RECEIVED",
+  "RENDER_START", "RENDER_END", "REFRESH_START", "IRQ_OFF", "LAST_BIT", "IRQ_ON"};
+
+enum {INPUT_TO_PHOTON, RECEIVED_TO_PHOTON, RENDER, REFRESH, INTERRUPTS_OFF,
+  SPAN_COUNT};
+
+static const char *const spanNames[SPAN_COUNT] = {"input to photon",
+  "received to photon", "render", "refresh", "interrupts off"};
+
+static int eventIndex(const char *name){
+  for(int i = 0; i < EVENT_COUNT; i++){
+    if(strcmp(name, eventNames[i]) == 0)
+      return i;
+  }
+  //a sketch's own events are dumped as numbers
+  return -1;
+}
+
+static void printHistogram(const char *name, std::vector<double> &us, int buckets){
+  printf("%s: %u samples\n", name, (unsigned)us.size());
+  if(us.empty()){
+    printf("\n");
+    return;
+  }
+
+  std::sort(us.begin(), us.end());
+  double low = us.front();
+  double high = us.back();
+  printf("  min %.1f  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f us\n", low,
+    us[us.size()/2], us[us.size()*9/10], us[us.size()*99/100], high);
+
+  double width = (high - low)/buckets;
+  if(width <= 0){
+    printf("\n");
+    return;
+  }
+  std::vector<unsigned> counts(buckets, 0);
+  unsigned most = 0;
+  for(size_t i = 0; i < us.size(); i++){
+    int b = (int)((us[i] - low)/width);
+    if(b >= buckets)
+      b = buckets - 1;
+    counts[b]++;
+  }
+  for(int b = 0; b < buckets; b++)
+    most = std::max(most, counts[b]);
+  for(int b = 0; b < buckets; b++){
+    printf("  %10.1f - %10.1f us %6u ", low + b*width, low + (b + 1)*width, counts[b]);
+    for(unsigned n = 0; n < counts[b]*40/most; n++)
+      putchar('#');
+    putchar('\n');
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv){
+  FILE *in = stdin;
+  int buckets = (argc > 2) ? atoi(argv[2]) : 10;
+  if(argc > 1 && strcmp(argv[1], "-") != 0){
+    in = fopen(argv[1], "r");
+    if(in == NULL){
+      perror(argv[1]);
+      return 1;
+    }
+  }
+  if(buckets < 1)
+    buckets = 1;
+
+  double cpuHz = 80000000.0;
+  char line[256];
+  std::vector<double> spans[SPAN_COUNT];
+  uint32_t open[EVENT_COUNT];
+  uint32_t frameStart = 0;
+  bool isOpen[EVENT_COUNT] = {false};
+  unsigned dropped = 0;
+  unsigned events = 0;
+
+  while(fgets(line, sizeof(line), in) != NULL){
+    unsigned long hz;
+    if(sscanf(line, "# PICxel trace, F_CPU %lu", &hz) == 1){
+      cpuHz = hz;
+      continue;
+    }
+
+    unsigned long ticks, arg;
+    char name[32];
+    if(sscanf(line, "%lu,%31[^,],%lu", &ticks, name, &arg) != 3)
+      continue;
+    int event = eventIndex(name);
+    if(event < 0)
+      continue;
+    events++;
+
+    //the core timer runs at F_CPU/2 and wraps, unsigned differences are fine
+    uint32_t now = (uint32_t)ticks;
+    double usPerTick = 2e6/cpuHz;
+
+    switch(event){
+      case FRAME_START:
+        frameStart = now;
+        break;
+      case FRAME_RECEIVED:
+        //two complete frames without a refresh, the older is never shown
+        if(isOpen[FRAME_RECEIVED])
+          dropped++;
+        open[FRAME_START] = frameStart;
+        //fall through
+      case RENDER_START:
+      case REFRESH_START:
+      case IRQ_OFF:
+        open[event] = now;
+        isOpen[event] = true;
+        break;
+      case RENDER_END:
+        if(isOpen[RENDER_START])
+          spans[RENDER].push_back((uint32_t)(now - open[RENDER_START])*usPerTick);
+        isOpen[RENDER_START] = false;
+        break;
+      case IRQ_ON:
+        if(isOpen[IRQ_OFF])
+          spans[INTERRUPTS_OFF].push_back((uint32_t)(now - open[IRQ_OFF])*usPerTick);
+        isOpen[IRQ_OFF] = false;
+        break;
+      case LAST_BIT:
+        if(isOpen[FRAME_RECEIVED]){
+          spans[INPUT_TO_PHOTON].push_back((uint32_t)(now - open[FRAME_START])*usPerTick);
+          spans[RECEIVED_TO_PHOTON].push_back((uint32_t)(now - open[FRAME_RECEIVED])*usPerTick);
+        }
+        if(isOpen[REFRESH_START])
+          spans[REFRESH].push_back((uint32_t)(now - open[REFRESH_START])*usPerTick);
+        isOpen[FRAME_RECEIVED] = false;
+        isOpen[REFRESH_START] = false;
+        break;
+    }
+  }
+  if(in != stdin)
+    fclose(in);
+
+  printf("%u events at F_CPU %.0f, %u frames dropped before display\n\n",
+    events, cpuHz, dropped);
+  for(int s = 0; s < SPAN_COUNT; s++)
+    printHistogram(spanNames[s], spans[s], buckets);
+  return events ? 0 : 1;
+}